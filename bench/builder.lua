@@ -0,0 +1,62 @@
+-- Compares building a document with cmark.builder against parsing the
+-- equivalent Markdown.
+--
+-- Usage: lua bench/builder.lua [sections]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+local b = require 'cmark.builder'
+
+local sections = tonumber(arg and arg[1]) or 20000
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").
+
+- a bullet item
+- another item with `code`
+
+]]
+
+local function section()
+  return {
+    b.heading{ level = 2, "Section heading with ", b.code "code" },
+    b.paragraph{ "A paragraph with ", b.emph "emphasis", ", ",
+                 b.strong "strong emphasis", ", ", b.code "inline code",
+                 " and a", b.softbreak,
+                 b.link{ url = "http://example.com/path", title = "title",
+                         "link" }, "." },
+    b.bullet_list{ tight = true, "a bullet item",
+                   b.paragraph{ "another item with ", b.code "code" } },
+  }
+end
+
+local function measure(name, build)
+  collectgarbage()
+  local start = os.clock()
+  local doc = build()
+  local elapsed = os.clock() - start
+  print(string.format("%-10s %8.3f s", name, elapsed))
+  return doc
+end
+
+for _ = 1, 2 do
+  local built = measure("builder", function()
+    local blocks = {}
+    for i = 1, sections do
+      blocks[i] = section()
+    end
+    return b.document(blocks)
+  end)
+  local parsed = measure("parse", function()
+    return cmark.parse_string(string.rep(sample, sections), cmark.OPT_DEFAULT)
+  end)
+  assert(cmark.render_html(built, cmark.OPT_DEFAULT) ==
+         cmark.render_html(parsed, cmark.OPT_DEFAULT))
+  cmark.node_free(built)
+  cmark.node_free(parsed)
+end
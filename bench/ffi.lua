@@ -0,0 +1,79 @@
+-- Compares the SWIG binding (cmark) with the FFI binding (cmark.ffi):
+-- a walk that counts links, and a walk that reads the attributes of
+-- every node.  Needs LuaJIT; with other Lua versions, only the SWIG
+-- binding is measured.
+--
+-- Usage: luajit bench/ffi.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local megabytes = tonumber(arg and arg[1]) or 4
+
+local bindings = { { "cmark", require 'cmark' } }
+if pcall(require, 'ffi') then
+  bindings[#bindings + 1] = { "cmark.ffi", require 'cmark.ffi' }
+end
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function count_links(cmark, doc)
+  local links = 0
+  for _, entering, node_type in cmark.walk(doc) do
+    if entering and node_type == cmark.NODE_LINK then
+      links = links + 1
+    end
+  end
+  return links
+end
+
+local function read_attributes(cmark, doc)
+  local bytes = 0
+  for cur, entering, node_type in cmark.walk(doc) do
+    if entering then
+      local s = cmark.node_get_start_line(cur) + cmark.node_get_end_column(cur)
+      if node_type == cmark.NODE_TEXT or node_type == cmark.NODE_CODE then
+        bytes = bytes + #cmark.node_get_literal(cur)
+      elseif node_type == cmark.NODE_LINK then
+        bytes = bytes + #cmark.node_get_url(cur) + #cmark.node_get_title(cur)
+      elseif node_type == cmark.NODE_HEADING then
+        bytes = bytes + cmark.node_get_heading_level(cur)
+      end
+      bytes = bytes + s % 2
+    end
+  end
+  return bytes
+end
+
+local function measure(name, cmark, f)
+  local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+  collectgarbage()
+  local start = os.clock()
+  local result = f(cmark, doc)
+  local elapsed = os.clock() - start
+  print(string.format("%-28s %8.3f s  %d", name, elapsed, result))
+  cmark.node_free(doc)
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  for _, binding in ipairs(bindings) do
+    measure(binding[1] .. " walk", binding[2], count_links)
+    measure(binding[1] .. " attributes", binding[2], read_attributes)
+  end
+end
@@ -0,0 +1,89 @@
+-- Compares adding a class to every link by rewriting the tree with
+-- cmark.walk (replacing links with custom inlines) against
+-- cmark.render_html_with_hooks.
+--
+-- Usage: lua bench/hooks.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function open_tag(node)
+  return '<a class="ext" href="' .. cmark.node_get_url(node) .. '">'
+end
+
+local function walk_and_render(s)
+  local doc = cmark.parse_string(s, cmark.OPT_DEFAULT)
+  local links = {}
+  for cur, entering, node_type in cmark.walk(doc) do
+    if not entering and node_type == cmark.NODE_LINK then
+      links[#links + 1] = cur
+    end
+  end
+  for _, link in ipairs(links) do
+    local custom = cmark.node_new(cmark.NODE_CUSTOM_INLINE)
+    cmark.node_set_on_enter(custom, open_tag(link))
+    cmark.node_set_on_exit(custom, "</a>")
+    local child = cmark.node_first_child(link)
+    while child do
+      local next = cmark.node_next(child)
+      cmark.node_append_child(custom, child)
+      child = next
+    end
+    cmark.node_replace(link, custom)
+    cmark.node_free(link)
+  end
+  local html = cmark.render_html(doc, cmark.OPT_DEFAULT)
+  cmark.node_free(doc)
+  return html
+end
+
+local hooks = {
+  [cmark.NODE_LINK] = function(node, entering)
+    return entering and open_tag(node) or "</a>"
+  end,
+}
+
+local function render_with_hooks(s)
+  local doc = cmark.parse_string(s, cmark.OPT_DEFAULT)
+  local html = cmark.render_html_with_hooks(doc, cmark.OPT_DEFAULT, hooks)
+  cmark.node_free(doc)
+  return html
+end
+
+local function measure(name, render)
+  collectgarbage()
+  local start = os.clock()
+  local html = render(input)
+  local elapsed = os.clock() - start
+  print(string.format("%-24s %8.3f s  %8.1f MB/s", name, elapsed,
+                      #input / (1024 * 1024) / elapsed))
+  return html
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  local a = measure("walk + custom inlines", walk_and_render)
+  local b = measure("render_html_with_hooks", render_with_hooks)
+  assert(a == b)
+end
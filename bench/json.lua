@@ -0,0 +1,72 @@
+-- Compares getting the syntax tree out as XML with cmark.render_xml
+-- against JSON with cmark.render_json.  If LuaExpat (lxp) and lua-cjson
+-- are installed, the time to parse the output is included.
+--
+-- Usage: lua bench/json.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 8
+
+local has_lxp, lxp = pcall(require, 'lxp')
+local has_cjson, cjson = pcall(require, 'cjson')
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and has "quotes" & <brackets>
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+```lua
+local function f(x)
+  return x * 2
+end
+```
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+
+local function parse_xml(s)
+  local parser = lxp.new({})
+  parser:parse(s)
+  parser:parse()
+  parser:close()
+end
+
+local function measure(name, render, parse)
+  collectgarbage()
+  local start = os.clock()
+  local out = render(doc, cmark.OPT_SOURCEPOS)
+  if parse then
+    parse(out)
+  end
+  local elapsed = os.clock() - start
+  print(string.format("%-24s %8.3f s  %8.1f MB output", name, elapsed,
+                      #out / (1024 * 1024)))
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  measure("render_xml", cmark.render_xml)
+  measure("render_json", cmark.render_json)
+  if has_lxp then
+    measure("render_xml + lxp", cmark.render_xml, parse_xml)
+  end
+  if has_cjson then
+    measure("render_json + cjson", cmark.render_json, cjson.decode)
+  end
+end
+
+cmark.node_free(doc)
@@ -0,0 +1,71 @@
+-- Measures what resource limits cost on ordinary input, and what they
+-- save on inputs crafted to be slow: deeply nested block quotes and
+-- lists, and long runs of brackets and emphasis delimiters.
+--
+-- Usage: lua bench/limits.lua [megabytes] [runs]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+local runs = tonumber(arg and arg[2]) or 5
+
+local limits = {
+  max_depth = 32,
+  max_nodes = 10000000,
+  max_delimiters = 1000,
+  max_output = 1024 * 1024 * 1024,
+  max_time = 60,
+}
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local function nested_list(depth)
+  local lines = {}
+  for i = 1, depth do
+    lines[i] = string.rep(" ", 2 * (i - 1)) .. "- a\n"
+  end
+  return table.concat(lines)
+end
+
+local function measure(name, input)
+  local best = { math.huge, math.huge }
+  for _ = 1, runs do
+    for i, parse in ipairs({
+        function() return cmark.parse_string(input, cmark.OPT_DEFAULT) end,
+        function()
+          return cmark.parse_string_with_limits(input, cmark.OPT_DEFAULT,
+                                                limits)
+        end }) do
+      collectgarbage()
+      local start = os.clock()
+      local doc = parse()
+      cmark.render_html(doc, cmark.OPT_DEFAULT)
+      cmark.node_free(doc)
+      best[i] = math.min(best[i], os.clock() - start)
+    end
+  end
+  print(string.format("%-22s %8.3f s %8.3f s", name, best[1], best[2]))
+end
+
+print(string.format("best of %d runs         no limits   limits", runs))
+measure(string.format("sample (%.1f MB)", megabytes),
+        string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample)))
+measure("nested block quotes", string.rep(string.rep("> ", 2000) .. "a\n", 2000))
+measure("nested lists", nested_list(1500))
+measure("open brackets", string.rep("[a", 200000) .. string.rep("]", 10))
+measure("emphasis delimiters", string.rep("*a _b ", 200000) .. "\n")
@@ -0,0 +1,65 @@
+-- Measures the cost of parsing and rendering through a memory account
+-- against the default allocator, and prints the allocations by phase.
+--
+-- Usage: lua bench/mem_account.lua [megabytes] [runs]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+local runs = tonumber(arg and arg[2]) or 5
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function measure(name, parse)
+  local best = math.huge
+  for _ = 1, runs do
+    collectgarbage()
+    local start = os.clock()
+    local doc = parse()
+    cmark.render_html(doc, cmark.OPT_DEFAULT)
+    cmark.node_free(doc)
+    best = math.min(best, os.clock() - start)
+  end
+  print(string.format("%-20s %8.3f s", name, best))
+end
+
+print(string.format("input: %.1f MB, best of %d runs", #input / (1024 * 1024),
+                    runs))
+
+measure("default allocator", function()
+  return cmark.parse_string(input, cmark.OPT_DEFAULT)
+end)
+local account = cmark.mem_account_new(0)
+local mem = cmark.mem_account_get_mem(account)
+measure("memory account", function()
+  return cmark.parse_string_with_mem(input, cmark.OPT_DEFAULT, mem)
+end)
+
+local usage = cmark.mem_account_get_usage(account)
+print()
+print(string.format("peak %.1f MB; per run:", usage.peak / (1024 * 1024)))
+for _, phase in ipairs({ "parse", "inlines", "render" }) do
+  local p = usage[phase]
+  print(string.format("%-8s %10d allocations %8d reallocations %8.1f MB",
+                      phase, math.floor(p.allocations / runs),
+                      math.floor(p.reallocations / runs),
+                      p.bytes / runs / (1024 * 1024)))
+end
+cmark.mem_account_free(account)
@@ -0,0 +1,79 @@
+-- Compares building a table of contents with cmark.parse_string and
+-- cmark.walk against cmark.extract_outline.
+--
+-- Usage: lua bench/outline.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 16
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+### A *smaller* heading
+
+> A block quote
+> spanning two lines.
+
+```lua
+local function f(x)
+  return x * 2
+end
+```
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function walk_outline(s)
+  local doc = cmark.parse_string(s, cmark.OPT_DEFAULT)
+  local outline = {}
+  local heading, text
+  for cur, entering, node_type in cmark.walk(doc) do
+    if node_type == cmark.NODE_HEADING then
+      if entering then
+        heading, text = cur, {}
+      else
+        outline[#outline + 1] = {
+          level = cmark.node_get_heading_level(heading),
+          text = table.concat(text),
+          start_line = cmark.node_get_start_line(heading),
+        }
+        heading = nil
+      end
+    elseif heading and entering and (node_type == cmark.NODE_TEXT or
+                                     node_type == cmark.NODE_CODE) then
+      text[#text + 1] = cmark.node_get_literal(cur)
+    end
+  end
+  cmark.node_free(doc)
+  return outline
+end
+
+local function measure(name, extract)
+  collectgarbage()
+  local start = os.clock()
+  local outline = extract(input)
+  local elapsed = os.clock() - start
+  print(string.format("%-28s %8.3f s  %8.1f MB/s  %d headings", name,
+                      elapsed, #input / (1024 * 1024) / elapsed, #outline))
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  measure("parse_string + walk", walk_outline)
+  measure("extract_outline", cmark.extract_outline)
+end
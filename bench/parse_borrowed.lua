@@ -0,0 +1,61 @@
+-- Compares the memory taken by a document parsed with
+-- cmark.parse_string and with cmark.parse_string_borrowed, measured as
+-- the growth of the resident set size (Linux only).  Both documents
+-- are kept until the end, so that the second does not reuse memory
+-- freed by the first.
+--
+-- Usage: lua bench/parse_borrowed.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 32
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and has "quotes" & <brackets>
+before ending.
+
+```lua
+local function f(x)
+  return x * 2
+end
+```
+
+<div class="note">
+Some raw HTML.
+</div>
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function rss()
+  local f = assert(io.open("/proc/self/status"))
+  local kb = f:read("*a"):match("VmRSS:%s*(%d+)")
+  f:close()
+  return tonumber(kb) * 1024
+end
+
+local function measure(name, parse)
+  collectgarbage()
+  local before = rss()
+  local start = os.clock()
+  local doc = parse(input, cmark.OPT_DEFAULT)
+  local elapsed = os.clock() - start
+  print(string.format("%-24s %8.3f s  %8.1f MB", name, elapsed,
+                      (rss() - before) / (1024 * 1024)))
+  return doc
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+local copied = measure("parse_string", cmark.parse_string)
+local borrowed = measure("parse_string_borrowed", cmark.parse_string_borrowed)
+cmark.node_free(copied)
+cmark.node_free(borrowed)
@@ -0,0 +1,76 @@
+-- Compares reading a file into a Lua string and parsing it with
+-- cmark.parse_string against the memory-mapped cmark.parse_file.
+--
+-- Usage: lua bench/parse_file.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 256
+
+local sample = [[
+## Section heading
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+1. first
+2. second
+
+> A block quote
+> spanning two lines.
+
+```lua
+local function f(x)
+  return x * 2
+end
+```
+
+]]
+
+local path = os.tmpname()
+local f = assert(io.open(path, "wb"))
+local chunk = string.rep(sample, 1024)
+local written = 0
+while written < megabytes * 1024 * 1024 do
+  f:write(chunk)
+  written = written + #chunk
+end
+f:close()
+
+local function measure(name, parse)
+  collectgarbage()
+  local start = os.clock()
+  local doc = parse()
+  local elapsed = os.clock() - start
+  cmark.node_free(doc)
+  print(string.format("%-28s %8.3f s  %8.1f MB/s", name, elapsed,
+                      written / (1024 * 1024) / elapsed))
+end
+
+print(string.format("input: %.1f MB", written / (1024 * 1024)))
+
+-- Run each variant twice, so that neither benefits from warming up
+-- the page cache or the allocator first.
+for _ = 1, 2 do
+  measure("read + parse_string", function()
+    local fh = assert(io.open(path, "rb"))
+    local s = fh:read("*a")
+    fh:close()
+    return cmark.parse_string(s, cmark.OPT_DEFAULT)
+  end)
+
+  measure("parse_file (mmap)", function()
+    return assert(cmark.parse_file(path, cmark.OPT_DEFAULT))
+  end)
+end
+
+os.remove(path)
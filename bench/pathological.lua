@@ -0,0 +1,164 @@
+-- Checks that parsing and rendering inputs crafted to be slow takes
+-- time linear in their size.  Each family of inputs is generated at
+-- doubling sizes, and its median time over several runs is divided by
+-- that of an ordinary document of the same size: caches and the
+-- allocator slow every input down as it grows, which would otherwise
+-- add 0.1 to 0.3 to the exponents, depending on the machine.  The
+-- scaling exponent is the slope of the logarithm of the relative time,
+-- plus one, against the logarithm of the input size, fitted by least
+-- squares.  Exits with status 1 if any exponent is over the threshold.
+-- Every family measures around 1, so the default threshold of 1.2
+-- leaves room for noise and still catches n^1.25, which is 1.7 times
+-- slower per byte at the largest size than at the smallest.
+--
+-- Usage: lua bench/pathological.lua [threshold] [family]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local threshold = tonumber(arg and arg[1]) or 1.2
+local only = arg and arg[2]
+
+-- Runs of the smallest size are repeated until they take this long, so
+-- that the clock's resolution does not skew the fit.
+local MIN_TIME = 0.02
+local STEPS = 4
+local RUNS = 5
+
+local families = {
+  { "nested brackets", 50000, function(n)
+      return string.rep("[", n) .. "a" .. string.rep("]", n)
+    end },
+  { "nested strong emphasis", 10000, function(n)
+      return string.rep("*a **a ", n) .. "b" .. string.rep(" a** a*", n)
+    end },
+  { "alternating *_", 20000, function(n)
+      return string.rep("*a _b ", n)
+    end },
+  { "emphasis closers", 40000, function(n)
+      return string.rep("a_ ", n)
+    end },
+  { "unclosed links", 20000, function(n)
+      return string.rep("[a](<b", n)
+    end },
+  { "link openers", 50000, function(n)
+      return string.rep("[a", n)
+    end },
+  { "link closers", 50000, function(n)
+      return string.rep("a]", n)
+    end },
+  { "reference definitions", 3000, function(n)
+      local defs = {}
+      for i = 1, n do
+        defs[i] = string.format("[ref%d]: /url%d \"title %d\"\n", i, i, i)
+      end
+      return table.concat(defs) .. "\n[ref1] [ref" .. n .. "]\n"
+    end },
+  -- Kept small: each "> " is a node, and the pointer chasing through
+  -- a deeper tree is slowed down by the caches rather than the parser.
+  { "nested block quotes", 1000, function(n)
+      return string.rep("> ", n) .. "a\n"
+    end },
+  { "nested lists", 300, function(n)
+      local lines = {}
+      for i = 1, n do
+        lines[i] = string.rep(" ", 2 * (i - 1)) .. "- a\n"
+      end
+      return table.concat(lines)
+    end },
+  { "backtick runs", 20000, function(n)
+      local runs = {}
+      for i = 1, n do
+        runs[i] = string.rep("`", i % 50 + 1) .. "a"
+      end
+      return table.concat(runs)
+    end },
+}
+
+-- Returns the time to parse and render 'input' once, repeating it
+-- 'reps' times, or more if that is too fast to measure, and the
+-- number of repetitions needed.
+local function time(input, reps)
+  local start, elapsed
+  repeat
+    collectgarbage()
+    start = os.clock()
+    for _ = 1, reps do
+      local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+      cmark.render_html(doc, cmark.OPT_DEFAULT)
+      cmark.node_free(doc)
+    end
+    elapsed = os.clock() - start
+    if elapsed < MIN_TIME then
+      reps = reps * 2
+    end
+  until elapsed >= MIN_TIME
+  return elapsed / reps, reps
+end
+
+-- An ordinary document of about 'bytes' bytes, whose parsing is linear.
+local function control(bytes)
+  return string.rep("*a* b ", math.ceil(bytes / 6))
+end
+
+-- Returns the time to parse and render 'input', and its median ratio
+-- to the time of the control document of the same size.  Each run
+-- times both back to back, so that they see the same load.
+local function measure(input)
+  local base = control(#input)
+  local times, ratios = {}, {}
+  local reps, base_reps = 1, 1
+  local t, base_t
+  for run = 1, RUNS do
+    t, reps = time(input, reps)
+    base_t, base_reps = time(base, base_reps)
+    times[run], ratios[run] = t, t / base_t
+  end
+  table.sort(times)
+  table.sort(ratios)
+  return times[math.ceil(RUNS / 2)], ratios[math.ceil(RUNS / 2)]
+end
+
+-- Least squares slope of log(times) against log(sizes).
+local function exponent(sizes, times)
+  local n, sx, sy, sxx, sxy = #sizes, 0, 0, 0, 0
+  for i = 1, n do
+    local x, y = math.log(sizes[i]), math.log(times[i])
+    sx, sy = sx + x, sy + y
+    sxx, sxy = sxx + x * x, sxy + x * y
+  end
+  return (n * sxy - sx * sy) / (n * sxx - sx * sx)
+end
+
+local failed = 0
+print(string.format("%-24s %10s %10s %8s", "family", "bytes", "time",
+                    "exponent"))
+for _, family in ipairs(families) do
+  local name, n, generate = family[1], family[2], family[3]
+  if only == nil or only == name then
+    local sizes, times, relative = {}, {}, {}
+    for i = 1, STEPS do
+      local input = generate(n * 2 ^ (i - 1))
+      local ratio
+      sizes[i] = #input
+      times[i], ratio = measure(input)
+      relative[i] = ratio * #input
+    end
+    local e = exponent(sizes, relative)
+    local verdict = ""
+    if e > threshold then
+      verdict = "  FAIL"
+      failed = failed + 1
+    end
+    print(string.format("%-24s %10d %9.4fs %8.2f%s", name, sizes[STEPS],
+                        times[STEPS], e, verdict))
+  end
+end
+
+if failed > 0 then
+  print(string.format("%d of the families scale worse than n^%.2f", failed,
+                      threshold))
+  os.exit(1)
+end
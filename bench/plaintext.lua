@@ -0,0 +1,76 @@
+-- Compares extracting the text of a document by stripping the tags
+-- from cmark.render_html, by walking the tree with cmark.walk, and with
+-- cmark.render_plaintext.
+--
+-- Usage: lua bench/plaintext.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 8
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+```lua
+local function f(x)
+  return x * 2
+end
+```
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+
+local function strip_html(node)
+  return (cmark.render_html(node, cmark.OPT_DEFAULT):gsub("<[^>]*>", ""))
+end
+
+local function walk_text(node)
+  local text = {}
+  for cur, entering, node_type in cmark.walk(node) do
+    if entering and (node_type == cmark.NODE_TEXT or
+                     node_type == cmark.NODE_CODE or
+                     node_type == cmark.NODE_CODE_BLOCK) then
+      text[#text + 1] = cmark.node_get_literal(cur)
+    elseif node_type == cmark.NODE_SOFTBREAK then
+      text[#text + 1] = " "
+    elseif not entering and (node_type == cmark.NODE_PARAGRAPH or
+                             node_type == cmark.NODE_HEADING) then
+      text[#text + 1] = "\n\n"
+    end
+  end
+  return table.concat(text)
+end
+
+local function measure(name, extract)
+  collectgarbage()
+  local start = os.clock()
+  local text = extract(doc)
+  local elapsed = os.clock() - start
+  print(string.format("%-20s %8.3f s  %8.1f MB/s", name, elapsed,
+                      #input / (1024 * 1024) / elapsed))
+  return text
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  measure("render_html + gsub", strip_html)
+  measure("walk", walk_text)
+  measure("render_plaintext", cmark.render_plaintext)
+end
+
+cmark.node_free(doc)
@@ -0,0 +1,60 @@
+-- Measures parsing documents made of reference definitions, from 12500
+-- up to 100000 of them, either in one paragraph or separated by blank
+-- lines, and fits the scaling exponent of the time against the number
+-- of definitions (1 is linear).
+--
+-- Usage: lua bench/references.lua [definitions] [runs]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local largest = tonumber(arg and arg[1]) or 100000
+local runs = tonumber(arg and arg[2]) or 3
+
+local function definitions(n, separator)
+  local defs = {}
+  for i = 1, n do
+    defs[i] = string.format("[ref%d]: /url%d \"title %d\"\n", i, i, i)
+  end
+  return table.concat(defs, separator) .. "\n[ref1] [ref" .. n .. "]\n"
+end
+
+local function time(input)
+  local best = math.huge
+  for _ = 1, runs do
+    collectgarbage()
+    local start = os.clock()
+    local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+    cmark.render_html(doc, cmark.OPT_DEFAULT)
+    cmark.node_free(doc)
+    best = math.min(best, os.clock() - start)
+  end
+  return best
+end
+
+-- Least squares slope of log(time) against log(n).
+local function exponent(sizes, times)
+  local n, sx, sy, sxx, sxy = #sizes, 0, 0, 0, 0
+  for i = 1, n do
+    local x, y = math.log(sizes[i]), math.log(times[i])
+    sx, sy = sx + x, sy + y
+    sxx, sxy = sxx + x * x, sxy + x * y
+  end
+  return (n * sxy - sx * sy) / (n * sxx - sx * sx)
+end
+
+for _, case in ipairs({ { "one paragraph", "" },
+                        { "blank lines between", "\n" } }) do
+  local name, separator = case[1], case[2]
+  local sizes, times = {}, {}
+  print(name)
+  for i = 1, 4 do
+    local n = largest / 2 ^ (4 - i)
+    sizes[i], times[i] = n, time(definitions(n, separator))
+    print(string.format("  %8d definitions %8.3f s %6.0f ns each", n,
+                        times[i], times[i] / n * 1e9))
+  end
+  print(string.format("  exponent %.2f", exponent(sizes, times)))
+end
@@ -0,0 +1,53 @@
+-- Times the commonmark, latex and man renderers on long paragraphs,
+-- without wrapping and wrapped at 72 and 100 columns.
+--
+-- Usage: lua bench/render.lua [paragraphs]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local paragraphs = tonumber(arg and arg[1]) or 10000
+
+local words = { "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur",
+                "adipiscing", "elit,", "sed", "do", "*eiusmod*", "tempor",
+                "incididunt", "ut", "labore", "et", "`dolore`", "magna",
+                "aliqua." }
+
+local paras = {}
+local n = 0
+for i = 1, paragraphs do
+  local para = {}
+  for j = 1, 300 do
+    n = n + 1
+    para[j] = words[(n * 7 + i) % #words + 1]
+  end
+  paras[i] = (i % 3 == 0 and "> " or "") .. table.concat(para, " ")
+end
+local doc = cmark.parse_string(table.concat(paras, "\n\n"), cmark.OPT_DEFAULT)
+
+local renderers = {
+  { "commonmark", cmark.render_commonmark },
+  { "latex", cmark.render_latex },
+  { "man", cmark.render_man },
+}
+
+local function measure(name, render, width)
+  collectgarbage()
+  local start = os.clock()
+  local out = render(doc, cmark.OPT_DEFAULT, width)
+  local elapsed = os.clock() - start
+  print(string.format("%-12s width %3d %8.3f s  %8.1f MB/s", name, width,
+                      elapsed, #out / (1024 * 1024) / elapsed))
+end
+
+for _ = 1, 2 do
+  for _, r in ipairs(renderers) do
+    for _, width in ipairs({ 0, 72, 100 }) do
+      measure(r[1], r[2], width)
+    end
+  end
+end
+
+cmark.node_free(doc)
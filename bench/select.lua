@@ -0,0 +1,66 @@
+-- Compares finding the links and images of a document with a walk in
+-- Lua against cmark.select, with and without cmark.OPT_NODE_INDEX.
+-- Each query is repeated, as when several passes look for nodes.
+--
+-- Usage: lua bench/select.lua [megabytes] [queries]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+local queries = tonumber(arg and arg[2]) or 10
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function walk_select(doc)
+  local nodes = {}
+  for node, entering, node_type in cmark.walk(doc) do
+    if entering and (node_type == cmark.NODE_LINK or
+                     node_type == cmark.NODE_IMAGE) then
+      nodes[#nodes + 1] = node
+    end
+  end
+  return nodes
+end
+
+local function native_select(doc)
+  return cmark.select(doc, { cmark.NODE_LINK, cmark.NODE_IMAGE })
+end
+
+local function measure(name, opts, select)
+  local doc = cmark.parse_string(input, opts)
+  collectgarbage()
+  local start = os.clock()
+  local found
+  for _ = 1, queries do
+    found = #select(doc)
+  end
+  local elapsed = os.clock() - start
+  print(string.format("%-24s %8.3f s  %d nodes", name, elapsed, found))
+  cmark.node_free(doc)
+end
+
+print(string.format("input: %.1f MB, %d queries", #input / (1024 * 1024),
+                    queries))
+
+for _ = 1, 2 do
+  measure("walk", cmark.OPT_DEFAULT, walk_select)
+  measure("select", cmark.OPT_DEFAULT, native_select)
+  measure("select with index", cmark.OPT_NODE_INDEX, native_select)
+end
@@ -0,0 +1,63 @@
+-- Measures the cost of cmark.OPT_STATS by parsing and rendering a
+-- document with and without it, and prints the figures it records.
+--
+-- Usage: lua bench/stats.lua [megabytes] [runs]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+local runs = tonumber(arg and arg[2]) or 5
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link][ref].  It goes on for a while so that lines have a realistic
+length, and wraps onto a third line before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+[ref]: http://example.com/path "title"
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+
+local function measure(name, opts)
+  local best = math.huge
+  local stats
+  for _ = 1, runs do
+    collectgarbage()
+    local start = os.clock()
+    local doc = cmark.parse_string(input, opts)
+    cmark.render_html(doc, cmark.OPT_DEFAULT)
+    best = math.min(best, os.clock() - start)
+    stats = cmark.get_stats(doc)
+    cmark.node_free(doc)
+  end
+  print(string.format("%-16s %8.3f s", name, best))
+  return stats
+end
+
+print(string.format("input: %.1f MB, best of %d runs", #input / (1024 * 1024),
+                    runs))
+
+measure("without stats", cmark.OPT_DEFAULT)
+local stats = measure("with stats", cmark.OPT_STATS)
+
+print()
+for _, field in ipairs({ "block_time", "reference_time", "inline_time",
+                         "emphasis_time", "render_time" }) do
+  print(string.format("%-22s %8.3f s", field, stats[field]))
+end
+for _, field in ipairs({ "lines", "delimiters_pushed", "delimiters_processed",
+                         "references_defined", "references_looked_up",
+                         "renders", "output_bytes" }) do
+  print(string.format("%-22s %10d", field, stats[field]))
+end
+print(string.format("%-22s %10d", "links", stats.nodes[cmark.NODE_LINK]))
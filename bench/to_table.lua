@@ -0,0 +1,82 @@
+-- Compares turning a document into nested Lua tables with cmark.walk
+-- and the node getters against cmark.to_table.
+--
+-- Usage: lua bench/to_table.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+
+local leaves = {}
+for _, t in ipairs({"CODE_BLOCK", "HTML_BLOCK", "THEMATIC_BREAK", "TEXT",
+                    "SOFTBREAK", "LINEBREAK", "CODE", "HTML_INLINE"}) do
+  leaves[cmark["NODE_" .. t]] = true
+end
+
+local function walk_to_table(root)
+  local stack = { { children = {} } }
+  for node, entering, node_type in cmark.walk(root) do
+    if entering then
+      local t = { type = cmark.node_get_type_string(node) }
+      if node_type == cmark.NODE_LIST then
+        t.list_type = cmark.node_get_list_type(node) == cmark.ORDERED_LIST
+                      and "ordered" or "bullet"
+        t.tight = cmark.node_get_list_tight(node) == 1
+      elseif node_type == cmark.NODE_HEADING then
+        t.level = cmark.node_get_heading_level(node)
+      elseif node_type == cmark.NODE_LINK or node_type == cmark.NODE_IMAGE then
+        t.destination = cmark.node_get_url(node)
+        t.title = cmark.node_get_title(node)
+      elseif leaves[node_type] then
+        t.literal = cmark.node_get_literal(node)
+      end
+      local children = stack[#stack].children
+      children[#children + 1] = t
+      if not leaves[node_type] then
+        t.children = {}
+        stack[#stack + 1] = t
+      end
+    else
+      stack[#stack] = nil
+    end
+  end
+  return stack[1].children[1]
+end
+
+local function measure(name, to_table)
+  collectgarbage()
+  local start = os.clock()
+  local t = to_table(doc, cmark.OPT_DEFAULT)
+  local elapsed = os.clock() - start
+  print(string.format("%-16s %8.3f s  %d blocks", name, elapsed,
+                      #t.children))
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  measure("walk + getters", walk_to_table)
+  measure("cmark.to_table", cmark.to_table)
+end
+
+cmark.node_free(doc)
@@ -0,0 +1,65 @@
+-- Compares walking a document with cmark.walk against the same loop
+-- written in Lua on top of iter_next, iter_get_node and node_get_type
+-- (the way cmark.walk used to be implemented).
+--
+-- Usage: lua bench/walk.lua [megabytes]
+
+package.path = "./?.lua;" .. package.path
+package.cpath = "./?.so;" .. package.cpath
+
+local cmark = require 'cmark'
+
+local megabytes = tonumber(arg and arg[1]) or 4
+
+local sample = [[
+## Section heading with `code`
+
+A paragraph with *emphasis*, **strong emphasis**, `inline code` and a
+[link](http://example.com/path "title").  It goes on for a while so
+that lines have a realistic length, and wraps onto a third line
+before ending.
+
+- a bullet item
+- another item with `code`
+  continued on a second line
+
+]]
+
+local input = string.rep(sample, math.ceil(megabytes * 1024 * 1024 / #sample))
+local doc = cmark.parse_string(input, cmark.OPT_DEFAULT)
+
+local function lua_walk(node)
+  local iter = cmark.iter_new(node)
+  return function()
+    while true do
+      local et = cmark.iter_next(iter)
+      if et == cmark.EVENT_DONE then break end
+      local cur = cmark.iter_get_node(iter)
+      return cur, (et == cmark.EVENT_ENTER), cmark.node_get_type(cur)
+    end
+    cmark.iter_free(iter)
+    return nil
+  end
+end
+
+local function measure(name, walk)
+  collectgarbage()
+  local start = os.clock()
+  local links = 0
+  for _, entering, node_type in walk(doc) do
+    if entering and node_type == cmark.NODE_LINK then
+      links = links + 1
+    end
+  end
+  local elapsed = os.clock() - start
+  print(string.format("%-12s %8.3f s  %d links", name, elapsed, links))
+end
+
+print(string.format("input: %.1f MB", #input / (1024 * 1024)))
+
+for _ = 1, 2 do
+  measure("Lua walk", lua_walk)
+  measure("cmark.walk", cmark.walk)
+end
+
+cmark.node_free(doc)
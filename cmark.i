@@ -8,33 +8,1342 @@
 // cmark_parse_document -> parse_document
 %rename("%(regex:/^(cmark|CMARK)_(.*)/\\2/)s") "";
 
+// 64-bit hashes do not fit in a lua_Number; see node_hash below.
+%ignore cmark_node_hash;
+// Binary data needs an explicit length; see node_serialize below.
+%ignore cmark_node_serialize;
+// Borrowed strings could outlive the Lua string they point into.
+%ignore cmark_node_deserialize_borrowed;
+// Sinks are C callbacks; see markdown_to_html_stream and
+// render_json_stream below.
+%ignore cmark_parser_set_html_sink;
+%ignore cmark_render_json_to_sink;
+// Optional arguments and anchors; see render_plaintext below.
+%ignore cmark_render_plaintext;
+%ignore cmark_render_plaintext_to_sink;
+// Hooks are C callbacks; see render_html_with_hooks below.
+%ignore cmark_html_hooks_new;
+%ignore cmark_html_hooks_free;
+%ignore cmark_html_hooks_set;
+%ignore cmark_html_output_put;
+%ignore cmark_html_output_escape;
+%ignore cmark_render_html_with_hooks;
+// Outlines are returned to Lua as tables; see extract_outline below.
+%ignore cmark_extract_outline;
+%ignore cmark_outline_free;
+%ignore cmark_outline_get_length;
+%ignore cmark_outline_get_level;
+%ignore cmark_outline_get_text;
+%ignore cmark_outline_get_slug;
+%ignore cmark_outline_get_start_line;
+// Nodes are returned to Lua as an array; see select below.
+%ignore cmark_node_select;
+// Statistics are returned to Lua as a table; see get_stats below.
+%ignore cmark_stats;
+%ignore cmark_parser_get_stats;
+%ignore cmark_node_get_stats;
+// Usage is returned to Lua as a table; see mem_account_get_usage below.
+%ignore cmark_mem_usage;
+%ignore cmark_mem_account_get_usage;
+// Limits are given from Lua as a table; see parser_set_limits below.
+%ignore cmark_limits;
+%ignore cmark_parser_set_limits;
+
+// Nodes are returned as the same userdata each time; see
+// push_cmark_node below.
+%ignore cmark_node_mark_handle;
+// Borrowed documents keep their Lua string alive; see
+// parse_string_borrowed and node_free below.
+%ignore cmark_parse_document_borrowed;
+%ignore cmark_node_free;
+%typemap(out) cmark_node * "push_cmark_node(L,$1); SWIG_arg++;"
+// Rendered documents are allocated with the allocator of the node,
+// which may be a memory account.
+%typemap(newfree) char * "cmark_node_get_mem(arg1)->free($1);";
+%newobject cmark_render_xml;
+%newobject cmark_render_json;
+%newobject cmark_render_html;
+%newobject cmark_render_man;
+%newobject cmark_render_commonmark;
+%newobject cmark_render_latex;
+%newobject cmark_render_html_cached;
+
 %include "cmark.h"
 
 %{
+// Registry key of the weak-valued table that maps node addresses to
+// their userdata.
+static const char lua_cmark_nodes_key = 0;
+
+// Pushes the userdata of a node, so that there is at most one userdata
+// per node.  An entry in the table is only reused if the node is
+// marked as having one: a node allocated at the address of a freed
+// one is not.
 extern void push_cmark_node(lua_State *L, cmark_node *node)
 {
+        if (node == NULL) {
+                lua_pushnil(L);
+                return;
+        }
+        lua_pushlightuserdata(L, (void *)&lua_cmark_nodes_key);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_newtable(L);
+                lua_pushliteral(L, "v");
+                lua_setfield(L, -2, "__mode");
+                lua_setmetatable(L, -2);
+                lua_pushlightuserdata(L, (void *)&lua_cmark_nodes_key);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+        if (cmark_node_mark_handle(node)) {
+                lua_pushlightuserdata(L, node);
+                lua_rawget(L, -2);
+                if (!lua_isnil(L, -1)) {
+                        lua_remove(L, -2);
+                        return;
+                }
+                lua_pop(L, 1);
+        }
         SWIG_NewPointerObj(L,node,SWIGTYPE_p_cmark_node,0);
+        lua_pushlightuserdata(L, node);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+        lua_remove(L, -2);
+}
+
+// Returns the structural hash of a node as a 16-digit hex string.
+static int lua_cmark_node_hash(lua_State *L)
+{
+        cmark_node *node;
+        char hex[17];
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        snprintf(hex, sizeof(hex), "%016llx",
+                 (unsigned long long)cmark_node_hash(node));
+        lua_pushstring(L, hex);
+        return 1;
+}
+
+// Returns the serialized form of a node as a (binary) string.
+static int lua_cmark_node_serialize(lua_State *L)
+{
+        cmark_node *node;
+        char *buf;
+        size_t len;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        buf = cmark_node_serialize(node, &len);
+        lua_pushlstring(L, buf, len);
+        cmark_node_get_mem(node)->free(buf);
+        return 1;
+}
+
+struct lua_cmark_sink {
+        lua_State *L;
+        int status;
+};
+
+// Passes a piece of output to the function at index 3, stopping at the
+// first error, which is left on the stack.
+static void lua_cmark_sink(const char *data, size_t len, void *userdata)
+{
+        struct lua_cmark_sink *sink = (struct lua_cmark_sink *)userdata;
+
+        if (sink->status != 0)
+                return;
+        lua_pushvalue(sink->L, 3);
+        lua_pushlstring(sink->L, data, len);
+        sink->status = lua_pcall(sink->L, 1, 0, 0);
+}
+
+// Parses a string, calling a function with the HTML of each top-level
+// block as soon as it is available.
+static int lua_cmark_markdown_to_html_stream(lua_State *L)
+{
+        struct lua_cmark_sink sink;
+        cmark_parser *parser;
+        const char *s;
+        size_t len;
+        int options;
+
+        s = luaL_checklstring(L, 1, &len);
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TFUNCTION);
+        lua_settop(L, 3);
+
+        sink.L = L;
+        sink.status = 0;
+        parser = cmark_parser_new(options);
+        cmark_parser_set_html_sink(parser, lua_cmark_sink, &sink);
+        cmark_parser_feed(parser, s, len);
+        cmark_node_free(cmark_parser_finish(parser));
+        cmark_parser_free(parser);
+
+        if (sink.status != 0)
+                return lua_error(L);
+        return 0;
+}
+
+// Returns the headings of a string as a list of tables with the
+// fields level, text, slug and start_line.
+static int lua_cmark_extract_outline(lua_State *L)
+{
+        cmark_outline *outline;
+        const char *s;
+        size_t len;
+        int i, n;
+
+        s = luaL_checklstring(L, 1, &len);
+        outline = cmark_extract_outline(s, len,
+                        (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT));
+        n = cmark_outline_get_length(outline);
+        lua_createtable(L, n, 0);
+        for (i = 0; i < n; i++) {
+                lua_createtable(L, 0, 4);
+                lua_pushinteger(L, cmark_outline_get_level(outline, i));
+                lua_setfield(L, -2, "level");
+                lua_pushstring(L, cmark_outline_get_text(outline, i));
+                lua_setfield(L, -2, "text");
+                lua_pushstring(L, cmark_outline_get_slug(outline, i));
+                lua_setfield(L, -2, "slug");
+                lua_pushinteger(L, cmark_outline_get_start_line(outline, i));
+                lua_setfield(L, -2, "start_line");
+                lua_rawseti(L, -2, i + 1);
+        }
+        cmark_outline_free(outline);
+        return 1;
+}
+
+// Renders a node as JSON, calling a function with each piece of the
+// output as it is rendered.  Returns true, or nil and an error message
+// if the rendering stopped at the output limit.
+static int lua_cmark_render_json_stream(lua_State *L)
+{
+        struct lua_cmark_sink sink;
+        cmark_node *node;
+        int options, complete;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TFUNCTION);
+        lua_settop(L, 3);
+
+        sink.L = L;
+        sink.status = 0;
+        complete = cmark_render_json_to_sink(node, options, lua_cmark_sink,
+                        &sink);
+
+        if (sink.status != 0)
+                return lua_error(L);
+        if (!complete) {
+                lua_pushnil(L);
+                lua_pushliteral(L, "output limit exceeded");
+                return 2;
+        }
+        lua_pushboolean(L, 1);
+        return 1;
+}
+
+struct lua_cmark_plaintext {
+        lua_State *L;
+        int pieces;
+        int anchors;
+};
+
+// Adds a piece of text to the table at index 5.
+static void lua_cmark_plaintext_piece(const char *data, size_t len, void *userdata)
+{
+        struct lua_cmark_plaintext *pt = (struct lua_cmark_plaintext *)userdata;
+
+        lua_pushlstring(pt->L, data, len);
+        lua_rawseti(pt->L, 5, ++pt->pieces);
+}
+
+// Adds an anchor to the table at index 6.
+static void lua_cmark_plaintext_anchor(size_t offset, int line, void *userdata)
+{
+        struct lua_cmark_plaintext *pt = (struct lua_cmark_plaintext *)userdata;
+
+        lua_createtable(pt->L, 0, 2);
+        lua_pushinteger(pt->L, (lua_Integer)offset);
+        lua_setfield(pt->L, -2, "offset");
+        lua_pushinteger(pt->L, line);
+        lua_setfield(pt->L, -2, "line");
+        lua_rawseti(pt->L, 6, ++pt->anchors);
+}
+
+// Returns the text content of a node and, if the fourth argument is
+// true, a list of anchors with the fields offset and line, or nil and
+// an error message past the output limit.
+static int lua_cmark_render_plaintext(lua_State *L)
+{
+        struct lua_cmark_plaintext pt;
+        cmark_node *node;
+        const char *separator;
+        int options, want_anchors, i;
+        luaL_Buffer b;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        separator = luaL_optstring(L, 3, NULL);
+        want_anchors = lua_toboolean(L, 4);
+        lua_settop(L, 4);
+        lua_newtable(L);
+        lua_newtable(L);
+
+        pt.L = L;
+        pt.pieces = 0;
+        pt.anchors = 0;
+        if (!cmark_render_plaintext_to_sink(node, options, separator,
+                        lua_cmark_plaintext_piece,
+                        want_anchors ? lua_cmark_plaintext_anchor : NULL, &pt)) {
+                lua_pushnil(L);
+                lua_pushliteral(L, "output limit exceeded");
+                return 2;
+        }
+
+        luaL_buffinit(L, &b);
+        for (i = 1; i <= pt.pieces; i++) {
+                lua_rawgeti(L, 5, i);
+                luaL_addvalue(&b);
+        }
+        luaL_pushresult(&b);
+        if (!want_anchors)
+                return 1;
+        lua_pushvalue(L, 6);
+        return 2;
+}
+
+struct lua_cmark_hooks {
+        lua_State *L;
+        int status;
+};
+
+// Calls the function for the type of 'node' in the table at index 3
+// with the node, whether it is being entered and the options.  A
+// string result replaces the node's HTML; a true second result skips
+// its children too.  The first error is left on the stack.
+static cmark_html_hook_result lua_cmark_html_hook(cmark_node *node,
+                cmark_event_type ev_type, int options,
+                cmark_html_output *out, void *userdata)
+{
+        struct lua_cmark_hooks *hooks = (struct lua_cmark_hooks *)userdata;
+        lua_State *L = hooks->L;
+        cmark_html_hook_result result = CMARK_HTML_HOOK_DEFAULT;
+        const char *s;
+        size_t len;
+
+        if (hooks->status != 0)
+                return result;
+        lua_rawgeti(L, 3, cmark_node_get_type(node));
+        push_cmark_node(L, node);
+        lua_pushboolean(L, ev_type == CMARK_EVENT_ENTER);
+        lua_pushinteger(L, options);
+        hooks->status = lua_pcall(L, 3, 2, 0);
+        if (hooks->status != 0)
+                return result;
+        s = lua_tolstring(L, -2, &len);
+        if (s != NULL) {
+                cmark_html_output_put(out, s, len);
+                result = lua_toboolean(L, -1) ? CMARK_HTML_HOOK_SKIP
+                                              : CMARK_HTML_HOOK_REPLACE;
+        }
+        lua_pop(L, 2);
+        return result;
+}
+
+// Renders a node as HTML, calling the functions in a table keyed by
+// node type for nodes of those types.
+static int lua_cmark_render_html_with_hooks(lua_State *L)
+{
+        struct lua_cmark_hooks data;
+        cmark_html_hooks *hooks;
+        cmark_node *node;
+        lua_Integer type;
+        char *html;
+        int options;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TTABLE);
+        lua_settop(L, 3);
+
+        data.L = L;
+        data.status = 0;
+        hooks = cmark_html_hooks_new();
+        lua_pushnil(L);
+        while (lua_next(L, 3) != 0) {
+                type = lua_type(L, -2) == LUA_TNUMBER ? lua_tointeger(L, -2) : 0;
+                if (!lua_isfunction(L, -1) ||
+                    !cmark_html_hooks_set(hooks, (cmark_node_type)type,
+                                          lua_cmark_html_hook, &data)) {
+                        cmark_html_hooks_free(hooks);
+                        return luaL_argerror(L, 3,
+                                        "expected functions keyed by node type");
+                }
+                lua_pop(L, 1);
+        }
+
+        html = cmark_render_html_with_hooks(node, options, hooks);
+        cmark_html_hooks_free(hooks);
+        if (data.status != 0) {
+                cmark_node_get_mem(node)->free(html);
+                return lua_error(L);
+        }
+        lua_pushstring(L, html);
+        cmark_node_get_mem(node)->free(html);
+        return 1;
+}
+
+// State of a cmark.walk loop.  The iterator is freed as soon as the
+// walk is over, or else when the state is closed (by leaving the loop
+// early, in Lua 5.4) or collected.
+struct lua_cmark_walk {
+        cmark_iter *iter;
+};
+
+static int lua_cmark_walk_close(lua_State *L)
+{
+        struct lua_cmark_walk *walk = (struct lua_cmark_walk *)lua_touserdata(L, 1);
+
+        if (walk->iter != NULL) {
+                cmark_iter_free(walk->iter);
+                walk->iter = NULL;
+        }
+        return 0;
+}
+
+// Pushes a new walk state, with no iterator yet.
+static struct lua_cmark_walk *lua_cmark_push_walk(lua_State *L)
+{
+        struct lua_cmark_walk *walk;
+
+        walk = (struct lua_cmark_walk *)lua_newuserdata(L, sizeof(*walk));
+        walk->iter = NULL;
+        if (luaL_newmetatable(L, "cmark.walk")) {
+                lua_pushcfunction(L, lua_cmark_walk_close);
+                lua_setfield(L, -2, "__gc");
+                lua_pushcfunction(L, lua_cmark_walk_close);
+                lua_setfield(L, -2, "__close");
+        }
+        lua_setmetatable(L, -2);
+        return walk;
+}
+
+// Returns the node, whether it is being entered and its type for each
+// step of a walk, or nothing at the end.  The upvalue is the walk state.
+static int lua_cmark_walk_next(lua_State *L)
+{
+        struct lua_cmark_walk *walk =
+                (struct lua_cmark_walk *)lua_touserdata(L, lua_upvalueindex(1));
+        cmark_event_type ev_type;
+        cmark_node_type type;
+        cmark_node *cur;
+
+        if (walk->iter == NULL)
+                return 0;
+        ev_type = cmark_iter_next(walk->iter);
+        if (ev_type == CMARK_EVENT_DONE) {
+                cmark_iter_free(walk->iter);
+                walk->iter = NULL;
+                return 0;
+        }
+        cur = cmark_iter_get_node(walk->iter);
+        type = cmark_node_get_type(cur);
+
+        push_cmark_node(L, cur);
+        lua_pushboolean(L, ev_type == CMARK_EVENT_ENTER);
+        lua_pushinteger(L, type);
+        return 3;
+}
+
+// Returns an iterator over the nodes under a node, for use in a generic
+// for loop, and the walk state as a to-be-closed value.
+static int lua_cmark_walk(lua_State *L)
+{
+        extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+        struct lua_cmark_walk *walk;
+        cmark_node *node;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+
+        walk = lua_cmark_push_walk(L);
+        // Allocated outside the node's memory account, which may be
+        // freed before a walk left early is collected.
+        walk->iter = cmark_iter_new_with_mem(node, &DEFAULT_MEM_ALLOCATOR);
+
+        lua_pushvalue(L, -1);
+        lua_pushcclosure(L, lua_cmark_walk_next, 1);
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lua_pushvalue(L, -4);
+        return 4;
+}
+
+// Nodes that the iterator enters but never exits.
+static int lua_cmark_is_leaf(cmark_node_type type)
+{
+        switch (type) {
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_THEMATIC_BREAK:
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_SOFTBREAK:
+        case CMARK_NODE_LINEBREAK:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return 1;
+        default:
+                return 0;
+        }
+}
+
+// Number of fields that lua_cmark_node_fields sets for a node, not
+// counting its children.
+static int lua_cmark_field_count(cmark_node *node, int options)
+{
+        int n = 1;
+
+        if ((options & CMARK_OPT_SOURCEPOS) && cmark_node_get_start_line(node) != 0)
+                n++;
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                return n + 4;
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                return n + 2;
+        case CMARK_NODE_HEADING:
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return n + 1;
+        default:
+                return n;
+        }
+}
+
+static void lua_cmark_set_string(lua_State *L, const char *key, const char *value)
+{
+        lua_pushstring(L, value);
+        lua_setfield(L, -2, key);
+}
+
+static void lua_cmark_set_integer(lua_State *L, const char *key, int value)
+{
+        lua_pushinteger(L, value);
+        lua_setfield(L, -2, key);
+}
+
+// Sets the fields of the table on top of the stack that describe a
+// node: its type, its source position if asked for and known, and the
+// attributes of its type, named as in cmark.render_json.
+static void lua_cmark_node_fields(lua_State *L, cmark_node *node, int options)
+{
+        lua_cmark_set_string(L, "type", cmark_node_get_type_string(node));
+        if ((options & CMARK_OPT_SOURCEPOS) && cmark_node_get_start_line(node) != 0) {
+                lua_createtable(L, 4, 0);
+                lua_pushinteger(L, cmark_node_get_start_line(node));
+                lua_rawseti(L, -2, 1);
+                lua_pushinteger(L, cmark_node_get_start_column(node));
+                lua_rawseti(L, -2, 2);
+                lua_pushinteger(L, cmark_node_get_end_line(node));
+                lua_rawseti(L, -2, 3);
+                lua_pushinteger(L, cmark_node_get_end_column(node));
+                lua_rawseti(L, -2, 4);
+                lua_setfield(L, -2, "sourcepos");
+        }
+
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                if (cmark_node_get_list_type(node) == CMARK_ORDERED_LIST) {
+                        lua_cmark_set_string(L, "list_type", "ordered");
+                        lua_cmark_set_integer(L, "start", cmark_node_get_list_start(node));
+                        lua_cmark_set_string(L, "delim",
+                                        cmark_node_get_list_delim(node) == CMARK_PAREN_DELIM ?
+                                        "paren" : "period");
+                } else {
+                        lua_cmark_set_string(L, "list_type", "bullet");
+                }
+                lua_pushboolean(L, cmark_node_get_list_tight(node));
+                lua_setfield(L, -2, "tight");
+                break;
+        case CMARK_NODE_HEADING:
+                lua_cmark_set_integer(L, "level", cmark_node_get_heading_level(node));
+                break;
+        case CMARK_NODE_CODE_BLOCK:
+                lua_cmark_set_string(L, "info", cmark_node_get_fence_info(node));
+                lua_cmark_set_string(L, "literal", cmark_node_get_literal(node));
+                break;
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                lua_cmark_set_string(L, "literal", cmark_node_get_literal(node));
+                break;
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+                lua_cmark_set_string(L, "on_enter", cmark_node_get_on_enter(node));
+                lua_cmark_set_string(L, "on_exit", cmark_node_get_on_exit(node));
+                break;
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                lua_cmark_set_string(L, "destination", cmark_node_get_url(node));
+                lua_cmark_set_string(L, "title", cmark_node_get_title(node));
+                break;
+        default:
+                break;
+        }
+}
+
+// Returns a node and its descendants as nested tables.  While the tree
+// is built, the stack holds the children tables of the open nodes,
+// starting with a table that receives the root.  The iterator is held
+// in a walk state below them, so that it is freed if building a table
+// raises an error.
+static int lua_cmark_to_table(lua_State *L)
+{
+        struct lua_cmark_walk *walk;
+        cmark_event_type ev_type;
+        cmark_node *node, *child;
+        cmark_iter *iter;
+        int options, n;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        lua_settop(L, 2);
+        walk = lua_cmark_push_walk(L);
+        lua_createtable(L, 1, 0);
+
+        iter = walk->iter = cmark_iter_new(node);
+        while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+                node = cmark_iter_get_node(iter);
+                if (ev_type == CMARK_EVENT_EXIT) {
+                        lua_pop(L, 1);
+                        continue;
+                }
+                if (!lua_checkstack(L, 4))
+                        return luaL_error(L, "document is nested too deeply");
+                lua_createtable(L, 0, lua_cmark_field_count(node, options) + 1);
+                lua_cmark_node_fields(L, node, options);
+                lua_pushvalue(L, -1);
+                lua_rawseti(L, -3, (int)lua_rawlen(L, -3) + 1);
+                if (lua_cmark_is_leaf(cmark_node_get_type(node))) {
+                        lua_pop(L, 1);
+                        continue;
+                }
+                n = 0;
+                for (child = cmark_node_first_child(node); child != NULL;
+                     child = cmark_node_next(child))
+                        n++;
+                lua_createtable(L, n, 0);
+                lua_pushvalue(L, -1);
+                lua_setfield(L, -3, "children");
+                lua_remove(L, -2);
+        }
+        cmark_iter_free(iter);
+        walk->iter = NULL;
+
+        lua_rawgeti(L, 4, 1);
+        return 1;
+}
+
+// What the builder accepts as children of a node, and the class of a
+// node as a child.
+#define LUA_CMARK_ITEMS 1
+#define LUA_CMARK_BLOCKS 2
+#define LUA_CMARK_INLINES 4
+#define LUA_CMARK_LITERAL 8
+
+static int lua_cmark_contains(cmark_node_type type)
+{
+        switch (type) {
+        case CMARK_NODE_DOCUMENT:
+        case CMARK_NODE_BLOCK_QUOTE:
+        case CMARK_NODE_ITEM:
+                return LUA_CMARK_BLOCKS;
+        case CMARK_NODE_LIST:
+                return LUA_CMARK_ITEMS;
+        case CMARK_NODE_CUSTOM_BLOCK:
+                return LUA_CMARK_ITEMS | LUA_CMARK_BLOCKS | LUA_CMARK_INLINES;
+        case CMARK_NODE_HEADING:
+        case CMARK_NODE_PARAGRAPH:
+        case CMARK_NODE_EMPH:
+        case CMARK_NODE_STRONG:
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+        case CMARK_NODE_CUSTOM_INLINE:
+                return LUA_CMARK_INLINES;
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return LUA_CMARK_LITERAL;
+        default:
+                return 0;
+        }
+}
+
+static int lua_cmark_node_class(cmark_node *node)
+{
+        cmark_node_type type = cmark_node_get_type(node);
+
+        if (type == CMARK_NODE_ITEM)
+                return LUA_CMARK_ITEMS;
+        if (type >= CMARK_NODE_FIRST_BLOCK && type <= CMARK_NODE_LAST_BLOCK)
+                return LUA_CMARK_BLOCKS;
+        if (type >= CMARK_NODE_FIRST_INLINE && type <= CMARK_NODE_LAST_INLINE)
+                return LUA_CMARK_INLINES;
+        return 0;
+}
+
+static const char *lua_cmark_class_name(int node_class)
+{
+        switch (node_class) {
+        case LUA_CMARK_ITEMS:
+                return "item";
+        case LUA_CMARK_BLOCKS:
+                return "block";
+        case LUA_CMARK_INLINES:
+                return "inline";
+        default:
+                return "unknown";
+        }
+}
+
+// The node that build_node is building, and the nodes that the caller
+// supplied as its contents.  It is held in a userdata, so that what has
+// been built is discarded when the holder is collected if building
+// raises an error.
+struct lua_cmark_building {
+        cmark_node *node;
+        cmark_node **supplied;
+        size_t nsupplied;
+        size_t capacity;
+};
+
+// Records a node supplied by the caller, before it is added.
+static void lua_cmark_building_supply(lua_State *L,
+                                      struct lua_cmark_building *building,
+                                      cmark_node *child)
+{
+        cmark_node **supplied;
+        size_t capacity;
+
+        if (building->nsupplied == building->capacity) {
+                capacity = building->capacity ? 2 * building->capacity : 8;
+                supplied = (cmark_node **)realloc(building->supplied,
+                                                  capacity * sizeof(*supplied));
+                if (supplied == NULL)
+                        luaL_error(L, "not enough memory");
+                building->supplied = supplied;
+                building->capacity = capacity;
+        }
+        building->supplied[building->nsupplied++] = child;
+}
+
+// Frees the node being built, if any, with the nodes that build_node
+// created for it.  The nodes supplied by the caller are unlinked from
+// it first, since the caller may still hold and free them.
+static void lua_cmark_building_discard(struct lua_cmark_building *building)
+{
+        cmark_node *cur;
+        size_t i;
+
+        if (building->node != NULL) {
+                for (i = 0; i < building->nsupplied; i++) {
+                        cur = cmark_node_parent(building->supplied[i]);
+                        while (cur != NULL && cur != building->node)
+                                cur = cmark_node_parent(cur);
+                        if (cur != NULL)
+                                cmark_node_unlink(building->supplied[i]);
+                }
+                cmark_node_free(building->node);
+                building->node = NULL;
+        }
+        free(building->supplied);
+        building->supplied = NULL;
+        building->nsupplied = 0;
+        building->capacity = 0;
+}
+
+// Returns a new node of the given type with 'child' as its only child,
+// or NULL if it could not be created.
+static cmark_node *lua_cmark_wrap(cmark_node *child, cmark_node_type type)
+{
+        cmark_node *wrapper = cmark_node_new(type);
+
+        if (wrapper != NULL && !cmark_node_append_child(wrapper, child)) {
+                cmark_node_free(wrapper);
+                return NULL;
+        }
+        return wrapper;
+}
+
+// Appends a child to a node, wrapping it in an item or a paragraph if
+// the node cannot contain it directly.  Returns NULL on success, or an
+// error message, in which case the child has not been added and any
+// wrapper has been freed.
+static const char *lua_cmark_add_child(lua_State *L, cmark_node *node,
+                                       cmark_node *child, int contains)
+{
+        int child_class = lua_cmark_node_class(child);
+        cmark_node *wrapped = child, *para;
+
+        if (child_class & contains) {
+                // Appended as it is.
+        } else if (child_class == LUA_CMARK_BLOCKS && (contains & LUA_CMARK_ITEMS)) {
+                wrapped = lua_cmark_wrap(child, CMARK_NODE_ITEM);
+        } else if (child_class == LUA_CMARK_INLINES && (contains & LUA_CMARK_BLOCKS)) {
+                wrapped = lua_cmark_wrap(child, CMARK_NODE_PARAGRAPH);
+        } else if (child_class == LUA_CMARK_INLINES && (contains & LUA_CMARK_ITEMS)) {
+                para = lua_cmark_wrap(child, CMARK_NODE_PARAGRAPH);
+                wrapped = para != NULL ? lua_cmark_wrap(para, CMARK_NODE_ITEM) : NULL;
+                if (para != NULL && wrapped == NULL) {
+                        cmark_node_unlink(child);
+                        cmark_node_free(para);
+                }
+        } else {
+                return lua_pushfstring(L,
+                                "Tried to add a node with class %s to a node with class %s",
+                                lua_cmark_class_name(child_class),
+                                lua_cmark_class_name(lua_cmark_node_class(node)));
+        }
+        if (wrapped == NULL)
+                return "Could not wrap child";
+        if (!cmark_node_append_child(node, wrapped)) {
+                if (wrapped != child) {
+                        cmark_node_unlink(child);
+                        cmark_node_free(wrapped);
+                }
+                return "Could not append child";
+        }
+        return NULL;
+}
+
+// Adds the value at 'idx' as content of a node, as cmark.builder does:
+// tables are lists of contents, functions are called, nodes are added
+// as children, and anything else is converted to a string and becomes
+// the node's literal or a text node.  Returns an error message, or NULL
+// on success.
+static const char *lua_cmark_add_children(lua_State *L,
+                                          struct lua_cmark_building *building,
+                                          int idx, int contains)
+{
+        cmark_node *node = building->node;
+        const char *msg, *s;
+        cmark_node *child;
+        int i;
+
+        luaL_checkstack(L, 3, "contents are nested too deeply");
+        switch (lua_type(L, idx)) {
+        case LUA_TNIL:
+                return NULL;
+        case LUA_TTABLE:
+                for (i = 1; ; i++) {
+                        lua_rawgeti(L, idx, i);
+                        if (lua_isnil(L, -1)) {
+                                lua_pop(L, 1);
+                                return NULL;
+                        }
+                        msg = lua_cmark_add_children(L, building, lua_gettop(L),
+                                                     contains);
+                        if (msg != NULL)
+                                return msg;
+                        lua_pop(L, 1);
+                }
+        case LUA_TFUNCTION:
+                lua_pushvalue(L, idx);
+                lua_call(L, 0, 1);
+                msg = lua_cmark_add_children(L, building, lua_gettop(L), contains);
+                if (msg == NULL)
+                        lua_pop(L, 1);
+                return msg;
+        case LUA_TUSERDATA:
+                if (!SWIG_IsOK(SWIG_ConvertPtr(L,idx,(void**)&child,SWIGTYPE_p_cmark_node,0)))
+                        luaL_error(L, "expected cmark_node");
+                lua_cmark_building_supply(L, building, child);
+                return lua_cmark_add_child(L, node, child, contains);
+        case LUA_TSTRING:
+        case LUA_TNUMBER:
+                lua_pushvalue(L, idx);
+                break;
+        default:
+                lua_getglobal(L, "tostring");
+                lua_pushvalue(L, idx);
+                lua_call(L, 1, 1);
+                break;
+        }
+
+        s = lua_tostring(L, -1);
+        if (contains & LUA_CMARK_LITERAL) {
+                if (!cmark_node_set_literal(node, s))
+                        return "Could not set literal";
+                lua_pop(L, 1);
+                return NULL;
+        }
+        child = cmark_node_new(CMARK_NODE_TEXT);
+        if (child == NULL)
+                return "Could not create text node";
+        if (!cmark_node_set_literal(child, s))
+                msg = "Could not set literal";
+        else
+                msg = lua_cmark_add_child(L, node, child, contains);
+        if (msg != NULL)
+                cmark_node_free(child);
+        lua_pop(L, 1);
+        return msg;
+}
+
+// Pushes the field 'key' of the contents table at 'idx', and returns
+// whether it is set (as in Lua, false counts as unset).
+static int lua_cmark_attribute(lua_State *L, int idx, const char *key)
+{
+        lua_getfield(L, idx, key);
+        if (lua_toboolean(L, -1))
+                return 1;
+        lua_pop(L, 1);
+        return 0;
+}
+
+static const char *lua_cmark_string_attribute(lua_State *L, int idx, const char *key)
+{
+        const char *s = lua_tostring(L, idx);
+
+        if (s == NULL)
+                luaL_error(L, "expected a string for %s", key);
+        return s;
+}
+
+static int lua_cmark_integer_attribute(lua_State *L, int idx, const char *key)
+{
+        if (!lua_isnumber(L, idx))
+                luaL_error(L, "expected a number for %s", key);
+        return (int)lua_tointeger(L, idx);
+}
+
+// Sets the attributes of a node from the fields of the contents table
+// at 'idx'.  Returns an error message, or NULL on success.
+static const char *lua_cmark_set_attributes(lua_State *L, cmark_node *node, int idx)
+{
+        const char *s;
+
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                if (cmark_node_get_list_type(node) == CMARK_ORDERED_LIST) {
+                        if (lua_cmark_attribute(L, idx, "delim")) {
+                                s = lua_tostring(L, -1);
+                                if (lua_type(L, -1) == LUA_TNUMBER &&
+                                    (lua_tointeger(L, -1) == CMARK_PAREN_DELIM ||
+                                     lua_tointeger(L, -1) == CMARK_PERIOD_DELIM))
+                                        cmark_node_set_list_delim(node,
+                                                        (cmark_delim_type)lua_tointeger(L, -1));
+                                else if (s != NULL && strcmp(s, ")") == 0)
+                                        cmark_node_set_list_delim(node, CMARK_PAREN_DELIM);
+                                else if (s != NULL && strcmp(s, ".") == 0)
+                                        cmark_node_set_list_delim(node, CMARK_PERIOD_DELIM);
+                                else
+                                        return lua_pushfstring(L, "Unknown delimiter %s",
+                                                        s != NULL ? s : luaL_typename(L, -1));
+                                lua_pop(L, 1);
+                        }
+                        if (lua_cmark_attribute(L, idx, "start")) {
+                                cmark_node_set_list_start(node,
+                                                lua_cmark_integer_attribute(L, -1, "start"));
+                                lua_pop(L, 1);
+                        }
+                }
+                if (lua_cmark_attribute(L, idx, "tight")) {
+                        cmark_node_set_list_tight(node, 1);
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_CODE_BLOCK:
+                if (lua_cmark_attribute(L, idx, "info")) {
+                        cmark_node_set_fence_info(node,
+                                        lua_cmark_string_attribute(L, -1, "info"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_HEADING:
+                if (lua_cmark_attribute(L, idx, "level")) {
+                        cmark_node_set_heading_level(node,
+                                        lua_cmark_integer_attribute(L, -1, "level"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+                if (lua_cmark_attribute(L, idx, "on_enter")) {
+                        cmark_node_set_on_enter(node,
+                                        lua_cmark_string_attribute(L, -1, "on_enter"));
+                        lua_pop(L, 1);
+                }
+                if (lua_cmark_attribute(L, idx, "on_exit")) {
+                        cmark_node_set_on_exit(node,
+                                        lua_cmark_string_attribute(L, -1, "on_exit"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                if (lua_cmark_attribute(L, idx, "title")) {
+                        cmark_node_set_title(node,
+                                        lua_cmark_string_attribute(L, -1, "title"));
+                        lua_pop(L, 1);
+                }
+                if (lua_cmark_attribute(L, idx, "url")) {
+                        cmark_node_set_url(node,
+                                        lua_cmark_string_attribute(L, -1, "url"));
+                        lua_pop(L, 1);
+                }
+                break;
+        default:
+                break;
+        }
+        return NULL;
+}
+
+static int lua_cmark_building_gc(lua_State *L)
+{
+        lua_cmark_building_discard((struct lua_cmark_building *)lua_touserdata(L, 1));
+        return 0;
+}
+
+// Creates a node of the given type (and, for lists, list type) from
+// contents in the form that cmark.builder takes.  Returns the node, or
+// nil and an error message.  On error the partly built node is freed,
+// but the nodes supplied as contents are left to the caller.
+static int lua_cmark_build_node(lua_State *L)
+{
+        struct lua_cmark_building *building;
+        cmark_node_type type;
+        cmark_node *node;
+        const char *msg = NULL;
+
+        type = (cmark_node_type)luaL_checkinteger(L, 1);
+        lua_settop(L, 3);
+        building = (struct lua_cmark_building *)lua_newuserdata(L, sizeof(*building));
+        memset(building, 0, sizeof(*building));
+        if (luaL_newmetatable(L, "cmark.building")) {
+                lua_pushcfunction(L, lua_cmark_building_gc);
+                lua_setfield(L, -2, "__gc");
+        }
+        lua_setmetatable(L, -2);
+        node = cmark_node_new(type);
+        if (node == NULL) {
+                lua_pushnil(L);
+                lua_pushfstring(L, "Could not create node of type %d", (int)type);
+                return 2;
+        }
+        building->node = node;
+        if (type == CMARK_NODE_LIST)
+                cmark_node_set_list_type(node,
+                                (cmark_list_type)luaL_optinteger(L, 3, CMARK_BULLET_LIST));
+
+        if (lua_istable(L, 2))
+                msg = lua_cmark_set_attributes(L, node, 2);
+        if (msg == NULL)
+                msg = lua_cmark_add_children(L, building, 2, lua_cmark_contains(type));
+        if (msg != NULL) {
+                lua_pushnil(L);
+                lua_pushstring(L, msg);
+                lua_cmark_building_discard(building);
+                return 2;
+        }
+        building->node = NULL;
+        lua_cmark_building_discard(building);
+        push_cmark_node(L, node);
+        return 1;
+}
+
+// Registry key of the table that maps the address of a document parsed
+// by parse_string_borrowed to the string its nodes point into.
+static const char lua_cmark_sources_key = 0;
+
+// Pushes the table of borrowed source strings, creating it if needed.
+static void lua_cmark_push_sources(lua_State *L)
+{
+        lua_pushlightuserdata(L, (void *)&lua_cmark_sources_key);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_pushlightuserdata(L, (void *)&lua_cmark_sources_key);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+}
+
+// Parses a string without copying the content of its blocks, which
+// points into the string instead.  The string is kept alive until the
+// document is freed with node_free.  The parser briefly writes into the
+// string and restores it before returning, which no Lua code can see.
+static int lua_cmark_parse_string_borrowed(lua_State *L)
+{
+        size_t len;
+        const char *s = luaL_checklstring(L, 1, &len);
+        int options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        cmark_node *doc;
+
+        doc = cmark_parse_document_borrowed(s, len, options);
+        if (doc == NULL)
+                return 0;
+        lua_cmark_push_sources(L);
+        lua_pushlightuserdata(L, doc);
+        lua_pushvalue(L, 1);
+        lua_rawset(L, -3);
+        lua_pop(L, 1);
+        push_cmark_node(L, doc);
+        return 1;
+}
+
+// Frees a node and its children, and releases the source string of a
+// document parsed by parse_string_borrowed.
+static int lua_cmark_node_free(lua_State *L)
+{
+        cmark_node *node;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)) ||
+            node == NULL)
+                return luaL_argerror(L, 1, "expected cmark_node");
+        cmark_node_free(node);
+        lua_cmark_push_sources(L);
+        lua_pushlightuserdata(L, node);
+        lua_pushnil(L);
+        lua_rawset(L, -3);
+        return 0;
+}
+
+// Returns the nodes under a node whose type is one of a list of types
+// (or a single type), as an array, stopping after 'max' nodes if it is
+// given.
+static int lua_cmark_select(lua_State *L)
+{
+        cmark_node *node, **nodes;
+        unsigned int mask = 0;
+        lua_Integer type, max;
+        size_t i, n, count;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        if (lua_istable(L, 2)) {
+                n = lua_rawlen(L, 2);
+                for (i = 1; i <= n; i++) {
+                        lua_rawgeti(L, 2, (int)i);
+                        type = lua_tointeger(L, -1);
+                        lua_pop(L, 1);
+                        if (type < CMARK_NODE_FIRST_BLOCK ||
+                            type > CMARK_NODE_LAST_INLINE)
+                                return luaL_argerror(L, 2, "invalid node type");
+                        mask |= CMARK_NODE_MASK(type);
+                }
+        } else {
+                type = luaL_checkinteger(L, 2);
+                if (type < CMARK_NODE_FIRST_BLOCK || type > CMARK_NODE_LAST_INLINE)
+                        return luaL_argerror(L, 2, "invalid node type");
+                mask = CMARK_NODE_MASK(type);
+        }
+        max = luaL_optinteger(L, 3, 0);
+        if (max < 0)
+                return luaL_argerror(L, 3, "negative count");
+
+        nodes = cmark_node_select(node, mask, (size_t)max, &count);
+        lua_createtable(L, (int)count, 0);
+        for (i = 0; i < count; i++) {
+                push_cmark_node(L, nodes[i]);
+                lua_rawseti(L, -2, (int)(i + 1));
+        }
+        cmark_node_get_mem(node)->free(nodes);
+        return 1;
+}
+
+static void lua_cmark_set_number(lua_State *L, const char *key, double value)
+{
+        lua_pushnumber(L, value);
+        lua_setfield(L, -2, key);
+}
+
+// Returns the statistics of the document that a node belongs to as a
+// table, or nil if it was not parsed with OPT_STATS.  Times are in
+// seconds, and 'nodes' is indexed by node type.
+static int lua_cmark_get_stats(lua_State *L)
+{
+        cmark_node *node;
+        const cmark_stats *stats;
+        int type;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        stats = cmark_node_get_stats(node);
+        if (stats == NULL) {
+                lua_pushnil(L);
+                return 1;
+        }
+
+        lua_createtable(L, 0, 14);
+        lua_cmark_set_number(L, "block_time", stats->block_ns / 1e9);
+        lua_cmark_set_number(L, "reference_time", stats->reference_ns / 1e9);
+        lua_cmark_set_number(L, "inline_time", stats->inline_ns / 1e9);
+        lua_cmark_set_number(L, "emphasis_time", stats->emphasis_ns / 1e9);
+        lua_cmark_set_number(L, "render_time", stats->render_ns / 1e9);
+        lua_cmark_set_number(L, "lines", (double)stats->lines);
+        lua_cmark_set_number(L, "delimiters_pushed", (double)stats->delimiters_pushed);
+        lua_cmark_set_number(L, "delimiters_processed", (double)stats->delimiters_processed);
+        lua_cmark_set_number(L, "references_defined", (double)stats->references_defined);
+        lua_cmark_set_number(L, "references_looked_up", (double)stats->references_looked_up);
+        lua_cmark_set_number(L, "renders", (double)stats->renders);
+        lua_cmark_set_number(L, "output_bytes", (double)stats->output_bytes);
+        lua_createtable(L, CMARK_NODE_LAST_INLINE, 0);
+        for (type = CMARK_NODE_FIRST_BLOCK; type <= CMARK_NODE_LAST_INLINE; type++) {
+                lua_pushnumber(L, (double)stats->nodes[type]);
+                lua_rawseti(L, -2, type);
+        }
+        lua_setfield(L, -2, "nodes");
+        return 1;
+}
+
+// Returns what has been allocated through a memory account as a table,
+// with the counts of each phase in the fields 'parse', 'inlines' and
+// 'render'.
+static int lua_cmark_mem_account_get_usage(lua_State *L)
+{
+        static const char *const phases[CMARK_MEM_PHASES] = {
+                "parse", "inlines", "render"
+        };
+        cmark_mem_account *account;
+        const cmark_mem_usage *usage;
+        int i;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&account,SWIGTYPE_p_cmark_mem_account,0)))
+                return luaL_argerror(L, 1, "expected cmark_mem_account");
+        usage = cmark_mem_account_get_usage(account);
+        lua_createtable(L, 0, 7);
+        lua_cmark_set_number(L, "live", (double)usage->live);
+        lua_cmark_set_number(L, "peak", (double)usage->peak);
+        lua_cmark_set_number(L, "frees", (double)usage->frees);
+        lua_pushboolean(L, usage->exceeded);
+        lua_setfield(L, -2, "exceeded");
+        for (i = 0; i < CMARK_MEM_PHASES; i++) {
+                lua_createtable(L, 0, 3);
+                lua_cmark_set_number(L, "allocations", (double)usage->allocations[i]);
+                lua_cmark_set_number(L, "reallocations", (double)usage->reallocations[i]);
+                lua_cmark_set_number(L, "bytes", (double)usage->bytes[i]);
+                lua_setfield(L, -2, phases[i]);
+        }
+        return 1;
+}
+
+// Sets the resource limits of a parser from a table with any of the
+// fields 'max_depth', 'max_nodes', 'max_delimiters', 'max_output' and
+// 'max_time' (in seconds).
+static int lua_cmark_parser_set_limits(lua_State *L)
+{
+        cmark_parser *parser;
+        cmark_limits limits;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&parser,SWIGTYPE_p_cmark_parser,0)))
+                return luaL_argerror(L, 1, "expected cmark_parser");
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_getfield(L, 2, "max_depth");
+        lua_getfield(L, 2, "max_nodes");
+        lua_getfield(L, 2, "max_delimiters");
+        lua_getfield(L, 2, "max_output");
+        lua_getfield(L, 2, "max_time");
+        limits.max_depth = (int)luaL_optnumber(L, -5, 0);
+        limits.max_nodes = (size_t)luaL_optnumber(L, -4, 0);
+        limits.max_delimiters = (size_t)luaL_optnumber(L, -3, 0);
+        limits.max_output = (size_t)luaL_optnumber(L, -2, 0);
+        limits.max_time = luaL_optnumber(L, -1, 0);
+        lua_pop(L, 5);
+        cmark_parser_set_limits(parser, &limits);
+        return 0;
 }
 %}
 
+%native(node_hash) int lua_cmark_node_hash(lua_State *L);
+%native(node_serialize) int lua_cmark_node_serialize(lua_State *L);
+%native(markdown_to_html_stream) int lua_cmark_markdown_to_html_stream(lua_State *L);
+%native(extract_outline) int lua_cmark_extract_outline(lua_State *L);
+%native(render_json_stream) int lua_cmark_render_json_stream(lua_State *L);
+%native(render_plaintext) int lua_cmark_render_plaintext(lua_State *L);
+%native(render_html_with_hooks) int lua_cmark_render_html_with_hooks(lua_State *L);
+%native(walk) int lua_cmark_walk(lua_State *L);
+%native(to_table) int lua_cmark_to_table(lua_State *L);
+%native(build_node) int lua_cmark_build_node(lua_State *L);
+%native(parse_string_borrowed) int lua_cmark_parse_string_borrowed(lua_State *L);
+%native(node_free) int lua_cmark_node_free(lua_State *L);
+%native(select) int lua_cmark_select(lua_State *L);
+%native(get_stats) int lua_cmark_get_stats(lua_State *L);
+%native(mem_account_get_usage) int lua_cmark_mem_account_get_usage(lua_State *L);
+%native(parser_set_limits) int lua_cmark_parser_set_limits(lua_State *L);
+
 %luacode {
 
 function cmark.parse_string(s, opts)
    return cmark.parse_document(s, string.len(s), opts)
 end
 
-function cmark.walk(node)
-   local iter = cmark.iter_new(node)
-   return function()
-     while true do
-         local et = cmark.iter_next(iter)
-         if et == cmark.EVENT_DONE then break end
-         local cur = cmark.iter_get_node(iter)
-         return cur, (et == cmark.EVENT_ENTER), cmark.node_get_type(cur)
-     end
-     cmark.iter_free(iter)
-     return nil
+-- Replaces the wrapper for cmark_parse_file, which needs a FILE *.
+function cmark.parse_file(path, opts)
+   local doc = cmark.parse_path(path, opts)
+   if not doc then
+      return nil, "could not read " .. tostring(path)
+   end
+   return doc
+end
+
+-- Parses 's' with the allocator 'mem', such as that of a memory
+-- account.  Returns nil and an error message if the account refuses
+-- an allocation.
+function cmark.parse_string_with_mem(s, opts, mem)
+   local parser = cmark.parser_new_with_mem(opts, mem)
+   if not parser then
+      return nil, "memory limit exceeded"
+   end
+   cmark.parser_feed(parser, s, string.len(s))
+   local doc = cmark.parser_finish(parser)
+   cmark.parser_free(parser)
+   if not doc then
+      return nil, "memory limit exceeded"
+   end
+   return doc
+end
+
+local limit_messages = {
+   [cmark.LIMIT_NODES] = "node limit exceeded",
+   [cmark.LIMIT_TIME] = "time limit exceeded",
+   [cmark.LIMIT_OUTPUT] = "output limit exceeded",
+}
+
+-- Parses 's' under the resource limits in the table 'limits' (see
+-- parser_set_limits).  Returns nil and an error message if the parse
+-- goes past the node or time limit.
+function cmark.parse_string_with_limits(s, opts, limits)
+   local parser = cmark.parser_new(opts)
+   cmark.parser_set_limits(parser, limits)
+   cmark.parser_feed(parser, s, string.len(s))
+   local doc = cmark.parser_finish(parser)
+   local exceeded = cmark.parser_get_exceeded_limit(parser)
+   cmark.parser_free(parser)
+   if not doc then
+      return nil, limit_messages[exceeded]
    end
+   return doc
 end
 
 }
@@ -0,0 +1,508 @@
+-- A binding to libcmark through the LuaJIT FFI.  It exposes the same
+-- names as the cmark module, but nodes are FFI pointers rather than
+-- userdata, so calls into libcmark can be compiled by the JIT.  The
+-- library is the one built for the cmark module, and the two bindings
+-- must not be given each other's nodes.
+
+local ffi = require('ffi')
+local bit = require('bit')
+
+ffi.cdef[[
+typedef enum {
+  CMARK_NODE_NONE,
+  CMARK_NODE_DOCUMENT,
+  CMARK_NODE_BLOCK_QUOTE,
+  CMARK_NODE_LIST,
+  CMARK_NODE_ITEM,
+  CMARK_NODE_CODE_BLOCK,
+  CMARK_NODE_HTML_BLOCK,
+  CMARK_NODE_CUSTOM_BLOCK,
+  CMARK_NODE_PARAGRAPH,
+  CMARK_NODE_HEADING,
+  CMARK_NODE_THEMATIC_BREAK,
+  CMARK_NODE_TEXT,
+  CMARK_NODE_SOFTBREAK,
+  CMARK_NODE_LINEBREAK,
+  CMARK_NODE_CODE,
+  CMARK_NODE_HTML_INLINE,
+  CMARK_NODE_CUSTOM_INLINE,
+  CMARK_NODE_EMPH,
+  CMARK_NODE_STRONG,
+  CMARK_NODE_LINK,
+  CMARK_NODE_IMAGE
+} cmark_node_type;
+
+typedef struct cmark_stats {
+  uint64_t block_ns;
+  uint64_t reference_ns;
+  uint64_t inline_ns;
+  uint64_t emphasis_ns;
+  uint64_t render_ns;
+  size_t lines;
+  size_t nodes[CMARK_NODE_IMAGE + 1];
+  size_t delimiters_pushed;
+  size_t delimiters_processed;
+  size_t references_defined;
+  size_t references_looked_up;
+  size_t renders;
+  size_t output_bytes;
+} cmark_stats;
+
+typedef struct cmark_limits {
+  int max_depth;
+  size_t max_nodes;
+  size_t max_delimiters;
+  size_t max_output;
+  double max_time;
+} cmark_limits;
+
+typedef enum {
+  CMARK_LIMIT_NONE,
+  CMARK_LIMIT_NODES,
+  CMARK_LIMIT_TIME,
+  CMARK_LIMIT_OUTPUT
+} cmark_limit;
+
+typedef enum {
+  CMARK_NO_LIST,
+  CMARK_BULLET_LIST,
+  CMARK_ORDERED_LIST
+} cmark_list_type;
+
+typedef enum {
+  CMARK_NO_DELIM,
+  CMARK_PERIOD_DELIM,
+  CMARK_PAREN_DELIM
+} cmark_delim_type;
+
+typedef enum {
+  CMARK_EVENT_NONE,
+  CMARK_EVENT_DONE,
+  CMARK_EVENT_ENTER,
+  CMARK_EVENT_EXIT
+} cmark_event_type;
+
+typedef enum {
+  CMARK_HTML_CACHE_LRU,
+  CMARK_HTML_CACHE_FIFO
+} cmark_html_cache_policy;
+
+typedef struct cmark_node cmark_node;
+typedef struct cmark_parser cmark_parser;
+typedef struct cmark_iter cmark_iter;
+typedef struct cmark_html_cache cmark_html_cache;
+typedef struct cmark_outline cmark_outline;
+typedef struct cmark_mem {
+  void *(*calloc)(size_t, size_t);
+  void *(*realloc)(void *, size_t);
+  void (*free)(void *);
+} cmark_mem;
+
+char *cmark_markdown_to_html(const char *text, size_t len, int options);
+
+cmark_node *cmark_node_new(cmark_node_type type);
+cmark_node *cmark_node_new_with_mem(cmark_node_type type, cmark_mem *mem);
+void cmark_node_free(cmark_node *node);
+cmark_mem *cmark_node_get_mem(cmark_node *node);
+cmark_node *cmark_node_next(cmark_node *node);
+cmark_node *cmark_node_previous(cmark_node *node);
+cmark_node *cmark_node_parent(cmark_node *node);
+cmark_node *cmark_node_first_child(cmark_node *node);
+cmark_node *cmark_node_last_child(cmark_node *node);
+
+cmark_iter *cmark_iter_new(cmark_node *root);
+cmark_iter *cmark_iter_new_with_mem(cmark_node *root, cmark_mem *mem);
+void cmark_iter_free(cmark_iter *iter);
+cmark_event_type cmark_iter_next(cmark_iter *iter);
+cmark_node *cmark_iter_get_node(cmark_iter *iter);
+cmark_event_type cmark_iter_get_event_type(cmark_iter *iter);
+cmark_node *cmark_iter_get_root(cmark_iter *iter);
+void cmark_iter_reset(cmark_iter *iter, cmark_node *current,
+                      cmark_event_type event_type);
+
+void *cmark_node_get_user_data(cmark_node *node);
+int cmark_node_set_user_data(cmark_node *node, void *user_data);
+cmark_node_type cmark_node_get_type(cmark_node *node);
+const char *cmark_node_get_type_string(cmark_node *node);
+const char *cmark_node_get_literal(cmark_node *node);
+int cmark_node_set_literal(cmark_node *node, const char *content);
+int cmark_node_get_heading_level(cmark_node *node);
+int cmark_node_set_heading_level(cmark_node *node, int level);
+cmark_list_type cmark_node_get_list_type(cmark_node *node);
+int cmark_node_set_list_type(cmark_node *node, cmark_list_type type);
+cmark_delim_type cmark_node_get_list_delim(cmark_node *node);
+int cmark_node_set_list_delim(cmark_node *node, cmark_delim_type delim);
+int cmark_node_get_list_start(cmark_node *node);
+int cmark_node_set_list_start(cmark_node *node, int start);
+int cmark_node_get_list_tight(cmark_node *node);
+int cmark_node_set_list_tight(cmark_node *node, int tight);
+const char *cmark_node_get_fence_info(cmark_node *node);
+int cmark_node_set_fence_info(cmark_node *node, const char *info);
+const char *cmark_node_get_url(cmark_node *node);
+int cmark_node_set_url(cmark_node *node, const char *url);
+const char *cmark_node_get_title(cmark_node *node);
+int cmark_node_set_title(cmark_node *node, const char *title);
+const char *cmark_node_get_on_enter(cmark_node *node);
+int cmark_node_set_on_enter(cmark_node *node, const char *on_enter);
+const char *cmark_node_get_on_exit(cmark_node *node);
+int cmark_node_set_on_exit(cmark_node *node, const char *on_exit);
+int cmark_node_get_start_line(cmark_node *node);
+int cmark_node_get_start_column(cmark_node *node);
+int cmark_node_get_end_line(cmark_node *node);
+int cmark_node_get_end_column(cmark_node *node);
+
+void cmark_node_unlink(cmark_node *node);
+int cmark_node_insert_before(cmark_node *node, cmark_node *sibling);
+int cmark_node_insert_after(cmark_node *node, cmark_node *sibling);
+int cmark_node_replace(cmark_node *oldnode, cmark_node *newnode);
+int cmark_node_prepend_child(cmark_node *node, cmark_node *child);
+int cmark_node_append_child(cmark_node *node, cmark_node *child);
+void cmark_consolidate_text_nodes(cmark_node *root);
+
+uint64_t cmark_node_hash(cmark_node *node);
+char *cmark_node_serialize(cmark_node *root, size_t *len);
+cmark_node *cmark_node_deserialize(const char *buffer, size_t len);
+cmark_node **cmark_node_select(cmark_node *root, unsigned int type_mask,
+                               size_t max, size_t *count);
+const cmark_stats *cmark_node_get_stats(cmark_node *node);
+
+cmark_parser *cmark_parser_new(int options);
+cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem);
+void cmark_parser_free(cmark_parser *parser);
+void cmark_parser_feed(cmark_parser *parser, const char *buffer, size_t len);
+cmark_node *cmark_parser_finish(cmark_parser *parser);
+void cmark_parser_set_limits(cmark_parser *parser, const cmark_limits *limits);
+cmark_limit cmark_parser_get_exceeded_limit(cmark_parser *parser);
+cmark_limit cmark_node_get_exceeded_limit(cmark_node *node);
+cmark_node *cmark_parse_document(const char *buffer, size_t len, int options);
+cmark_node *cmark_parse_fd(int fd, int options);
+cmark_node *cmark_parse_path(const char *path, int options);
+
+char *cmark_render_xml(cmark_node *root, int options);
+char *cmark_render_json(cmark_node *root, int options);
+char *cmark_render_plaintext(cmark_node *root, int options,
+                             const char *separator);
+char *cmark_render_html(cmark_node *root, int options);
+char *cmark_render_man(cmark_node *root, int options, int width);
+char *cmark_render_commonmark(cmark_node *root, int options, int width);
+char *cmark_render_latex(cmark_node *root, int options, int width);
+
+cmark_html_cache *cmark_html_cache_new(int capacity);
+cmark_html_cache *cmark_html_cache_new_with_mem(int capacity, cmark_mem *mem);
+void cmark_html_cache_free(cmark_html_cache *cache);
+void cmark_html_cache_clear(cmark_html_cache *cache);
+int cmark_html_cache_get_capacity(cmark_html_cache *cache);
+int cmark_html_cache_set_capacity(cmark_html_cache *cache, int capacity);
+cmark_html_cache_policy cmark_html_cache_get_policy(cmark_html_cache *cache);
+int cmark_html_cache_set_policy(cmark_html_cache *cache,
+                                cmark_html_cache_policy policy);
+int cmark_html_cache_get_size(cmark_html_cache *cache);
+size_t cmark_html_cache_get_hits(cmark_html_cache *cache);
+size_t cmark_html_cache_get_misses(cmark_html_cache *cache);
+size_t cmark_html_cache_get_evictions(cmark_html_cache *cache);
+char *cmark_render_html_cached(cmark_node *root, int options,
+                               cmark_html_cache *cache);
+
+cmark_outline *cmark_extract_outline(const char *buffer, size_t len,
+                                     int options);
+void cmark_outline_free(cmark_outline *outline);
+int cmark_outline_get_length(cmark_outline *outline);
+int cmark_outline_get_level(cmark_outline *outline, int i);
+const char *cmark_outline_get_text(cmark_outline *outline, int i);
+const char *cmark_outline_get_slug(cmark_outline *outline, int i);
+int cmark_outline_get_start_line(cmark_outline *outline, int i);
+
+int cmark_version(void);
+const char *cmark_version_string(void);
+
+void free(void *ptr);
+]]
+
+local C = ffi.load(assert(package.searchpath('cmark', package.cpath),
+                          "cmark library not found in package.cpath"))
+
+local cmark = {}
+
+for _, name in ipairs({
+    "NODE_NONE", "NODE_DOCUMENT", "NODE_BLOCK_QUOTE", "NODE_LIST",
+    "NODE_ITEM", "NODE_CODE_BLOCK", "NODE_HTML_BLOCK", "NODE_CUSTOM_BLOCK",
+    "NODE_PARAGRAPH", "NODE_HEADING", "NODE_THEMATIC_BREAK", "NODE_TEXT",
+    "NODE_SOFTBREAK", "NODE_LINEBREAK", "NODE_CODE", "NODE_HTML_INLINE",
+    "NODE_CUSTOM_INLINE", "NODE_EMPH", "NODE_STRONG", "NODE_LINK",
+    "NODE_IMAGE", "NO_LIST", "BULLET_LIST", "ORDERED_LIST", "NO_DELIM",
+    "PERIOD_DELIM", "PAREN_DELIM", "EVENT_NONE", "EVENT_DONE",
+    "EVENT_ENTER", "EVENT_EXIT", "HTML_CACHE_LRU", "HTML_CACHE_FIFO",
+    "LIMIT_NONE", "LIMIT_NODES", "LIMIT_TIME", "LIMIT_OUTPUT" }) do
+  cmark[name] = tonumber(C["CMARK_" .. name])
+end
+cmark.NODE_FIRST_BLOCK = cmark.NODE_DOCUMENT
+cmark.NODE_LAST_BLOCK = cmark.NODE_THEMATIC_BREAK
+cmark.NODE_FIRST_INLINE = cmark.NODE_TEXT
+cmark.NODE_LAST_INLINE = cmark.NODE_IMAGE
+
+cmark.OPT_DEFAULT = 0
+cmark.OPT_SOURCEPOS = 2
+cmark.OPT_HARDBREAKS = 4
+cmark.OPT_SAFE = 8
+cmark.OPT_NOBREAKS = 16
+cmark.OPT_NORMALIZE = 256
+cmark.OPT_VALIDATE_UTF8 = 512
+cmark.OPT_SMART = 1024
+cmark.OPT_REFERENCES_FIRST = 2048
+cmark.OPT_LAZY_INLINES = 4096
+cmark.OPT_NODE_INDEX = 8192
+cmark.OPT_STATS = 16384
+
+-- Functions whose results need no conversion are called directly.
+for _, name in ipairs({
+    "node_free", "iter_free", "iter_next", "iter_get_event_type",
+    "iter_reset", "node_get_user_data", "node_set_user_data",
+    "node_get_type", "node_set_literal", "node_get_heading_level",
+    "node_set_heading_level", "node_get_list_type", "node_set_list_type",
+    "node_get_list_delim", "node_set_list_delim", "node_get_list_start",
+    "node_set_list_start", "node_get_list_tight", "node_set_list_tight",
+    "node_set_fence_info", "node_set_url", "node_set_title",
+    "node_set_on_enter", "node_set_on_exit", "node_get_start_line",
+    "node_get_start_column", "node_get_end_line", "node_get_end_column",
+    "node_unlink", "node_insert_before", "node_insert_after",
+    "node_replace", "node_prepend_child", "node_append_child",
+    "consolidate_text_nodes", "parser_new", "parser_new_with_mem",
+    "parser_free", "parser_feed", "html_cache_new", "html_cache_new_with_mem",
+    "html_cache_free", "html_cache_clear", "html_cache_get_capacity",
+    "html_cache_set_capacity", "html_cache_get_policy",
+    "html_cache_set_policy", "html_cache_get_size", "version" }) do
+  cmark[name] = C["cmark_" .. name]
+end
+
+-- A NULL pointer is true in Lua, so functions that return nodes return
+-- nil instead, as the cmark module does.
+local function node_or_nil(f)
+  return function(...)
+    local node = f(...)
+    if node ~= nil then
+      return node
+    end
+  end
+end
+
+for _, name in ipairs({
+    "node_new", "node_new_with_mem", "node_next", "node_previous",
+    "node_parent", "node_first_child", "node_last_child", "iter_new",
+    "iter_new_with_mem", "iter_get_node", "iter_get_root",
+    "node_deserialize", "parser_finish", "parse_document", "parse_fd",
+    "parse_path" }) do
+  cmark[name] = node_or_nil(C["cmark_" .. name])
+end
+
+-- Strings owned by libcmark are copied into Lua strings.
+for _, name in ipairs({
+    "node_get_type_string", "node_get_literal", "node_get_fence_info",
+    "node_get_url", "node_get_title", "node_get_on_enter",
+    "node_get_on_exit", "version_string" }) do
+  local f = C["cmark_" .. name]
+  cmark[name] = function(...)
+    local s = f(...)
+    if s ~= nil then
+      return ffi.string(s)
+    end
+  end
+end
+
+-- Frees memory that libcmark allocated for the document of 'node',
+-- which may use a custom allocator or a memory account.
+local function free_with_node_mem(node, ptr)
+  C.cmark_node_get_mem(node).free(ptr)
+end
+
+function cmark.markdown_to_html(text, len, opts)
+  local s = C.cmark_markdown_to_html(text, len, opts)
+  if s == nil then
+    return nil
+  end
+  local result = ffi.string(s)
+  C.free(s)
+  return result
+end
+
+-- Strings allocated by libcmark are copied and freed.  Renderers
+-- return NULL past the output limit of the document.
+for _, name in ipairs({
+    "render_xml", "render_json", "render_html", "render_man",
+    "render_commonmark", "render_latex", "render_html_cached" }) do
+  local f = C["cmark_" .. name]
+  cmark[name] = function(node, ...)
+    local s = f(node, ...)
+    if s == nil then
+      return nil
+    end
+    local result = ffi.string(s)
+    free_with_node_mem(node, s)
+    return result
+  end
+end
+
+for _, name in ipairs({
+    "parser_get_exceeded_limit", "node_get_exceeded_limit" }) do
+  local f = C["cmark_" .. name]
+  cmark[name] = function(x)
+    return tonumber(f(x))
+  end
+end
+
+for _, name in ipairs({
+    "html_cache_get_hits", "html_cache_get_misses",
+    "html_cache_get_evictions" }) do
+  local f = C["cmark_" .. name]
+  cmark[name] = function(cache)
+    return tonumber(f(cache))
+  end
+end
+
+function cmark.render_plaintext(node, opts, separator)
+  local s = C.cmark_render_plaintext(node, opts or 0, separator)
+  if s == nil then
+    return nil, "output limit exceeded"
+  end
+  local result = ffi.string(s)
+  free_with_node_mem(node, s)
+  return result
+end
+
+function cmark.node_hash(node)
+  local h = C.cmark_node_hash(node)
+  return string.format("%08x%08x", tonumber(h / 0x100000000ULL),
+                       tonumber(h % 0x100000000ULL))
+end
+
+local serialized_len = ffi.new("size_t[1]")
+
+function cmark.node_serialize(node)
+  local buf = C.cmark_node_serialize(node, serialized_len)
+  local result = ffi.string(buf, serialized_len[0])
+  free_with_node_mem(node, buf)
+  return result
+end
+
+local selected_count = ffi.new("size_t[1]")
+
+function cmark.select(node, types, max)
+  local mask = 0
+  if type(types) == "table" then
+    for _, t in ipairs(types) do
+      mask = bit.bor(mask, bit.lshift(1, t))
+    end
+  else
+    mask = bit.lshift(1, types)
+  end
+  local nodes = C.cmark_node_select(node, mask, max or 0, selected_count)
+  local result = {}
+  for i = 0, tonumber(selected_count[0]) - 1 do
+    result[i + 1] = nodes[i]
+  end
+  free_with_node_mem(node, nodes)
+  return result
+end
+
+function cmark.get_stats(node)
+  local stats = C.cmark_node_get_stats(node)
+  if stats == nil then
+    return nil
+  end
+  local nodes = {}
+  for t = cmark.NODE_FIRST_BLOCK, cmark.NODE_LAST_INLINE do
+    nodes[t] = tonumber(stats.nodes[t])
+  end
+  return {
+    block_time = tonumber(stats.block_ns) / 1e9,
+    reference_time = tonumber(stats.reference_ns) / 1e9,
+    inline_time = tonumber(stats.inline_ns) / 1e9,
+    emphasis_time = tonumber(stats.emphasis_ns) / 1e9,
+    render_time = tonumber(stats.render_ns) / 1e9,
+    lines = tonumber(stats.lines),
+    nodes = nodes,
+    delimiters_pushed = tonumber(stats.delimiters_pushed),
+    delimiters_processed = tonumber(stats.delimiters_processed),
+    references_defined = tonumber(stats.references_defined),
+    references_looked_up = tonumber(stats.references_looked_up),
+    renders = tonumber(stats.renders),
+    output_bytes = tonumber(stats.output_bytes),
+  }
+end
+
+local limits = ffi.new("cmark_limits")
+
+function cmark.parser_set_limits(parser, t)
+  limits.max_depth = t.max_depth or 0
+  limits.max_nodes = t.max_nodes or 0
+  limits.max_delimiters = t.max_delimiters or 0
+  limits.max_output = t.max_output or 0
+  limits.max_time = t.max_time or 0
+  C.cmark_parser_set_limits(parser, limits)
+end
+
+local limit_messages = {
+  [cmark.LIMIT_NODES] = "node limit exceeded",
+  [cmark.LIMIT_TIME] = "time limit exceeded",
+  [cmark.LIMIT_OUTPUT] = "output limit exceeded",
+}
+
+function cmark.parse_string_with_limits(s, opts, t)
+  local parser = C.cmark_parser_new(opts or 0)
+  cmark.parser_set_limits(parser, t)
+  C.cmark_parser_feed(parser, s, #s)
+  local doc = C.cmark_parser_finish(parser)
+  local exceeded = tonumber(C.cmark_parser_get_exceeded_limit(parser))
+  C.cmark_parser_free(parser)
+  if doc == nil then
+    return nil, limit_messages[exceeded]
+  end
+  return doc
+end
+
+function cmark.extract_outline(s, opts)
+  local outline = C.cmark_extract_outline(s, #s, opts or 0)
+  local result = {}
+  for i = 0, C.cmark_outline_get_length(outline) - 1 do
+    result[i + 1] = {
+      level = C.cmark_outline_get_level(outline, i),
+      text = ffi.string(C.cmark_outline_get_text(outline, i)),
+      slug = ffi.string(C.cmark_outline_get_slug(outline, i)),
+      start_line = C.cmark_outline_get_start_line(outline, i),
+    }
+  end
+  C.cmark_outline_free(outline)
+  return result
+end
+
+function cmark.parse_string(s, opts)
+  return cmark.parse_document(s, #s, opts)
+end
+
+function cmark.parse_file(path, opts)
+  local doc = cmark.parse_path(path, opts)
+  if not doc then
+    return nil, "could not read " .. tostring(path)
+  end
+  return doc
+end
+
+-- Returns an iterator over the nodes under 'node', giving the node,
+-- whether it is being entered and its type at each step.  The C
+-- iterator is freed when the walk ends, or when it is collected if
+-- the loop is left early.
+function cmark.walk(node)
+  local iter = ffi.gc(C.cmark_iter_new(node), C.cmark_iter_free)
+  return function()
+    local ev_type = C.cmark_iter_next(iter)
+    if ev_type == C.CMARK_EVENT_DONE then
+      C.cmark_iter_free(ffi.gc(iter, nil))
+      iter = nil
+      return nil
+    end
+    local cur = C.cmark_iter_get_node(iter)
+    return cur, ev_type == C.CMARK_EVENT_ENTER,
+           tonumber(C.cmark_node_get_type(cur))
+  end
+end
+
+return cmark
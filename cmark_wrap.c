@@ -2654,18 +2654,21 @@ SWIG_Lua_dostring(lua_State *L, const char *str) {
 #define SWIGTYPE_p_FILE swig_types[0]
 #define SWIGTYPE_p_cmark_delim_type swig_types[1]
 #define SWIGTYPE_p_cmark_event_type swig_types[2]
-#define SWIGTYPE_p_cmark_iter swig_types[3]
-#define SWIGTYPE_p_cmark_list_type swig_types[4]
-#define SWIGTYPE_p_cmark_mem swig_types[5]
-#define SWIGTYPE_p_cmark_node swig_types[6]
-#define SWIGTYPE_p_cmark_node_type swig_types[7]
-#define SWIGTYPE_p_cmark_parser swig_types[8]
-#define SWIGTYPE_p_f_p_void__void swig_types[9]
-#define SWIGTYPE_p_f_p_void_size_t__p_void swig_types[10]
-#define SWIGTYPE_p_f_size_t_size_t__p_void swig_types[11]
-#define SWIGTYPE_p_void swig_types[12]
-static swig_type_info *swig_types[14];
-static swig_module_info swig_module = {swig_types, 13, 0, 0, 0, 0};
+#define SWIGTYPE_p_cmark_html_cache swig_types[3]
+#define SWIGTYPE_p_cmark_html_cache_policy swig_types[4]
+#define SWIGTYPE_p_cmark_iter swig_types[5]
+#define SWIGTYPE_p_cmark_list_type swig_types[6]
+#define SWIGTYPE_p_cmark_mem swig_types[7]
+#define SWIGTYPE_p_cmark_mem_account swig_types[8]
+#define SWIGTYPE_p_cmark_node swig_types[9]
+#define SWIGTYPE_p_cmark_node_type swig_types[10]
+#define SWIGTYPE_p_cmark_parser swig_types[11]
+#define SWIGTYPE_p_f_p_void__void swig_types[12]
+#define SWIGTYPE_p_f_p_void_size_t__p_void swig_types[13]
+#define SWIGTYPE_p_f_size_t_size_t__p_void swig_types[14]
+#define SWIGTYPE_p_void swig_types[15]
+static swig_type_info *swig_types[17];
+static swig_module_info swig_module = {swig_types, 16, 0, 0, 0, 0};
 #define SWIG_TypeQuery(name) SWIG_TypeQueryModule(&swig_module, &swig_module, name)
 #define SWIG_MangledTypeQuery(name) SWIG_MangledTypeQueryModule(&swig_module, &swig_module, name)
 
@@ -2688,9 +2691,1207 @@ SWIGINTERN int SWIG_lua_isnilstring(lua_State *L, int idx) {
 }
 
 
+// Registry key of the weak-valued table that maps node addresses to
+// their userdata.
+static const char lua_cmark_nodes_key = 0;
+
+// Pushes the userdata of a node, so that there is at most one userdata
+// per node.  An entry in the table is only reused if the node is
+// marked as having one: a node allocated at the address of a freed
+// one is not.
 extern void push_cmark_node(lua_State *L, cmark_node *node)
 {
+        if (node == NULL) {
+                lua_pushnil(L);
+                return;
+        }
+        lua_pushlightuserdata(L, (void *)&lua_cmark_nodes_key);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_newtable(L);
+                lua_pushliteral(L, "v");
+                lua_setfield(L, -2, "__mode");
+                lua_setmetatable(L, -2);
+                lua_pushlightuserdata(L, (void *)&lua_cmark_nodes_key);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+        if (cmark_node_mark_handle(node)) {
+                lua_pushlightuserdata(L, node);
+                lua_rawget(L, -2);
+                if (!lua_isnil(L, -1)) {
+                        lua_remove(L, -2);
+                        return;
+                }
+                lua_pop(L, 1);
+        }
         SWIG_NewPointerObj(L,node,SWIGTYPE_p_cmark_node,0);
+        lua_pushlightuserdata(L, node);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+        lua_remove(L, -2);
+}
+
+// Returns the structural hash of a node as a 16-digit hex string.
+static int lua_cmark_node_hash(lua_State *L)
+{
+        cmark_node *node;
+        char hex[17];
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        snprintf(hex, sizeof(hex), "%016llx",
+                 (unsigned long long)cmark_node_hash(node));
+        lua_pushstring(L, hex);
+        return 1;
+}
+
+// Returns the serialized form of a node as a (binary) string.
+static int lua_cmark_node_serialize(lua_State *L)
+{
+        cmark_node *node;
+        char *buf;
+        size_t len;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        buf = cmark_node_serialize(node, &len);
+        lua_pushlstring(L, buf, len);
+        cmark_node_get_mem(node)->free(buf);
+        return 1;
+}
+
+struct lua_cmark_sink {
+        lua_State *L;
+        int status;
+};
+
+// Passes a piece of output to the function at index 3, stopping at the
+// first error, which is left on the stack.
+static void lua_cmark_sink(const char *data, size_t len, void *userdata)
+{
+        struct lua_cmark_sink *sink = (struct lua_cmark_sink *)userdata;
+
+        if (sink->status != 0)
+                return;
+        lua_pushvalue(sink->L, 3);
+        lua_pushlstring(sink->L, data, len);
+        sink->status = lua_pcall(sink->L, 1, 0, 0);
+}
+
+// Parses a string, calling a function with the HTML of each top-level
+// block as soon as it is available.
+static int lua_cmark_markdown_to_html_stream(lua_State *L)
+{
+        struct lua_cmark_sink sink;
+        cmark_parser *parser;
+        const char *s;
+        size_t len;
+        int options;
+
+        s = luaL_checklstring(L, 1, &len);
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TFUNCTION);
+        lua_settop(L, 3);
+
+        sink.L = L;
+        sink.status = 0;
+        parser = cmark_parser_new(options);
+        cmark_parser_set_html_sink(parser, lua_cmark_sink, &sink);
+        cmark_parser_feed(parser, s, len);
+        cmark_node_free(cmark_parser_finish(parser));
+        cmark_parser_free(parser);
+
+        if (sink.status != 0)
+                return lua_error(L);
+        return 0;
+}
+
+// Returns the headings of a string as a list of tables with the
+// fields level, text, slug and start_line.
+static int lua_cmark_extract_outline(lua_State *L)
+{
+        cmark_outline *outline;
+        const char *s;
+        size_t len;
+        int i, n;
+
+        s = luaL_checklstring(L, 1, &len);
+        outline = cmark_extract_outline(s, len,
+                        (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT));
+        n = cmark_outline_get_length(outline);
+        lua_createtable(L, n, 0);
+        for (i = 0; i < n; i++) {
+                lua_createtable(L, 0, 4);
+                lua_pushinteger(L, cmark_outline_get_level(outline, i));
+                lua_setfield(L, -2, "level");
+                lua_pushstring(L, cmark_outline_get_text(outline, i));
+                lua_setfield(L, -2, "text");
+                lua_pushstring(L, cmark_outline_get_slug(outline, i));
+                lua_setfield(L, -2, "slug");
+                lua_pushinteger(L, cmark_outline_get_start_line(outline, i));
+                lua_setfield(L, -2, "start_line");
+                lua_rawseti(L, -2, i + 1);
+        }
+        cmark_outline_free(outline);
+        return 1;
+}
+
+// Renders a node as JSON, calling a function with each piece of the
+// output as it is rendered.  Returns true, or nil and an error message
+// if the rendering stopped at the output limit.
+static int lua_cmark_render_json_stream(lua_State *L)
+{
+        struct lua_cmark_sink sink;
+        cmark_node *node;
+        int options, complete;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TFUNCTION);
+        lua_settop(L, 3);
+
+        sink.L = L;
+        sink.status = 0;
+        complete = cmark_render_json_to_sink(node, options, lua_cmark_sink,
+                        &sink);
+
+        if (sink.status != 0)
+                return lua_error(L);
+        if (!complete) {
+                lua_pushnil(L);
+                lua_pushliteral(L, "output limit exceeded");
+                return 2;
+        }
+        lua_pushboolean(L, 1);
+        return 1;
+}
+
+struct lua_cmark_plaintext {
+        lua_State *L;
+        int pieces;
+        int anchors;
+};
+
+// Adds a piece of text to the table at index 5.
+static void lua_cmark_plaintext_piece(const char *data, size_t len, void *userdata)
+{
+        struct lua_cmark_plaintext *pt = (struct lua_cmark_plaintext *)userdata;
+
+        lua_pushlstring(pt->L, data, len);
+        lua_rawseti(pt->L, 5, ++pt->pieces);
+}
+
+// Adds an anchor to the table at index 6.
+static void lua_cmark_plaintext_anchor(size_t offset, int line, void *userdata)
+{
+        struct lua_cmark_plaintext *pt = (struct lua_cmark_plaintext *)userdata;
+
+        lua_createtable(pt->L, 0, 2);
+        lua_pushinteger(pt->L, (lua_Integer)offset);
+        lua_setfield(pt->L, -2, "offset");
+        lua_pushinteger(pt->L, line);
+        lua_setfield(pt->L, -2, "line");
+        lua_rawseti(pt->L, 6, ++pt->anchors);
+}
+
+// Returns the text content of a node and, if the fourth argument is
+// true, a list of anchors with the fields offset and line, or nil and
+// an error message past the output limit.
+static int lua_cmark_render_plaintext(lua_State *L)
+{
+        struct lua_cmark_plaintext pt;
+        cmark_node *node;
+        const char *separator;
+        int options, want_anchors, i;
+        luaL_Buffer b;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        separator = luaL_optstring(L, 3, NULL);
+        want_anchors = lua_toboolean(L, 4);
+        lua_settop(L, 4);
+        lua_newtable(L);
+        lua_newtable(L);
+
+        pt.L = L;
+        pt.pieces = 0;
+        pt.anchors = 0;
+        if (!cmark_render_plaintext_to_sink(node, options, separator,
+                        lua_cmark_plaintext_piece,
+                        want_anchors ? lua_cmark_plaintext_anchor : NULL, &pt)) {
+                lua_pushnil(L);
+                lua_pushliteral(L, "output limit exceeded");
+                return 2;
+        }
+
+        luaL_buffinit(L, &b);
+        for (i = 1; i <= pt.pieces; i++) {
+                lua_rawgeti(L, 5, i);
+                luaL_addvalue(&b);
+        }
+        luaL_pushresult(&b);
+        if (!want_anchors)
+                return 1;
+        lua_pushvalue(L, 6);
+        return 2;
+}
+
+struct lua_cmark_hooks {
+        lua_State *L;
+        int status;
+};
+
+// Calls the function for the type of 'node' in the table at index 3
+// with the node, whether it is being entered and the options.  A
+// string result replaces the node's HTML; a true second result skips
+// its children too.  The first error is left on the stack.
+static cmark_html_hook_result lua_cmark_html_hook(cmark_node *node,
+                cmark_event_type ev_type, int options,
+                cmark_html_output *out, void *userdata)
+{
+        struct lua_cmark_hooks *hooks = (struct lua_cmark_hooks *)userdata;
+        lua_State *L = hooks->L;
+        cmark_html_hook_result result = CMARK_HTML_HOOK_DEFAULT;
+        const char *s;
+        size_t len;
+
+        if (hooks->status != 0)
+                return result;
+        lua_rawgeti(L, 3, cmark_node_get_type(node));
+        push_cmark_node(L, node);
+        lua_pushboolean(L, ev_type == CMARK_EVENT_ENTER);
+        lua_pushinteger(L, options);
+        hooks->status = lua_pcall(L, 3, 2, 0);
+        if (hooks->status != 0)
+                return result;
+        s = lua_tolstring(L, -2, &len);
+        if (s != NULL) {
+                cmark_html_output_put(out, s, len);
+                result = lua_toboolean(L, -1) ? CMARK_HTML_HOOK_SKIP
+                                              : CMARK_HTML_HOOK_REPLACE;
+        }
+        lua_pop(L, 2);
+        return result;
+}
+
+// Renders a node as HTML, calling the functions in a table keyed by
+// node type for nodes of those types.
+static int lua_cmark_render_html_with_hooks(lua_State *L)
+{
+        struct lua_cmark_hooks data;
+        cmark_html_hooks *hooks;
+        cmark_node *node;
+        lua_Integer type;
+        char *html;
+        int options;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        luaL_checktype(L, 3, LUA_TTABLE);
+        lua_settop(L, 3);
+
+        data.L = L;
+        data.status = 0;
+        hooks = cmark_html_hooks_new();
+        lua_pushnil(L);
+        while (lua_next(L, 3) != 0) {
+                type = lua_type(L, -2) == LUA_TNUMBER ? lua_tointeger(L, -2) : 0;
+                if (!lua_isfunction(L, -1) ||
+                    !cmark_html_hooks_set(hooks, (cmark_node_type)type,
+                                          lua_cmark_html_hook, &data)) {
+                        cmark_html_hooks_free(hooks);
+                        return luaL_argerror(L, 3,
+                                        "expected functions keyed by node type");
+                }
+                lua_pop(L, 1);
+        }
+
+        html = cmark_render_html_with_hooks(node, options, hooks);
+        cmark_html_hooks_free(hooks);
+        if (data.status != 0) {
+                cmark_node_get_mem(node)->free(html);
+                return lua_error(L);
+        }
+        lua_pushstring(L, html);
+        cmark_node_get_mem(node)->free(html);
+        return 1;
+}
+
+// State of a cmark.walk loop.  The iterator is freed as soon as the
+// walk is over, or else when the state is closed (by leaving the loop
+// early, in Lua 5.4) or collected.
+struct lua_cmark_walk {
+        cmark_iter *iter;
+};
+
+static int lua_cmark_walk_close(lua_State *L)
+{
+        struct lua_cmark_walk *walk = (struct lua_cmark_walk *)lua_touserdata(L, 1);
+
+        if (walk->iter != NULL) {
+                cmark_iter_free(walk->iter);
+                walk->iter = NULL;
+        }
+        return 0;
+}
+
+// Pushes a new walk state, with no iterator yet.
+static struct lua_cmark_walk *lua_cmark_push_walk(lua_State *L)
+{
+        struct lua_cmark_walk *walk;
+
+        walk = (struct lua_cmark_walk *)lua_newuserdata(L, sizeof(*walk));
+        walk->iter = NULL;
+        if (luaL_newmetatable(L, "cmark.walk")) {
+                lua_pushcfunction(L, lua_cmark_walk_close);
+                lua_setfield(L, -2, "__gc");
+                lua_pushcfunction(L, lua_cmark_walk_close);
+                lua_setfield(L, -2, "__close");
+        }
+        lua_setmetatable(L, -2);
+        return walk;
+}
+
+// Returns the node, whether it is being entered and its type for each
+// step of a walk, or nothing at the end.  The upvalue is the walk state.
+static int lua_cmark_walk_next(lua_State *L)
+{
+        struct lua_cmark_walk *walk =
+                (struct lua_cmark_walk *)lua_touserdata(L, lua_upvalueindex(1));
+        cmark_event_type ev_type;
+        cmark_node_type type;
+        cmark_node *cur;
+
+        if (walk->iter == NULL)
+                return 0;
+        ev_type = cmark_iter_next(walk->iter);
+        if (ev_type == CMARK_EVENT_DONE) {
+                cmark_iter_free(walk->iter);
+                walk->iter = NULL;
+                return 0;
+        }
+        cur = cmark_iter_get_node(walk->iter);
+        type = cmark_node_get_type(cur);
+
+        push_cmark_node(L, cur);
+        lua_pushboolean(L, ev_type == CMARK_EVENT_ENTER);
+        lua_pushinteger(L, type);
+        return 3;
+}
+
+// Returns an iterator over the nodes under a node, for use in a generic
+// for loop, and the walk state as a to-be-closed value.
+static int lua_cmark_walk(lua_State *L)
+{
+        extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+        struct lua_cmark_walk *walk;
+        cmark_node *node;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+
+        walk = lua_cmark_push_walk(L);
+        // Allocated outside the node's memory account, which may be
+        // freed before a walk left early is collected.
+        walk->iter = cmark_iter_new_with_mem(node, &DEFAULT_MEM_ALLOCATOR);
+
+        lua_pushvalue(L, -1);
+        lua_pushcclosure(L, lua_cmark_walk_next, 1);
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lua_pushvalue(L, -4);
+        return 4;
+}
+
+// Nodes that the iterator enters but never exits.
+static int lua_cmark_is_leaf(cmark_node_type type)
+{
+        switch (type) {
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_THEMATIC_BREAK:
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_SOFTBREAK:
+        case CMARK_NODE_LINEBREAK:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return 1;
+        default:
+                return 0;
+        }
+}
+
+// Number of fields that lua_cmark_node_fields sets for a node, not
+// counting its children.
+static int lua_cmark_field_count(cmark_node *node, int options)
+{
+        int n = 1;
+
+        if ((options & CMARK_OPT_SOURCEPOS) && cmark_node_get_start_line(node) != 0)
+                n++;
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                return n + 4;
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                return n + 2;
+        case CMARK_NODE_HEADING:
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return n + 1;
+        default:
+                return n;
+        }
+}
+
+static void lua_cmark_set_string(lua_State *L, const char *key, const char *value)
+{
+        lua_pushstring(L, value);
+        lua_setfield(L, -2, key);
+}
+
+static void lua_cmark_set_integer(lua_State *L, const char *key, int value)
+{
+        lua_pushinteger(L, value);
+        lua_setfield(L, -2, key);
+}
+
+// Sets the fields of the table on top of the stack that describe a
+// node: its type, its source position if asked for and known, and the
+// attributes of its type, named as in cmark.render_json.
+static void lua_cmark_node_fields(lua_State *L, cmark_node *node, int options)
+{
+        lua_cmark_set_string(L, "type", cmark_node_get_type_string(node));
+        if ((options & CMARK_OPT_SOURCEPOS) && cmark_node_get_start_line(node) != 0) {
+                lua_createtable(L, 4, 0);
+                lua_pushinteger(L, cmark_node_get_start_line(node));
+                lua_rawseti(L, -2, 1);
+                lua_pushinteger(L, cmark_node_get_start_column(node));
+                lua_rawseti(L, -2, 2);
+                lua_pushinteger(L, cmark_node_get_end_line(node));
+                lua_rawseti(L, -2, 3);
+                lua_pushinteger(L, cmark_node_get_end_column(node));
+                lua_rawseti(L, -2, 4);
+                lua_setfield(L, -2, "sourcepos");
+        }
+
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                if (cmark_node_get_list_type(node) == CMARK_ORDERED_LIST) {
+                        lua_cmark_set_string(L, "list_type", "ordered");
+                        lua_cmark_set_integer(L, "start", cmark_node_get_list_start(node));
+                        lua_cmark_set_string(L, "delim",
+                                        cmark_node_get_list_delim(node) == CMARK_PAREN_DELIM ?
+                                        "paren" : "period");
+                } else {
+                        lua_cmark_set_string(L, "list_type", "bullet");
+                }
+                lua_pushboolean(L, cmark_node_get_list_tight(node));
+                lua_setfield(L, -2, "tight");
+                break;
+        case CMARK_NODE_HEADING:
+                lua_cmark_set_integer(L, "level", cmark_node_get_heading_level(node));
+                break;
+        case CMARK_NODE_CODE_BLOCK:
+                lua_cmark_set_string(L, "info", cmark_node_get_fence_info(node));
+                lua_cmark_set_string(L, "literal", cmark_node_get_literal(node));
+                break;
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                lua_cmark_set_string(L, "literal", cmark_node_get_literal(node));
+                break;
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+                lua_cmark_set_string(L, "on_enter", cmark_node_get_on_enter(node));
+                lua_cmark_set_string(L, "on_exit", cmark_node_get_on_exit(node));
+                break;
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                lua_cmark_set_string(L, "destination", cmark_node_get_url(node));
+                lua_cmark_set_string(L, "title", cmark_node_get_title(node));
+                break;
+        default:
+                break;
+        }
+}
+
+// Returns a node and its descendants as nested tables.  While the tree
+// is built, the stack holds the children tables of the open nodes,
+// starting with a table that receives the root.  The iterator is held
+// in a walk state below them, so that it is freed if building a table
+// raises an error.
+static int lua_cmark_to_table(lua_State *L)
+{
+        struct lua_cmark_walk *walk;
+        cmark_event_type ev_type;
+        cmark_node *node, *child;
+        cmark_iter *iter;
+        int options, n;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        lua_settop(L, 2);
+        walk = lua_cmark_push_walk(L);
+        lua_createtable(L, 1, 0);
+
+        iter = walk->iter = cmark_iter_new(node);
+        while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+                node = cmark_iter_get_node(iter);
+                if (ev_type == CMARK_EVENT_EXIT) {
+                        lua_pop(L, 1);
+                        continue;
+                }
+                if (!lua_checkstack(L, 4))
+                        return luaL_error(L, "document is nested too deeply");
+                lua_createtable(L, 0, lua_cmark_field_count(node, options) + 1);
+                lua_cmark_node_fields(L, node, options);
+                lua_pushvalue(L, -1);
+                lua_rawseti(L, -3, (int)lua_rawlen(L, -3) + 1);
+                if (lua_cmark_is_leaf(cmark_node_get_type(node))) {
+                        lua_pop(L, 1);
+                        continue;
+                }
+                n = 0;
+                for (child = cmark_node_first_child(node); child != NULL;
+                     child = cmark_node_next(child))
+                        n++;
+                lua_createtable(L, n, 0);
+                lua_pushvalue(L, -1);
+                lua_setfield(L, -3, "children");
+                lua_remove(L, -2);
+        }
+        cmark_iter_free(iter);
+        walk->iter = NULL;
+
+        lua_rawgeti(L, 4, 1);
+        return 1;
+}
+
+// What the builder accepts as children of a node, and the class of a
+// node as a child.
+#define LUA_CMARK_ITEMS 1
+#define LUA_CMARK_BLOCKS 2
+#define LUA_CMARK_INLINES 4
+#define LUA_CMARK_LITERAL 8
+
+static int lua_cmark_contains(cmark_node_type type)
+{
+        switch (type) {
+        case CMARK_NODE_DOCUMENT:
+        case CMARK_NODE_BLOCK_QUOTE:
+        case CMARK_NODE_ITEM:
+                return LUA_CMARK_BLOCKS;
+        case CMARK_NODE_LIST:
+                return LUA_CMARK_ITEMS;
+        case CMARK_NODE_CUSTOM_BLOCK:
+                return LUA_CMARK_ITEMS | LUA_CMARK_BLOCKS | LUA_CMARK_INLINES;
+        case CMARK_NODE_HEADING:
+        case CMARK_NODE_PARAGRAPH:
+        case CMARK_NODE_EMPH:
+        case CMARK_NODE_STRONG:
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+        case CMARK_NODE_CUSTOM_INLINE:
+                return LUA_CMARK_INLINES;
+        case CMARK_NODE_CODE_BLOCK:
+        case CMARK_NODE_HTML_BLOCK:
+        case CMARK_NODE_TEXT:
+        case CMARK_NODE_CODE:
+        case CMARK_NODE_HTML_INLINE:
+                return LUA_CMARK_LITERAL;
+        default:
+                return 0;
+        }
+}
+
+static int lua_cmark_node_class(cmark_node *node)
+{
+        cmark_node_type type = cmark_node_get_type(node);
+
+        if (type == CMARK_NODE_ITEM)
+                return LUA_CMARK_ITEMS;
+        if (type >= CMARK_NODE_FIRST_BLOCK && type <= CMARK_NODE_LAST_BLOCK)
+                return LUA_CMARK_BLOCKS;
+        if (type >= CMARK_NODE_FIRST_INLINE && type <= CMARK_NODE_LAST_INLINE)
+                return LUA_CMARK_INLINES;
+        return 0;
+}
+
+static const char *lua_cmark_class_name(int node_class)
+{
+        switch (node_class) {
+        case LUA_CMARK_ITEMS:
+                return "item";
+        case LUA_CMARK_BLOCKS:
+                return "block";
+        case LUA_CMARK_INLINES:
+                return "inline";
+        default:
+                return "unknown";
+        }
+}
+
+// The node that build_node is building, and the nodes that the caller
+// supplied as its contents.  It is held in a userdata, so that what has
+// been built is discarded when the holder is collected if building
+// raises an error.
+struct lua_cmark_building {
+        cmark_node *node;
+        cmark_node **supplied;
+        size_t nsupplied;
+        size_t capacity;
+};
+
+// Records a node supplied by the caller, before it is added.
+static void lua_cmark_building_supply(lua_State *L,
+                                      struct lua_cmark_building *building,
+                                      cmark_node *child)
+{
+        cmark_node **supplied;
+        size_t capacity;
+
+        if (building->nsupplied == building->capacity) {
+                capacity = building->capacity ? 2 * building->capacity : 8;
+                supplied = (cmark_node **)realloc(building->supplied,
+                                                  capacity * sizeof(*supplied));
+                if (supplied == NULL)
+                        luaL_error(L, "not enough memory");
+                building->supplied = supplied;
+                building->capacity = capacity;
+        }
+        building->supplied[building->nsupplied++] = child;
+}
+
+// Frees the node being built, if any, with the nodes that build_node
+// created for it.  The nodes supplied by the caller are unlinked from
+// it first, since the caller may still hold and free them.
+static void lua_cmark_building_discard(struct lua_cmark_building *building)
+{
+        cmark_node *cur;
+        size_t i;
+
+        if (building->node != NULL) {
+                for (i = 0; i < building->nsupplied; i++) {
+                        cur = cmark_node_parent(building->supplied[i]);
+                        while (cur != NULL && cur != building->node)
+                                cur = cmark_node_parent(cur);
+                        if (cur != NULL)
+                                cmark_node_unlink(building->supplied[i]);
+                }
+                cmark_node_free(building->node);
+                building->node = NULL;
+        }
+        free(building->supplied);
+        building->supplied = NULL;
+        building->nsupplied = 0;
+        building->capacity = 0;
+}
+
+// Returns a new node of the given type with 'child' as its only child,
+// or NULL if it could not be created.
+static cmark_node *lua_cmark_wrap(cmark_node *child, cmark_node_type type)
+{
+        cmark_node *wrapper = cmark_node_new(type);
+
+        if (wrapper != NULL && !cmark_node_append_child(wrapper, child)) {
+                cmark_node_free(wrapper);
+                return NULL;
+        }
+        return wrapper;
+}
+
+// Appends a child to a node, wrapping it in an item or a paragraph if
+// the node cannot contain it directly.  Returns NULL on success, or an
+// error message, in which case the child has not been added and any
+// wrapper has been freed.
+static const char *lua_cmark_add_child(lua_State *L, cmark_node *node,
+                                       cmark_node *child, int contains)
+{
+        int child_class = lua_cmark_node_class(child);
+        cmark_node *wrapped = child, *para;
+
+        if (child_class & contains) {
+                // Appended as it is.
+        } else if (child_class == LUA_CMARK_BLOCKS && (contains & LUA_CMARK_ITEMS)) {
+                wrapped = lua_cmark_wrap(child, CMARK_NODE_ITEM);
+        } else if (child_class == LUA_CMARK_INLINES && (contains & LUA_CMARK_BLOCKS)) {
+                wrapped = lua_cmark_wrap(child, CMARK_NODE_PARAGRAPH);
+        } else if (child_class == LUA_CMARK_INLINES && (contains & LUA_CMARK_ITEMS)) {
+                para = lua_cmark_wrap(child, CMARK_NODE_PARAGRAPH);
+                wrapped = para != NULL ? lua_cmark_wrap(para, CMARK_NODE_ITEM) : NULL;
+                if (para != NULL && wrapped == NULL) {
+                        cmark_node_unlink(child);
+                        cmark_node_free(para);
+                }
+        } else {
+                return lua_pushfstring(L,
+                                "Tried to add a node with class %s to a node with class %s",
+                                lua_cmark_class_name(child_class),
+                                lua_cmark_class_name(lua_cmark_node_class(node)));
+        }
+        if (wrapped == NULL)
+                return "Could not wrap child";
+        if (!cmark_node_append_child(node, wrapped)) {
+                if (wrapped != child) {
+                        cmark_node_unlink(child);
+                        cmark_node_free(wrapped);
+                }
+                return "Could not append child";
+        }
+        return NULL;
+}
+
+// Adds the value at 'idx' as content of a node, as cmark.builder does:
+// tables are lists of contents, functions are called, nodes are added
+// as children, and anything else is converted to a string and becomes
+// the node's literal or a text node.  Returns an error message, or NULL
+// on success.
+static const char *lua_cmark_add_children(lua_State *L,
+                                          struct lua_cmark_building *building,
+                                          int idx, int contains)
+{
+        cmark_node *node = building->node;
+        const char *msg, *s;
+        cmark_node *child;
+        int i;
+
+        luaL_checkstack(L, 3, "contents are nested too deeply");
+        switch (lua_type(L, idx)) {
+        case LUA_TNIL:
+                return NULL;
+        case LUA_TTABLE:
+                for (i = 1; ; i++) {
+                        lua_rawgeti(L, idx, i);
+                        if (lua_isnil(L, -1)) {
+                                lua_pop(L, 1);
+                                return NULL;
+                        }
+                        msg = lua_cmark_add_children(L, building, lua_gettop(L),
+                                                     contains);
+                        if (msg != NULL)
+                                return msg;
+                        lua_pop(L, 1);
+                }
+        case LUA_TFUNCTION:
+                lua_pushvalue(L, idx);
+                lua_call(L, 0, 1);
+                msg = lua_cmark_add_children(L, building, lua_gettop(L), contains);
+                if (msg == NULL)
+                        lua_pop(L, 1);
+                return msg;
+        case LUA_TUSERDATA:
+                if (!SWIG_IsOK(SWIG_ConvertPtr(L,idx,(void**)&child,SWIGTYPE_p_cmark_node,0)))
+                        luaL_error(L, "expected cmark_node");
+                lua_cmark_building_supply(L, building, child);
+                return lua_cmark_add_child(L, node, child, contains);
+        case LUA_TSTRING:
+        case LUA_TNUMBER:
+                lua_pushvalue(L, idx);
+                break;
+        default:
+                lua_getglobal(L, "tostring");
+                lua_pushvalue(L, idx);
+                lua_call(L, 1, 1);
+                break;
+        }
+
+        s = lua_tostring(L, -1);
+        if (contains & LUA_CMARK_LITERAL) {
+                if (!cmark_node_set_literal(node, s))
+                        return "Could not set literal";
+                lua_pop(L, 1);
+                return NULL;
+        }
+        child = cmark_node_new(CMARK_NODE_TEXT);
+        if (child == NULL)
+                return "Could not create text node";
+        if (!cmark_node_set_literal(child, s))
+                msg = "Could not set literal";
+        else
+                msg = lua_cmark_add_child(L, node, child, contains);
+        if (msg != NULL)
+                cmark_node_free(child);
+        lua_pop(L, 1);
+        return msg;
+}
+
+// Pushes the field 'key' of the contents table at 'idx', and returns
+// whether it is set (as in Lua, false counts as unset).
+static int lua_cmark_attribute(lua_State *L, int idx, const char *key)
+{
+        lua_getfield(L, idx, key);
+        if (lua_toboolean(L, -1))
+                return 1;
+        lua_pop(L, 1);
+        return 0;
+}
+
+static const char *lua_cmark_string_attribute(lua_State *L, int idx, const char *key)
+{
+        const char *s = lua_tostring(L, idx);
+
+        if (s == NULL)
+                luaL_error(L, "expected a string for %s", key);
+        return s;
+}
+
+static int lua_cmark_integer_attribute(lua_State *L, int idx, const char *key)
+{
+        if (!lua_isnumber(L, idx))
+                luaL_error(L, "expected a number for %s", key);
+        return (int)lua_tointeger(L, idx);
+}
+
+// Sets the attributes of a node from the fields of the contents table
+// at 'idx'.  Returns an error message, or NULL on success.
+static const char *lua_cmark_set_attributes(lua_State *L, cmark_node *node, int idx)
+{
+        const char *s;
+
+        switch (cmark_node_get_type(node)) {
+        case CMARK_NODE_LIST:
+                if (cmark_node_get_list_type(node) == CMARK_ORDERED_LIST) {
+                        if (lua_cmark_attribute(L, idx, "delim")) {
+                                s = lua_tostring(L, -1);
+                                if (lua_type(L, -1) == LUA_TNUMBER &&
+                                    (lua_tointeger(L, -1) == CMARK_PAREN_DELIM ||
+                                     lua_tointeger(L, -1) == CMARK_PERIOD_DELIM))
+                                        cmark_node_set_list_delim(node,
+                                                        (cmark_delim_type)lua_tointeger(L, -1));
+                                else if (s != NULL && strcmp(s, ")") == 0)
+                                        cmark_node_set_list_delim(node, CMARK_PAREN_DELIM);
+                                else if (s != NULL && strcmp(s, ".") == 0)
+                                        cmark_node_set_list_delim(node, CMARK_PERIOD_DELIM);
+                                else
+                                        return lua_pushfstring(L, "Unknown delimiter %s",
+                                                        s != NULL ? s : luaL_typename(L, -1));
+                                lua_pop(L, 1);
+                        }
+                        if (lua_cmark_attribute(L, idx, "start")) {
+                                cmark_node_set_list_start(node,
+                                                lua_cmark_integer_attribute(L, -1, "start"));
+                                lua_pop(L, 1);
+                        }
+                }
+                if (lua_cmark_attribute(L, idx, "tight")) {
+                        cmark_node_set_list_tight(node, 1);
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_CODE_BLOCK:
+                if (lua_cmark_attribute(L, idx, "info")) {
+                        cmark_node_set_fence_info(node,
+                                        lua_cmark_string_attribute(L, -1, "info"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_HEADING:
+                if (lua_cmark_attribute(L, idx, "level")) {
+                        cmark_node_set_heading_level(node,
+                                        lua_cmark_integer_attribute(L, -1, "level"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_CUSTOM_BLOCK:
+        case CMARK_NODE_CUSTOM_INLINE:
+                if (lua_cmark_attribute(L, idx, "on_enter")) {
+                        cmark_node_set_on_enter(node,
+                                        lua_cmark_string_attribute(L, -1, "on_enter"));
+                        lua_pop(L, 1);
+                }
+                if (lua_cmark_attribute(L, idx, "on_exit")) {
+                        cmark_node_set_on_exit(node,
+                                        lua_cmark_string_attribute(L, -1, "on_exit"));
+                        lua_pop(L, 1);
+                }
+                break;
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+                if (lua_cmark_attribute(L, idx, "title")) {
+                        cmark_node_set_title(node,
+                                        lua_cmark_string_attribute(L, -1, "title"));
+                        lua_pop(L, 1);
+                }
+                if (lua_cmark_attribute(L, idx, "url")) {
+                        cmark_node_set_url(node,
+                                        lua_cmark_string_attribute(L, -1, "url"));
+                        lua_pop(L, 1);
+                }
+                break;
+        default:
+                break;
+        }
+        return NULL;
+}
+
+static int lua_cmark_building_gc(lua_State *L)
+{
+        lua_cmark_building_discard((struct lua_cmark_building *)lua_touserdata(L, 1));
+        return 0;
+}
+
+// Creates a node of the given type (and, for lists, list type) from
+// contents in the form that cmark.builder takes.  Returns the node, or
+// nil and an error message.  On error the partly built node is freed,
+// but the nodes supplied as contents are left to the caller.
+static int lua_cmark_build_node(lua_State *L)
+{
+        struct lua_cmark_building *building;
+        cmark_node_type type;
+        cmark_node *node;
+        const char *msg = NULL;
+
+        type = (cmark_node_type)luaL_checkinteger(L, 1);
+        lua_settop(L, 3);
+        building = (struct lua_cmark_building *)lua_newuserdata(L, sizeof(*building));
+        memset(building, 0, sizeof(*building));
+        if (luaL_newmetatable(L, "cmark.building")) {
+                lua_pushcfunction(L, lua_cmark_building_gc);
+                lua_setfield(L, -2, "__gc");
+        }
+        lua_setmetatable(L, -2);
+        node = cmark_node_new(type);
+        if (node == NULL) {
+                lua_pushnil(L);
+                lua_pushfstring(L, "Could not create node of type %d", (int)type);
+                return 2;
+        }
+        building->node = node;
+        if (type == CMARK_NODE_LIST)
+                cmark_node_set_list_type(node,
+                                (cmark_list_type)luaL_optinteger(L, 3, CMARK_BULLET_LIST));
+
+        if (lua_istable(L, 2))
+                msg = lua_cmark_set_attributes(L, node, 2);
+        if (msg == NULL)
+                msg = lua_cmark_add_children(L, building, 2, lua_cmark_contains(type));
+        if (msg != NULL) {
+                lua_pushnil(L);
+                lua_pushstring(L, msg);
+                lua_cmark_building_discard(building);
+                return 2;
+        }
+        building->node = NULL;
+        lua_cmark_building_discard(building);
+        push_cmark_node(L, node);
+        return 1;
+}
+
+// Registry key of the table that maps the address of a document parsed
+// by parse_string_borrowed to the string its nodes point into.
+static const char lua_cmark_sources_key = 0;
+
+// Pushes the table of borrowed source strings, creating it if needed.
+static void lua_cmark_push_sources(lua_State *L)
+{
+        lua_pushlightuserdata(L, (void *)&lua_cmark_sources_key);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_pushlightuserdata(L, (void *)&lua_cmark_sources_key);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+}
+
+// Parses a string without copying the content of its blocks, which
+// points into the string instead.  The string is kept alive until the
+// document is freed with node_free.  The parser briefly writes into the
+// string and restores it before returning, which no Lua code can see.
+static int lua_cmark_parse_string_borrowed(lua_State *L)
+{
+        size_t len;
+        const char *s = luaL_checklstring(L, 1, &len);
+        int options = (int)luaL_optinteger(L, 2, CMARK_OPT_DEFAULT);
+        cmark_node *doc;
+
+        doc = cmark_parse_document_borrowed(s, len, options);
+        if (doc == NULL)
+                return 0;
+        lua_cmark_push_sources(L);
+        lua_pushlightuserdata(L, doc);
+        lua_pushvalue(L, 1);
+        lua_rawset(L, -3);
+        lua_pop(L, 1);
+        push_cmark_node(L, doc);
+        return 1;
+}
+
+// Frees a node and its children, and releases the source string of a
+// document parsed by parse_string_borrowed.
+static int lua_cmark_node_free(lua_State *L)
+{
+        cmark_node *node;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)) ||
+            node == NULL)
+                return luaL_argerror(L, 1, "expected cmark_node");
+        cmark_node_free(node);
+        lua_cmark_push_sources(L);
+        lua_pushlightuserdata(L, node);
+        lua_pushnil(L);
+        lua_rawset(L, -3);
+        return 0;
+}
+
+// Returns the nodes under a node whose type is one of a list of types
+// (or a single type), as an array, stopping after 'max' nodes if it is
+// given.
+static int lua_cmark_select(lua_State *L)
+{
+        cmark_node *node, **nodes;
+        unsigned int mask = 0;
+        lua_Integer type, max;
+        size_t i, n, count;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        if (lua_istable(L, 2)) {
+                n = lua_rawlen(L, 2);
+                for (i = 1; i <= n; i++) {
+                        lua_rawgeti(L, 2, (int)i);
+                        type = lua_tointeger(L, -1);
+                        lua_pop(L, 1);
+                        if (type < CMARK_NODE_FIRST_BLOCK ||
+                            type > CMARK_NODE_LAST_INLINE)
+                                return luaL_argerror(L, 2, "invalid node type");
+                        mask |= CMARK_NODE_MASK(type);
+                }
+        } else {
+                type = luaL_checkinteger(L, 2);
+                if (type < CMARK_NODE_FIRST_BLOCK || type > CMARK_NODE_LAST_INLINE)
+                        return luaL_argerror(L, 2, "invalid node type");
+                mask = CMARK_NODE_MASK(type);
+        }
+        max = luaL_optinteger(L, 3, 0);
+        if (max < 0)
+                return luaL_argerror(L, 3, "negative count");
+
+        nodes = cmark_node_select(node, mask, (size_t)max, &count);
+        lua_createtable(L, (int)count, 0);
+        for (i = 0; i < count; i++) {
+                push_cmark_node(L, nodes[i]);
+                lua_rawseti(L, -2, (int)(i + 1));
+        }
+        cmark_node_get_mem(node)->free(nodes);
+        return 1;
+}
+
+static void lua_cmark_set_number(lua_State *L, const char *key, double value)
+{
+        lua_pushnumber(L, value);
+        lua_setfield(L, -2, key);
+}
+
+// Returns the statistics of the document that a node belongs to as a
+// table, or nil if it was not parsed with OPT_STATS.  Times are in
+// seconds, and 'nodes' is indexed by node type.
+static int lua_cmark_get_stats(lua_State *L)
+{
+        cmark_node *node;
+        const cmark_stats *stats;
+        int type;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&node,SWIGTYPE_p_cmark_node,0)))
+                return luaL_argerror(L, 1, "expected cmark_node");
+        stats = cmark_node_get_stats(node);
+        if (stats == NULL) {
+                lua_pushnil(L);
+                return 1;
+        }
+
+        lua_createtable(L, 0, 14);
+        lua_cmark_set_number(L, "block_time", stats->block_ns / 1e9);
+        lua_cmark_set_number(L, "reference_time", stats->reference_ns / 1e9);
+        lua_cmark_set_number(L, "inline_time", stats->inline_ns / 1e9);
+        lua_cmark_set_number(L, "emphasis_time", stats->emphasis_ns / 1e9);
+        lua_cmark_set_number(L, "render_time", stats->render_ns / 1e9);
+        lua_cmark_set_number(L, "lines", (double)stats->lines);
+        lua_cmark_set_number(L, "delimiters_pushed", (double)stats->delimiters_pushed);
+        lua_cmark_set_number(L, "delimiters_processed", (double)stats->delimiters_processed);
+        lua_cmark_set_number(L, "references_defined", (double)stats->references_defined);
+        lua_cmark_set_number(L, "references_looked_up", (double)stats->references_looked_up);
+        lua_cmark_set_number(L, "renders", (double)stats->renders);
+        lua_cmark_set_number(L, "output_bytes", (double)stats->output_bytes);
+        lua_createtable(L, CMARK_NODE_LAST_INLINE, 0);
+        for (type = CMARK_NODE_FIRST_BLOCK; type <= CMARK_NODE_LAST_INLINE; type++) {
+                lua_pushnumber(L, (double)stats->nodes[type]);
+                lua_rawseti(L, -2, type);
+        }
+        lua_setfield(L, -2, "nodes");
+        return 1;
+}
+
+// Returns what has been allocated through a memory account as a table,
+// with the counts of each phase in the fields 'parse', 'inlines' and
+// 'render'.
+static int lua_cmark_mem_account_get_usage(lua_State *L)
+{
+        static const char *const phases[CMARK_MEM_PHASES] = {
+                "parse", "inlines", "render"
+        };
+        cmark_mem_account *account;
+        const cmark_mem_usage *usage;
+        int i;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&account,SWIGTYPE_p_cmark_mem_account,0)))
+                return luaL_argerror(L, 1, "expected cmark_mem_account");
+        usage = cmark_mem_account_get_usage(account);
+        lua_createtable(L, 0, 7);
+        lua_cmark_set_number(L, "live", (double)usage->live);
+        lua_cmark_set_number(L, "peak", (double)usage->peak);
+        lua_cmark_set_number(L, "frees", (double)usage->frees);
+        lua_pushboolean(L, usage->exceeded);
+        lua_setfield(L, -2, "exceeded");
+        for (i = 0; i < CMARK_MEM_PHASES; i++) {
+                lua_createtable(L, 0, 3);
+                lua_cmark_set_number(L, "allocations", (double)usage->allocations[i]);
+                lua_cmark_set_number(L, "reallocations", (double)usage->reallocations[i]);
+                lua_cmark_set_number(L, "bytes", (double)usage->bytes[i]);
+                lua_setfield(L, -2, phases[i]);
+        }
+        return 1;
+}
+
+// Sets the resource limits of a parser from a table with any of the
+// fields 'max_depth', 'max_nodes', 'max_delimiters', 'max_output' and
+// 'max_time' (in seconds).
+static int lua_cmark_parser_set_limits(lua_State *L)
+{
+        cmark_parser *parser;
+        cmark_limits limits;
+
+        if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&parser,SWIGTYPE_p_cmark_parser,0)))
+                return luaL_argerror(L, 1, "expected cmark_parser");
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_getfield(L, 2, "max_depth");
+        lua_getfield(L, 2, "max_nodes");
+        lua_getfield(L, 2, "max_delimiters");
+        lua_getfield(L, 2, "max_output");
+        lua_getfield(L, 2, "max_time");
+        limits.max_depth = (int)luaL_optnumber(L, -5, 0);
+        limits.max_nodes = (size_t)luaL_optnumber(L, -4, 0);
+        limits.max_delimiters = (size_t)luaL_optnumber(L, -3, 0);
+        limits.max_output = (size_t)luaL_optnumber(L, -2, 0);
+        limits.max_time = luaL_optnumber(L, -1, 0);
+        lua_pop(L, 5);
+        cmark_parser_set_limits(parser, &limits);
+        return 0;
 }
 
 #ifdef __cplusplus
@@ -2952,16 +4153,17 @@ static swig_lua_class *swig_mem_bases[] = {0};
 static const char *swig_mem_base_names[] = {0};
 static swig_lua_class _wrap_class_mem = { "mem", "mem", &SWIGTYPE_p_cmark_mem,_proxy__wrap_new_mem, swig_delete_mem, swig_mem_methods, swig_mem_attributes, &swig_mem_Sf_SwigStatic, swig_mem_meta, swig_mem_bases, swig_mem_base_names };
 
-static int _wrap_node_new(lua_State* L) {
+static int _wrap_mem_account_new(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node_type arg1 ;
-  cmark_node *result = 0 ;
+  size_t arg1 ;
+  cmark_mem_account *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_new",1,1)
-  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_node_new",1,"cmark_node_type");
-  arg1 = (cmark_node_type)(int)lua_tonumber(L, 1);
-  result = (cmark_node *)cmark_node_new(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  SWIG_check_num_args("cmark_mem_account_new",1,1)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_mem_account_new",1,"size_t");
+  SWIG_contract_assert((lua_tonumber(L,1)>=0),"number must not be negative")
+  arg1 = (size_t)lua_tonumber(L, 1);
+  result = (cmark_mem_account *)cmark_mem_account_new(arg1);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_mem_account,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -2972,23 +4174,24 @@ fail:
 }
 
 
-static int _wrap_node_new_with_mem(lua_State* L) {
+static int _wrap_mem_account_new_with_mem(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node_type arg1 ;
+  size_t arg1 ;
   cmark_mem *arg2 = (cmark_mem *) 0 ;
-  cmark_node *result = 0 ;
+  cmark_mem_account *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_new_with_mem",2,2)
-  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_node_new_with_mem",1,"cmark_node_type");
-  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_new_with_mem",2,"cmark_mem *");
-  arg1 = (cmark_node_type)(int)lua_tonumber(L, 1);
+  SWIG_check_num_args("cmark_mem_account_new_with_mem",2,2)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_mem_account_new_with_mem",1,"size_t");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_mem_account_new_with_mem",2,"cmark_mem *");
+  SWIG_contract_assert((lua_tonumber(L,1)>=0),"number must not be negative")
+  arg1 = (size_t)lua_tonumber(L, 1);
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_mem,0))){
-    SWIG_fail_ptr("node_new_with_mem",2,SWIGTYPE_p_cmark_mem);
+    SWIG_fail_ptr("mem_account_new_with_mem",2,SWIGTYPE_p_cmark_mem);
   }
   
-  result = (cmark_node *)cmark_node_new_with_mem(arg1,arg2);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  result = (cmark_mem_account *)cmark_mem_account_new_with_mem(arg1,arg2);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_mem_account,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -2999,18 +4202,18 @@ fail:
 }
 
 
-static int _wrap_node_free(lua_State* L) {
+static int _wrap_mem_account_free(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_mem_account *arg1 = (cmark_mem_account *) 0 ;
   
-  SWIG_check_num_args("cmark_node_free",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_free",1,"cmark_node *");
+  SWIG_check_num_args("cmark_mem_account_free",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_mem_account_free",1,"cmark_mem_account *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_free",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_mem_account,0))){
+    SWIG_fail_ptr("mem_account_free",1,SWIGTYPE_p_cmark_mem_account);
   }
   
-  cmark_node_free(arg1);
+  cmark_mem_account_free(arg1);
   
   return SWIG_arg;
   
@@ -3022,20 +4225,20 @@ fail:
 }
 
 
-static int _wrap_node_next(lua_State* L) {
+static int _wrap_mem_account_get_mem(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
-  cmark_node *result = 0 ;
+  cmark_mem_account *arg1 = (cmark_mem_account *) 0 ;
+  cmark_mem *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_next",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_next",1,"cmark_node *");
+  SWIG_check_num_args("cmark_mem_account_get_mem",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_mem_account_get_mem",1,"cmark_mem_account *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_next",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_mem_account,0))){
+    SWIG_fail_ptr("mem_account_get_mem",1,SWIGTYPE_p_cmark_mem_account);
   }
   
-  result = (cmark_node *)cmark_node_next(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  result = (cmark_mem *)cmark_mem_account_get_mem(arg1);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_mem,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3046,20 +4249,20 @@ fail:
 }
 
 
-static int _wrap_node_previous(lua_State* L) {
+static int _wrap_node_get_mem(lua_State* L) {
   int SWIG_arg = 0;
   cmark_node *arg1 = (cmark_node *) 0 ;
-  cmark_node *result = 0 ;
+  cmark_mem *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_previous",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_previous",1,"cmark_node *");
+  SWIG_check_num_args("cmark_node_get_mem",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_get_mem",1,"cmark_node *");
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_previous",1,SWIGTYPE_p_cmark_node);
+    SWIG_fail_ptr("node_get_mem",1,SWIGTYPE_p_cmark_node);
   }
   
-  result = (cmark_node *)cmark_node_previous(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  result = (cmark_mem *)cmark_node_get_mem(arg1);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_mem,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3070,20 +4273,16 @@ fail:
 }
 
 
-static int _wrap_node_parent(lua_State* L) {
+static int _wrap_node_new(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node_type arg1 ;
   cmark_node *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_parent",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_parent",1,"cmark_node *");
-  
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_parent",1,SWIGTYPE_p_cmark_node);
-  }
-  
-  result = (cmark_node *)cmark_node_parent(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  SWIG_check_num_args("cmark_node_new",1,1)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_node_new",1,"cmark_node_type");
+  arg1 = (cmark_node_type)(int)lua_tonumber(L, 1);
+  result = (cmark_node *)cmark_node_new(arg1);
+  push_cmark_node(L,result); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3094,20 +4293,119 @@ fail:
 }
 
 
-static int _wrap_node_first_child(lua_State* L) {
+static int _wrap_node_new_with_mem(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node_type arg1 ;
+  cmark_mem *arg2 = (cmark_mem *) 0 ;
   cmark_node *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_first_child",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_first_child",1,"cmark_node *");
-  
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_first_child",1,SWIGTYPE_p_cmark_node);
+  SWIG_check_num_args("cmark_node_new_with_mem",2,2)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_node_new_with_mem",1,"cmark_node_type");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_new_with_mem",2,"cmark_mem *");
+  arg1 = (cmark_node_type)(int)lua_tonumber(L, 1);
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_mem,0))){
+    SWIG_fail_ptr("node_new_with_mem",2,SWIGTYPE_p_cmark_mem);
+  }
+  
+  result = (cmark_node *)cmark_node_new_with_mem(arg1,arg2);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_next(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_node_next",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_next",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_next",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (cmark_node *)cmark_node_next(arg1);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_previous(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_node_previous",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_previous",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_previous",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (cmark_node *)cmark_node_previous(arg1);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_parent(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_node_parent",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_parent",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_parent",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (cmark_node *)cmark_node_parent(arg1);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_first_child(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_node_first_child",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_first_child",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_first_child",1,SWIGTYPE_p_cmark_node);
   }
   
   result = (cmark_node *)cmark_node_first_child(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  push_cmark_node(L,result); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3131,7 +4429,7 @@ static int _wrap_node_last_child(lua_State* L) {
   }
   
   result = (cmark_node *)cmark_node_last_child(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  push_cmark_node(L,result); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3166,6 +4464,37 @@ fail:
 }
 
 
+static int _wrap_iter_new_with_mem(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_mem *arg2 = (cmark_mem *) 0 ;
+  cmark_iter *result = 0 ;
+  
+  SWIG_check_num_args("cmark_iter_new_with_mem",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_iter_new_with_mem",1,"cmark_node *");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_iter_new_with_mem",2,"cmark_mem *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("iter_new_with_mem",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_mem,0))){
+    SWIG_fail_ptr("iter_new_with_mem",2,SWIGTYPE_p_cmark_mem);
+  }
+  
+  result = (cmark_iter *)cmark_iter_new_with_mem(arg1,arg2);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_iter,0); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
 static int _wrap_iter_free(lua_State* L) {
   int SWIG_arg = 0;
   cmark_iter *arg1 = (cmark_iter *) 0 ;
@@ -3226,7 +4555,7 @@ static int _wrap_iter_get_node(lua_State* L) {
   }
   
   result = (cmark_node *)cmark_iter_get_node(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  push_cmark_node(L,result); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -3274,7 +4603,7 @@ static int _wrap_iter_get_root(lua_State* L) {
   }
   
   result = (cmark_node *)cmark_iter_get_root(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  push_cmark_node(L,result); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4174,12 +5503,477 @@ static int _wrap_node_replace(lua_State* L) {
   }
   
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_replace",2,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_replace",2,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (int)cmark_node_replace(arg1,arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_prepend_child(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *arg2 = (cmark_node *) 0 ;
+  int result;
+  
+  SWIG_check_num_args("cmark_node_prepend_child",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_prepend_child",1,"cmark_node *");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_prepend_child",2,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_prepend_child",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_prepend_child",2,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (int)cmark_node_prepend_child(arg1,arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_append_child(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_node *arg2 = (cmark_node *) 0 ;
+  int result;
+  
+  SWIG_check_num_args("cmark_node_append_child",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_append_child",1,"cmark_node *");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_append_child",2,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_append_child",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_append_child",2,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (int)cmark_node_append_child(arg1,arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_consolidate_text_nodes(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  
+  SWIG_check_num_args("cmark_consolidate_text_nodes",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_consolidate_text_nodes",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("consolidate_text_nodes",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  cmark_consolidate_text_nodes(arg1);
+  
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_deserialize(lua_State* L) {
+  int SWIG_arg = 0;
+  char *arg1 = (char *) 0 ;
+  size_t arg2 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_node_deserialize",2,2)
+  if(!SWIG_lua_isnilstring(L,1)) SWIG_fail_arg("cmark_node_deserialize",1,"char const *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_node_deserialize",2,"size_t");
+  arg1 = (char *)lua_tostring(L, 1);
+  SWIG_contract_assert((lua_tonumber(L,2)>=0),"number must not be negative")
+  arg2 = (size_t)lua_tonumber(L, 2);
+  result = (cmark_node *)cmark_node_deserialize((char const *)arg1,arg2);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_new(lua_State* L) {
+  int SWIG_arg = 0;
+  int arg1 ;
+  cmark_parser *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parser_new",1,1)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_parser_new",1,"int");
+  arg1 = (int)lua_tonumber(L, 1);
+  result = (cmark_parser *)cmark_parser_new(arg1);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_parser,0); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_new_with_mem(lua_State* L) {
+  int SWIG_arg = 0;
+  int arg1 ;
+  cmark_mem *arg2 = (cmark_mem *) 0 ;
+  cmark_parser *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parser_new_with_mem",2,2)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_parser_new_with_mem",1,"int");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_parser_new_with_mem",2,"cmark_mem *");
+  arg1 = (int)lua_tonumber(L, 1);
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_mem,0))){
+    SWIG_fail_ptr("parser_new_with_mem",2,SWIGTYPE_p_cmark_mem);
+  }
+  
+  result = (cmark_parser *)cmark_parser_new_with_mem(arg1,arg2);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_parser,0); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_free(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_parser *arg1 = (cmark_parser *) 0 ;
+  
+  SWIG_check_num_args("cmark_parser_free",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_free",1,"cmark_parser *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
+    SWIG_fail_ptr("parser_free",1,SWIGTYPE_p_cmark_parser);
+  }
+  
+  cmark_parser_free(arg1);
+  
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_feed(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_parser *arg1 = (cmark_parser *) 0 ;
+  char *arg2 = (char *) 0 ;
+  size_t arg3 ;
+  
+  SWIG_check_num_args("cmark_parser_feed",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_feed",1,"cmark_parser *");
+  if(!SWIG_lua_isnilstring(L,2)) SWIG_fail_arg("cmark_parser_feed",2,"char const *");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_parser_feed",3,"size_t");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
+    SWIG_fail_ptr("parser_feed",1,SWIGTYPE_p_cmark_parser);
+  }
+  
+  arg2 = (char *)lua_tostring(L, 2);
+  SWIG_contract_assert((lua_tonumber(L,3)>=0),"number must not be negative")
+  arg3 = (size_t)lua_tonumber(L, 3);
+  cmark_parser_feed(arg1,(char const *)arg2,arg3);
+  
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_finish(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_parser *arg1 = (cmark_parser *) 0 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parser_finish",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_finish",1,"cmark_parser *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
+    SWIG_fail_ptr("parser_finish",1,SWIGTYPE_p_cmark_parser);
+  }
+  
+  result = (cmark_node *)cmark_parser_finish(arg1);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parser_get_exceeded_limit(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_parser *arg1 = (cmark_parser *) 0 ;
+  cmark_limit result;
+  
+  SWIG_check_num_args("cmark_parser_get_exceeded_limit",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_get_exceeded_limit",1,"cmark_parser *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
+    SWIG_fail_ptr("parser_get_exceeded_limit",1,SWIGTYPE_p_cmark_parser);
+  }
+  
+  result = (cmark_limit)cmark_parser_get_exceeded_limit(arg1);
+  lua_pushnumber(L, (lua_Number)(int)(result)); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_node_get_exceeded_limit(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  cmark_limit result;
+  
+  SWIG_check_num_args("cmark_node_get_exceeded_limit",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_get_exceeded_limit",1,"cmark_node *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("node_get_exceeded_limit",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  result = (cmark_limit)cmark_node_get_exceeded_limit(arg1);
+  lua_pushnumber(L, (lua_Number)(int)(result)); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parse_document(lua_State* L) {
+  int SWIG_arg = 0;
+  char *arg1 = (char *) 0 ;
+  size_t arg2 ;
+  int arg3 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parse_document",3,3)
+  if(!SWIG_lua_isnilstring(L,1)) SWIG_fail_arg("cmark_parse_document",1,"char const *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_document",2,"size_t");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_parse_document",3,"int");
+  arg1 = (char *)lua_tostring(L, 1);
+  SWIG_contract_assert((lua_tonumber(L,2)>=0),"number must not be negative")
+  arg2 = (size_t)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (cmark_node *)cmark_parse_document((char const *)arg1,arg2,arg3);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parse_file(lua_State* L) {
+  int SWIG_arg = 0;
+  FILE *arg1 = (FILE *) 0 ;
+  int arg2 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parse_file",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parse_file",1,"FILE *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_file",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_FILE,0))){
+    SWIG_fail_ptr("parse_file",1,SWIGTYPE_p_FILE);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (cmark_node *)cmark_parse_file(arg1,arg2);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parse_fd(lua_State* L) {
+  int SWIG_arg = 0;
+  int arg1 ;
+  int arg2 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parse_fd",2,2)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_parse_fd",1,"int");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_fd",2,"int");
+  arg1 = (int)lua_tonumber(L, 1);
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (cmark_node *)cmark_parse_fd(arg1,arg2);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_parse_path(lua_State* L) {
+  int SWIG_arg = 0;
+  char *arg1 = (char *) 0 ;
+  int arg2 ;
+  cmark_node *result = 0 ;
+  
+  SWIG_check_num_args("cmark_parse_path",2,2)
+  if(!SWIG_lua_isnilstring(L,1)) SWIG_fail_arg("cmark_parse_path",1,"char const *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_path",2,"int");
+  arg1 = (char *)lua_tostring(L, 1);
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (cmark_node *)cmark_parse_path((char const *)arg1,arg2);
+  push_cmark_node(L,result); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_render_xml(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  int arg2 ;
+  char *result = 0 ;
+  
+  SWIG_check_num_args("cmark_render_xml",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_xml",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_xml",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("render_xml",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (char *)cmark_render_xml(arg1,arg2);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_render_json(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  int arg2 ;
+  char *result = 0 ;
+  
+  SWIG_check_num_args("cmark_render_json",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_json",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_json",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("render_json",1,SWIGTYPE_p_cmark_node);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (char *)cmark_render_json(arg1,arg2);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_render_html(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_node *arg1 = (cmark_node *) 0 ;
+  int arg2 ;
+  char *result = 0 ;
+  
+  SWIG_check_num_args("cmark_render_html",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_html",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_html",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
+    SWIG_fail_ptr("render_html",1,SWIGTYPE_p_cmark_node);
   }
   
-  result = (int)cmark_node_replace(arg1,arg2);
-  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (char *)cmark_render_html(arg1,arg2);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4190,27 +5984,27 @@ fail:
 }
 
 
-static int _wrap_node_prepend_child(lua_State* L) {
+static int _wrap_render_man(lua_State* L) {
   int SWIG_arg = 0;
   cmark_node *arg1 = (cmark_node *) 0 ;
-  cmark_node *arg2 = (cmark_node *) 0 ;
-  int result;
+  int arg2 ;
+  int arg3 ;
+  char *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_prepend_child",2,2)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_prepend_child",1,"cmark_node *");
-  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_prepend_child",2,"cmark_node *");
+  SWIG_check_num_args("cmark_render_man",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_man",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_man",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_man",3,"int");
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_prepend_child",1,SWIGTYPE_p_cmark_node);
-  }
-  
-  
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_prepend_child",2,SWIGTYPE_p_cmark_node);
+    SWIG_fail_ptr("render_man",1,SWIGTYPE_p_cmark_node);
   }
   
-  result = (int)cmark_node_prepend_child(arg1,arg2);
-  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (char *)cmark_render_man(arg1,arg2,arg3);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4221,27 +6015,27 @@ fail:
 }
 
 
-static int _wrap_node_append_child(lua_State* L) {
+static int _wrap_render_commonmark(lua_State* L) {
   int SWIG_arg = 0;
   cmark_node *arg1 = (cmark_node *) 0 ;
-  cmark_node *arg2 = (cmark_node *) 0 ;
-  int result;
+  int arg2 ;
+  int arg3 ;
+  char *result = 0 ;
   
-  SWIG_check_num_args("cmark_node_append_child",2,2)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_node_append_child",1,"cmark_node *");
-  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_node_append_child",2,"cmark_node *");
+  SWIG_check_num_args("cmark_render_commonmark",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_commonmark",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_commonmark",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_commonmark",3,"int");
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_append_child",1,SWIGTYPE_p_cmark_node);
-  }
-  
-  
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("node_append_child",2,SWIGTYPE_p_cmark_node);
+    SWIG_fail_ptr("render_commonmark",1,SWIGTYPE_p_cmark_node);
   }
   
-  result = (int)cmark_node_append_child(arg1,arg2);
-  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (char *)cmark_render_commonmark(arg1,arg2,arg3);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4252,19 +6046,27 @@ fail:
 }
 
 
-static int _wrap_consolidate_text_nodes(lua_State* L) {
+static int _wrap_render_latex(lua_State* L) {
   int SWIG_arg = 0;
   cmark_node *arg1 = (cmark_node *) 0 ;
+  int arg2 ;
+  int arg3 ;
+  char *result = 0 ;
   
-  SWIG_check_num_args("cmark_consolidate_text_nodes",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_consolidate_text_nodes",1,"cmark_node *");
+  SWIG_check_num_args("cmark_render_latex",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_latex",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_latex",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_latex",3,"int");
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("consolidate_text_nodes",1,SWIGTYPE_p_cmark_node);
+    SWIG_fail_ptr("render_latex",1,SWIGTYPE_p_cmark_node);
   }
   
-  cmark_consolidate_text_nodes(arg1);
-  
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (char *)cmark_render_latex(arg1,arg2,arg3);
+  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4275,16 +6077,16 @@ fail:
 }
 
 
-static int _wrap_parser_new(lua_State* L) {
+static int _wrap_html_cache_new(lua_State* L) {
   int SWIG_arg = 0;
   int arg1 ;
-  cmark_parser *result = 0 ;
+  cmark_html_cache *result = 0 ;
   
-  SWIG_check_num_args("cmark_parser_new",1,1)
-  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_parser_new",1,"int");
+  SWIG_check_num_args("cmark_html_cache_new",1,1)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_html_cache_new",1,"int");
   arg1 = (int)lua_tonumber(L, 1);
-  result = (cmark_parser *)cmark_parser_new(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_parser,0); SWIG_arg++; 
+  result = (cmark_html_cache *)cmark_html_cache_new(arg1);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_html_cache,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4295,23 +6097,23 @@ fail:
 }
 
 
-static int _wrap_parser_new_with_mem(lua_State* L) {
+static int _wrap_html_cache_new_with_mem(lua_State* L) {
   int SWIG_arg = 0;
   int arg1 ;
   cmark_mem *arg2 = (cmark_mem *) 0 ;
-  cmark_parser *result = 0 ;
+  cmark_html_cache *result = 0 ;
   
-  SWIG_check_num_args("cmark_parser_new_with_mem",2,2)
-  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_parser_new_with_mem",1,"int");
-  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_parser_new_with_mem",2,"cmark_mem *");
+  SWIG_check_num_args("cmark_html_cache_new_with_mem",2,2)
+  if(!lua_isnumber(L,1)) SWIG_fail_arg("cmark_html_cache_new_with_mem",1,"int");
+  if(!SWIG_isptrtype(L,2)) SWIG_fail_arg("cmark_html_cache_new_with_mem",2,"cmark_mem *");
   arg1 = (int)lua_tonumber(L, 1);
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_cmark_mem,0))){
-    SWIG_fail_ptr("parser_new_with_mem",2,SWIGTYPE_p_cmark_mem);
+    SWIG_fail_ptr("html_cache_new_with_mem",2,SWIGTYPE_p_cmark_mem);
   }
   
-  result = (cmark_parser *)cmark_parser_new_with_mem(arg1,arg2);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_parser,0); SWIG_arg++; 
+  result = (cmark_html_cache *)cmark_html_cache_new_with_mem(arg1,arg2);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_html_cache,0); SWIG_arg++; 
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4322,18 +6124,18 @@ fail:
 }
 
 
-static int _wrap_parser_free(lua_State* L) {
+static int _wrap_html_cache_free(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_parser *arg1 = (cmark_parser *) 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
   
-  SWIG_check_num_args("cmark_parser_free",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_free",1,"cmark_parser *");
+  SWIG_check_num_args("cmark_html_cache_free",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_free",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
-    SWIG_fail_ptr("parser_free",1,SWIGTYPE_p_cmark_parser);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_free",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  cmark_parser_free(arg1);
+  cmark_html_cache_free(arg1);
   
   return SWIG_arg;
   
@@ -4345,25 +6147,18 @@ fail:
 }
 
 
-static int _wrap_parser_feed(lua_State* L) {
+static int _wrap_html_cache_clear(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_parser *arg1 = (cmark_parser *) 0 ;
-  char *arg2 = (char *) 0 ;
-  size_t arg3 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
   
-  SWIG_check_num_args("cmark_parser_feed",3,3)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_feed",1,"cmark_parser *");
-  if(!SWIG_lua_isnilstring(L,2)) SWIG_fail_arg("cmark_parser_feed",2,"char const *");
-  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_parser_feed",3,"size_t");
+  SWIG_check_num_args("cmark_html_cache_clear",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_clear",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
-    SWIG_fail_ptr("parser_feed",1,SWIGTYPE_p_cmark_parser);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_clear",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (char *)lua_tostring(L, 2);
-  SWIG_contract_assert((lua_tonumber(L,3)>=0),"number must not be negative")
-  arg3 = (size_t)lua_tonumber(L, 3);
-  cmark_parser_feed(arg1,(char const *)arg2,arg3);
+  cmark_html_cache_clear(arg1);
   
   return SWIG_arg;
   
@@ -4375,20 +6170,20 @@ fail:
 }
 
 
-static int _wrap_parser_finish(lua_State* L) {
+static int _wrap_html_cache_get_capacity(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_parser *arg1 = (cmark_parser *) 0 ;
-  cmark_node *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  int result;
   
-  SWIG_check_num_args("cmark_parser_finish",1,1)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parser_finish",1,"cmark_parser *");
+  SWIG_check_num_args("cmark_html_cache_get_capacity",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_capacity",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_parser,0))){
-    SWIG_fail_ptr("parser_finish",1,SWIGTYPE_p_cmark_parser);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_capacity",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  result = (cmark_node *)cmark_parser_finish(arg1);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  result = (int)cmark_html_cache_get_capacity(arg1);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4399,23 +6194,23 @@ fail:
 }
 
 
-static int _wrap_parse_document(lua_State* L) {
+static int _wrap_html_cache_set_capacity(lua_State* L) {
   int SWIG_arg = 0;
-  char *arg1 = (char *) 0 ;
-  size_t arg2 ;
-  int arg3 ;
-  cmark_node *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  int arg2 ;
+  int result;
   
-  SWIG_check_num_args("cmark_parse_document",3,3)
-  if(!SWIG_lua_isnilstring(L,1)) SWIG_fail_arg("cmark_parse_document",1,"char const *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_document",2,"size_t");
-  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_parse_document",3,"int");
-  arg1 = (char *)lua_tostring(L, 1);
-  SWIG_contract_assert((lua_tonumber(L,2)>=0),"number must not be negative")
-  arg2 = (size_t)lua_tonumber(L, 2);
-  arg3 = (int)lua_tonumber(L, 3);
-  result = (cmark_node *)cmark_parse_document((char const *)arg1,arg2,arg3);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  SWIG_check_num_args("cmark_html_cache_set_capacity",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_set_capacity",1,"cmark_html_cache *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_html_cache_set_capacity",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_set_capacity",1,SWIGTYPE_p_cmark_html_cache);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (int)cmark_html_cache_set_capacity(arg1,arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4426,23 +6221,20 @@ fail:
 }
 
 
-static int _wrap_parse_file(lua_State* L) {
+static int _wrap_html_cache_get_policy(lua_State* L) {
   int SWIG_arg = 0;
-  FILE *arg1 = (FILE *) 0 ;
-  int arg2 ;
-  cmark_node *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  cmark_html_cache_policy result;
   
-  SWIG_check_num_args("cmark_parse_file",2,2)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_parse_file",1,"FILE *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_parse_file",2,"int");
+  SWIG_check_num_args("cmark_html_cache_get_policy",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_policy",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_FILE,0))){
-    SWIG_fail_ptr("parse_file",1,SWIGTYPE_p_FILE);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_policy",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (int)lua_tonumber(L, 2);
-  result = (cmark_node *)cmark_parse_file(arg1,arg2);
-  SWIG_NewPointerObj(L,result,SWIGTYPE_p_cmark_node,0); SWIG_arg++; 
+  result = (cmark_html_cache_policy)cmark_html_cache_get_policy(arg1);
+  lua_pushnumber(L, (lua_Number)(int)(result)); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4453,23 +6245,23 @@ fail:
 }
 
 
-static int _wrap_render_xml(lua_State* L) {
+static int _wrap_html_cache_set_policy(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
-  int arg2 ;
-  char *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  cmark_html_cache_policy arg2 ;
+  int result;
   
-  SWIG_check_num_args("cmark_render_xml",2,2)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_xml",1,"cmark_node *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_xml",2,"int");
+  SWIG_check_num_args("cmark_html_cache_set_policy",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_set_policy",1,"cmark_html_cache *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_html_cache_set_policy",2,"cmark_html_cache_policy");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("render_xml",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_set_policy",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (int)lua_tonumber(L, 2);
-  result = (char *)cmark_render_xml(arg1,arg2);
-  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  arg2 = (cmark_html_cache_policy)(int)lua_tonumber(L, 2);
+  result = (int)cmark_html_cache_set_policy(arg1,arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4480,23 +6272,20 @@ fail:
 }
 
 
-static int _wrap_render_html(lua_State* L) {
+static int _wrap_html_cache_get_size(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
-  int arg2 ;
-  char *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  int result;
   
-  SWIG_check_num_args("cmark_render_html",2,2)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_html",1,"cmark_node *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_html",2,"int");
+  SWIG_check_num_args("cmark_html_cache_get_size",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_size",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("render_html",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_size",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (int)lua_tonumber(L, 2);
-  result = (char *)cmark_render_html(arg1,arg2);
-  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  result = (int)cmark_html_cache_get_size(arg1);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4507,26 +6296,20 @@ fail:
 }
 
 
-static int _wrap_render_man(lua_State* L) {
+static int _wrap_html_cache_get_hits(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
-  int arg2 ;
-  int arg3 ;
-  char *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  size_t result;
   
-  SWIG_check_num_args("cmark_render_man",3,3)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_man",1,"cmark_node *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_man",2,"int");
-  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_man",3,"int");
+  SWIG_check_num_args("cmark_html_cache_get_hits",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_hits",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("render_man",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_hits",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (int)lua_tonumber(L, 2);
-  arg3 = (int)lua_tonumber(L, 3);
-  result = (char *)cmark_render_man(arg1,arg2,arg3);
-  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  result = (size_t)cmark_html_cache_get_hits(arg1);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4537,26 +6320,20 @@ fail:
 }
 
 
-static int _wrap_render_commonmark(lua_State* L) {
+static int _wrap_html_cache_get_misses(lua_State* L) {
   int SWIG_arg = 0;
-  cmark_node *arg1 = (cmark_node *) 0 ;
-  int arg2 ;
-  int arg3 ;
-  char *result = 0 ;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  size_t result;
   
-  SWIG_check_num_args("cmark_render_commonmark",3,3)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_commonmark",1,"cmark_node *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_commonmark",2,"int");
-  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_commonmark",3,"int");
+  SWIG_check_num_args("cmark_html_cache_get_misses",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_misses",1,"cmark_html_cache *");
   
-  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("render_commonmark",1,SWIGTYPE_p_cmark_node);
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_misses",1,SWIGTYPE_p_cmark_html_cache);
   }
   
-  arg2 = (int)lua_tonumber(L, 2);
-  arg3 = (int)lua_tonumber(L, 3);
-  result = (char *)cmark_render_commonmark(arg1,arg2,arg3);
-  lua_pushstring(L,(const char *)result); SWIG_arg++;
+  result = (size_t)cmark_html_cache_get_misses(arg1);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4567,26 +6344,55 @@ fail:
 }
 
 
-static int _wrap_render_latex(lua_State* L) {
+static int _wrap_html_cache_get_evictions(lua_State* L) {
+  int SWIG_arg = 0;
+  cmark_html_cache *arg1 = (cmark_html_cache *) 0 ;
+  size_t result;
+  
+  SWIG_check_num_args("cmark_html_cache_get_evictions",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_html_cache_get_evictions",1,"cmark_html_cache *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("html_cache_get_evictions",1,SWIGTYPE_p_cmark_html_cache);
+  }
+  
+  result = (size_t)cmark_html_cache_get_evictions(arg1);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_render_html_cached(lua_State* L) {
   int SWIG_arg = 0;
   cmark_node *arg1 = (cmark_node *) 0 ;
   int arg2 ;
-  int arg3 ;
+  cmark_html_cache *arg3 = (cmark_html_cache *) 0 ;
   char *result = 0 ;
   
-  SWIG_check_num_args("cmark_render_latex",3,3)
-  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_latex",1,"cmark_node *");
-  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_latex",2,"int");
-  if(!lua_isnumber(L,3)) SWIG_fail_arg("cmark_render_latex",3,"int");
+  SWIG_check_num_args("cmark_render_html_cached",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("cmark_render_html_cached",1,"cmark_node *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("cmark_render_html_cached",2,"int");
+  if(!SWIG_isptrtype(L,3)) SWIG_fail_arg("cmark_render_html_cached",3,"cmark_html_cache *");
   
   if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_cmark_node,0))){
-    SWIG_fail_ptr("render_latex",1,SWIGTYPE_p_cmark_node);
+    SWIG_fail_ptr("render_html_cached",1,SWIGTYPE_p_cmark_node);
   }
   
   arg2 = (int)lua_tonumber(L, 2);
-  arg3 = (int)lua_tonumber(L, 3);
-  result = (char *)cmark_render_latex(arg1,arg2,arg3);
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,3,(void**)&arg3,SWIGTYPE_p_cmark_html_cache,0))){
+    SWIG_fail_ptr("render_html_cached",3,SWIGTYPE_p_cmark_html_cache);
+  }
+  
+  result = (char *)cmark_render_html_cached(arg1,arg2,arg3);
   lua_pushstring(L,(const char *)result); SWIG_arg++;
+  cmark_node_get_mem(arg1)->free(result);
   return SWIG_arg;
   
   if(0) SWIG_fail;
@@ -4666,10 +6472,23 @@ static swig_lua_const_info swig_SwigModule_constants[]= {
     {SWIG_LUA_CONSTTAB_INT("NO_DELIM", CMARK_NO_DELIM)},
     {SWIG_LUA_CONSTTAB_INT("PERIOD_DELIM", CMARK_PERIOD_DELIM)},
     {SWIG_LUA_CONSTTAB_INT("PAREN_DELIM", CMARK_PAREN_DELIM)},
+    {SWIG_LUA_CONSTTAB_INT("MEM_PARSE", CMARK_MEM_PARSE)},
+    {SWIG_LUA_CONSTTAB_INT("MEM_INLINES", CMARK_MEM_INLINES)},
+    {SWIG_LUA_CONSTTAB_INT("MEM_RENDER", CMARK_MEM_RENDER)},
+    {SWIG_LUA_CONSTTAB_INT("MEM_PHASES", 3)},
+    {SWIG_LUA_CONSTTAB_INT("LIMIT_NONE", CMARK_LIMIT_NONE)},
+    {SWIG_LUA_CONSTTAB_INT("LIMIT_NODES", CMARK_LIMIT_NODES)},
+    {SWIG_LUA_CONSTTAB_INT("LIMIT_TIME", CMARK_LIMIT_TIME)},
+    {SWIG_LUA_CONSTTAB_INT("LIMIT_OUTPUT", CMARK_LIMIT_OUTPUT)},
     {SWIG_LUA_CONSTTAB_INT("EVENT_NONE", CMARK_EVENT_NONE)},
     {SWIG_LUA_CONSTTAB_INT("EVENT_DONE", CMARK_EVENT_DONE)},
     {SWIG_LUA_CONSTTAB_INT("EVENT_ENTER", CMARK_EVENT_ENTER)},
     {SWIG_LUA_CONSTTAB_INT("EVENT_EXIT", CMARK_EVENT_EXIT)},
+    {SWIG_LUA_CONSTTAB_INT("HTML_CACHE_LRU", CMARK_HTML_CACHE_LRU)},
+    {SWIG_LUA_CONSTTAB_INT("HTML_CACHE_FIFO", CMARK_HTML_CACHE_FIFO)},
+    {SWIG_LUA_CONSTTAB_INT("HTML_HOOK_DEFAULT", CMARK_HTML_HOOK_DEFAULT)},
+    {SWIG_LUA_CONSTTAB_INT("HTML_HOOK_REPLACE", CMARK_HTML_HOOK_REPLACE)},
+    {SWIG_LUA_CONSTTAB_INT("HTML_HOOK_SKIP", CMARK_HTML_HOOK_SKIP)},
     {SWIG_LUA_CONSTTAB_INT("OPT_DEFAULT", 0)},
     {SWIG_LUA_CONSTTAB_INT("OPT_SOURCEPOS", (1 << 1))},
     {SWIG_LUA_CONSTTAB_INT("OPT_HARDBREAKS", (1 << 2))},
@@ -4678,19 +6497,28 @@ static swig_lua_const_info swig_SwigModule_constants[]= {
     {SWIG_LUA_CONSTTAB_INT("OPT_NORMALIZE", (1 << 8))},
     {SWIG_LUA_CONSTTAB_INT("OPT_VALIDATE_UTF8", (1 << 9))},
     {SWIG_LUA_CONSTTAB_INT("OPT_SMART", (1 << 10))},
+    {SWIG_LUA_CONSTTAB_INT("OPT_REFERENCES_FIRST", (1 << 11))},
+    {SWIG_LUA_CONSTTAB_INT("OPT_LAZY_INLINES", (1 << 12))},
+    {SWIG_LUA_CONSTTAB_INT("OPT_NODE_INDEX", (1 << 13))},
+    {SWIG_LUA_CONSTTAB_INT("OPT_STATS", (1 << 14))},
     {0,0,0,0,0,0}
 };
 static swig_lua_method swig_SwigModule_methods[]= {
     { "markdown_to_html", _wrap_markdown_to_html},
+    { "mem_account_new", _wrap_mem_account_new},
+    { "mem_account_new_with_mem", _wrap_mem_account_new_with_mem},
+    { "mem_account_free", _wrap_mem_account_free},
+    { "mem_account_get_mem", _wrap_mem_account_get_mem},
+    { "node_get_mem", _wrap_node_get_mem},
     { "node_new", _wrap_node_new},
     { "node_new_with_mem", _wrap_node_new_with_mem},
-    { "node_free", _wrap_node_free},
     { "node_next", _wrap_node_next},
     { "node_previous", _wrap_node_previous},
     { "node_parent", _wrap_node_parent},
     { "node_first_child", _wrap_node_first_child},
     { "node_last_child", _wrap_node_last_child},
     { "iter_new", _wrap_iter_new},
+    { "iter_new_with_mem", _wrap_iter_new_with_mem},
     { "iter_free", _wrap_iter_free},
     { "iter_next", _wrap_iter_next},
     { "iter_get_node", _wrap_iter_get_node},
@@ -4734,20 +6562,55 @@ static swig_lua_method swig_SwigModule_methods[]= {
     { "node_prepend_child", _wrap_node_prepend_child},
     { "node_append_child", _wrap_node_append_child},
     { "consolidate_text_nodes", _wrap_consolidate_text_nodes},
+    { "node_deserialize", _wrap_node_deserialize},
     { "parser_new", _wrap_parser_new},
     { "parser_new_with_mem", _wrap_parser_new_with_mem},
     { "parser_free", _wrap_parser_free},
     { "parser_feed", _wrap_parser_feed},
     { "parser_finish", _wrap_parser_finish},
+    { "parser_get_exceeded_limit", _wrap_parser_get_exceeded_limit},
+    { "node_get_exceeded_limit", _wrap_node_get_exceeded_limit},
     { "parse_document", _wrap_parse_document},
     { "parse_file", _wrap_parse_file},
+    { "parse_fd", _wrap_parse_fd},
+    { "parse_path", _wrap_parse_path},
     { "render_xml", _wrap_render_xml},
+    { "render_json", _wrap_render_json},
     { "render_html", _wrap_render_html},
     { "render_man", _wrap_render_man},
     { "render_commonmark", _wrap_render_commonmark},
     { "render_latex", _wrap_render_latex},
+    { "html_cache_new", _wrap_html_cache_new},
+    { "html_cache_new_with_mem", _wrap_html_cache_new_with_mem},
+    { "html_cache_free", _wrap_html_cache_free},
+    { "html_cache_clear", _wrap_html_cache_clear},
+    { "html_cache_get_capacity", _wrap_html_cache_get_capacity},
+    { "html_cache_set_capacity", _wrap_html_cache_set_capacity},
+    { "html_cache_get_policy", _wrap_html_cache_get_policy},
+    { "html_cache_set_policy", _wrap_html_cache_set_policy},
+    { "html_cache_get_size", _wrap_html_cache_get_size},
+    { "html_cache_get_hits", _wrap_html_cache_get_hits},
+    { "html_cache_get_misses", _wrap_html_cache_get_misses},
+    { "html_cache_get_evictions", _wrap_html_cache_get_evictions},
+    { "render_html_cached", _wrap_render_html_cached},
     { "version", _wrap_version},
     { "version_string", _wrap_version_string},
+    { "node_hash", lua_cmark_node_hash},
+    { "node_serialize", lua_cmark_node_serialize},
+    { "markdown_to_html_stream", lua_cmark_markdown_to_html_stream},
+    { "extract_outline", lua_cmark_extract_outline},
+    { "render_json_stream", lua_cmark_render_json_stream},
+    { "render_plaintext", lua_cmark_render_plaintext},
+    { "render_html_with_hooks", lua_cmark_render_html_with_hooks},
+    { "walk", lua_cmark_walk},
+    { "to_table", lua_cmark_to_table},
+    { "build_node", lua_cmark_build_node},
+    { "parse_string_borrowed", lua_cmark_parse_string_borrowed},
+    { "node_free", lua_cmark_node_free},
+    { "select", lua_cmark_select},
+    { "get_stats", lua_cmark_get_stats},
+    { "mem_account_get_usage", lua_cmark_mem_account_get_usage},
+    { "parser_set_limits", lua_cmark_parser_set_limits},
     {0,0}
 };
 static swig_lua_class* swig_SwigModule_classes[]= {
@@ -4775,9 +6638,12 @@ static swig_lua_namespace swig_SwigModule = {
 static swig_type_info _swigt__p_FILE = {"_p_FILE", "FILE *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_delim_type = {"_p_cmark_delim_type", "enum cmark_delim_type *|cmark_delim_type *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_event_type = {"_p_cmark_event_type", "enum cmark_event_type *|cmark_event_type *", 0, 0, (void*)0, 0};
+static swig_type_info _swigt__p_cmark_html_cache = {"_p_cmark_html_cache", "struct cmark_html_cache *|cmark_html_cache *", 0, 0, (void*)0, 0};
+static swig_type_info _swigt__p_cmark_html_cache_policy = {"_p_cmark_html_cache_policy", "enum cmark_html_cache_policy *|cmark_html_cache_policy *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_iter = {"_p_cmark_iter", "struct cmark_iter *|cmark_iter *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_list_type = {"_p_cmark_list_type", "enum cmark_list_type *|cmark_list_type *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_mem = {"_p_cmark_mem", "struct cmark_mem *|cmark_mem *", 0, 0, (void*)&_wrap_class_mem, 0};
+static swig_type_info _swigt__p_cmark_mem_account = {"_p_cmark_mem_account", "cmark_mem_account *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_node = {"_p_cmark_node", "struct cmark_node *|cmark_node *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_node_type = {"_p_cmark_node_type", "enum cmark_node_type *|cmark_node_type *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_cmark_parser = {"_p_cmark_parser", "struct cmark_parser *|cmark_parser *", 0, 0, (void*)0, 0};
@@ -4790,9 +6656,12 @@ static swig_type_info *swig_type_initial[] = {
   &_swigt__p_FILE,
   &_swigt__p_cmark_delim_type,
   &_swigt__p_cmark_event_type,
+  &_swigt__p_cmark_html_cache,
+  &_swigt__p_cmark_html_cache_policy,
   &_swigt__p_cmark_iter,
   &_swigt__p_cmark_list_type,
   &_swigt__p_cmark_mem,
+  &_swigt__p_cmark_mem_account,
   &_swigt__p_cmark_node,
   &_swigt__p_cmark_node_type,
   &_swigt__p_cmark_parser,
@@ -4805,9 +6674,12 @@ static swig_type_info *swig_type_initial[] = {
 static swig_cast_info _swigc__p_FILE[] = {  {&_swigt__p_FILE, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_delim_type[] = {  {&_swigt__p_cmark_delim_type, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_event_type[] = {  {&_swigt__p_cmark_event_type, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_cmark_html_cache[] = {  {&_swigt__p_cmark_html_cache, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_cmark_html_cache_policy[] = {  {&_swigt__p_cmark_html_cache_policy, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_iter[] = {  {&_swigt__p_cmark_iter, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_list_type[] = {  {&_swigt__p_cmark_list_type, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_mem[] = {  {&_swigt__p_cmark_mem, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_cmark_mem_account[] = {  {&_swigt__p_cmark_mem_account, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_node[] = {  {&_swigt__p_cmark_node, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_node_type[] = {  {&_swigt__p_cmark_node_type, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_cmark_parser[] = {  {&_swigt__p_cmark_parser, 0, 0, 0},{0, 0, 0, 0}};
@@ -4820,9 +6692,12 @@ static swig_cast_info *swig_cast_initial[] = {
   _swigc__p_FILE,
   _swigc__p_cmark_delim_type,
   _swigc__p_cmark_event_type,
+  _swigc__p_cmark_html_cache,
+  _swigc__p_cmark_html_cache_policy,
   _swigc__p_cmark_iter,
   _swigc__p_cmark_list_type,
   _swigc__p_cmark_mem,
+  _swigc__p_cmark_mem_account,
   _swigc__p_cmark_node,
   _swigc__p_cmark_node_type,
   _swigc__p_cmark_parser,
@@ -5162,18 +7037,52 @@ const char* SWIG_LUACODE=
   "   return cmark.parse_document(s, string.len(s), opts)\n"
   "end\n"
   "\n"
-  "function cmark.walk(node)\n"
-  "   local iter = cmark.iter_new(node)\n"
-  "   return function()\n"
-  "     while true do\n"
-  "         local et = cmark.iter_next(iter)\n"
-  "         if et == cmark.EVENT_DONE then break end\n"
-  "         local cur = cmark.iter_get_node(iter)\n"
-  "         return cur, (et == cmark.EVENT_ENTER), cmark.node_get_type(cur)\n"
-  "     end\n"
-  "     cmark.iter_free(iter)\n"
-  "     return nil\n"
+  "-- Replaces the wrapper for cmark_parse_file, which needs a FILE *.\n"
+  "function cmark.parse_file(path, opts)\n"
+  "   local doc = cmark.parse_path(path, opts)\n"
+  "   if not doc then\n"
+  "      return nil, \"could not read \" .. tostring(path)\n"
+  "   end\n"
+  "   return doc\n"
+  "end\n"
+  "\n"
+  "-- Parses 's' with the allocator 'mem', such as that of a memory\n"
+  "-- account.  Returns nil and an error message if the account refuses\n"
+  "-- an allocation.\n"
+  "function cmark.parse_string_with_mem(s, opts, mem)\n"
+  "   local parser = cmark.parser_new_with_mem(opts, mem)\n"
+  "   if not parser then\n"
+  "      return nil, \"memory limit exceeded\"\n"
+  "   end\n"
+  "   cmark.parser_feed(parser, s, string.len(s))\n"
+  "   local doc = cmark.parser_finish(parser)\n"
+  "   cmark.parser_free(parser)\n"
+  "   if not doc then\n"
+  "      return nil, \"memory limit exceeded\"\n"
+  "   end\n"
+  "   return doc\n"
+  "end\n"
+  "\n"
+  "local limit_messages = {\n"
+  "   [cmark.LIMIT_NODES] = \"node limit exceeded\",\n"
+  "   [cmark.LIMIT_TIME] = \"time limit exceeded\",\n"
+  "   [cmark.LIMIT_OUTPUT] = \"output limit exceeded\",\n"
+  "}\n"
+  "\n"
+  "-- Parses 's' under the resource limits in the table 'limits' (see\n"
+  "-- parser_set_limits).  Returns nil and an error message if the parse\n"
+  "-- goes past the node or time limit.\n"
+  "function cmark.parse_string_with_limits(s, opts, limits)\n"
+  "   local parser = cmark.parser_new(opts)\n"
+  "   cmark.parser_set_limits(parser, limits)\n"
+  "   cmark.parser_feed(parser, s, string.len(s))\n"
+  "   local doc = cmark.parser_finish(parser)\n"
+  "   local exceeded = cmark.parser_get_exceeded_limit(parser)\n"
+  "   cmark.parser_free(parser)\n"
+  "   if not doc then\n"
+  "      return nil, limit_messages[exceeded]\n"
   "   end\n"
+  "   return doc\n"
   "end";
 
 void SWIG_init_user(lua_State* L)
@@ -0,0 +1,295 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "accounting.h"
+
+// Memory accounts.
+//
+// The functions of a cmark_mem take no context, so the library
+// allocates through cmark_mem_calloc and cmark_mem_realloc, which
+// recognize an account by its 'free' function.  Every block allocated
+// through an account starts with a header that records its size.  A
+// block allocated while a parser guards the account is also linked
+// into the list of that parser's blocks, so that a parser that fails
+// can free everything it allocated without touching the memory of
+// other users of the account.
+
+typedef struct cmark_mem_block {
+  struct cmark_mem_block *prev;
+  struct cmark_mem_block *next;
+  cmark_mem_account *account; // NULL if allocated outside the account
+  cmark_mem_owner *owner;     // NULL if not in an owner's list
+  size_t size;
+} block;
+
+// Rounded up so that the memory after the header stays aligned.
+#define HEADER_SIZE ((sizeof(block) + 15) & ~(size_t)15)
+#define HEADER(ptr) ((block *)((char *)(ptr)-HEADER_SIZE))
+#define DATA(b) ((void *)((char *)(b) + HEADER_SIZE))
+
+struct cmark_mem_account {
+  cmark_mem mem; // first, so that a cmark_mem * can be cast back
+  cmark_mem *inner;
+  size_t limit;
+  cmark_mem_usage usage;
+  cmark_mem_phase phase;
+  cmark_mem_jump *jump;
+  size_t blocks; // live blocks, which keep the account alive
+  bool freed;    // freed by the caller, once the last block is freed
+};
+
+static cmark_mem SYSTEM_MEM = {calloc, realloc, free};
+
+// The functions of the account's cmark_mem, for callers outside the
+// library.  They cannot tell which account they belong to, so their
+// blocks are allocated with the system allocator and not counted.
+static void *S_calloc(size_t nmem, size_t size) {
+  block *b;
+
+  if (size && nmem > (SIZE_MAX - HEADER_SIZE) / size)
+    abort();
+  b = (block *)calloc(1, HEADER_SIZE + nmem * size);
+  if (b == NULL)
+    abort();
+  return DATA(b);
+}
+
+static void *S_realloc(void *ptr, size_t size) {
+  block *b;
+
+  if (ptr == NULL)
+    return S_calloc(1, size);
+  b = HEADER(ptr);
+  if (b->account)
+    return cmark_mem_account_realloc(b->account, ptr, size);
+  if (size > SIZE_MAX - HEADER_SIZE)
+    abort();
+  b = (block *)realloc(b, HEADER_SIZE + size);
+  if (b == NULL)
+    abort();
+  return DATA(b);
+}
+
+// Refuses an allocation: a guarded parser is sent back to its entry
+// point, and anything else runs out of memory the way the default
+// allocator does.
+static void S_refuse(cmark_mem_account *account, int exceeded) {
+  if (exceeded)
+    account->usage.exceeded = 1;
+  if (account->jump)
+    longjmp(account->jump->env, 1);
+  if (!exceeded)
+    abort();
+}
+
+static void S_grow(cmark_mem_account *account, size_t bytes) {
+  cmark_mem_usage *usage = &account->usage;
+
+  usage->live += bytes;
+  if (usage->live > usage->peak)
+    usage->peak = usage->live;
+  usage->bytes[account->phase] += bytes;
+}
+
+void *cmark_mem_account_calloc(cmark_mem_account *account, size_t nmem,
+                               size_t size) {
+  size_t total;
+  block *b;
+
+  if (size && nmem > (SIZE_MAX - HEADER_SIZE) / size)
+    S_refuse(account, 0);
+  total = nmem * size;
+  if (account->limit && account->usage.live + total > account->limit)
+    S_refuse(account, 1);
+  b = (block *)account->inner->calloc(1, HEADER_SIZE + total);
+  if (b == NULL)
+    S_refuse(account, 0);
+
+  b->account = account;
+  b->size = total;
+  b->owner = account->jump ? account->jump->owner : NULL;
+  if (b->owner) {
+    b->next = b->owner->blocks;
+    if (b->next)
+      b->next->prev = b;
+    b->owner->blocks = b;
+  }
+
+  account->blocks++;
+  account->usage.allocations[account->phase]++;
+  S_grow(account, total);
+  return DATA(b);
+}
+
+void *cmark_mem_account_realloc(cmark_mem_account *account, void *ptr,
+                                size_t size) {
+  block *b, *moved;
+  size_t old_size;
+
+  if (ptr == NULL)
+    return cmark_mem_account_calloc(account, 1, size);
+  b = HEADER(ptr);
+  old_size = b->size;
+  if (size > SIZE_MAX - HEADER_SIZE)
+    S_refuse(account, 0);
+  if (account->limit && size > old_size &&
+      account->usage.live + (size - old_size) > account->limit)
+    S_refuse(account, 1);
+  moved = (block *)account->inner->realloc(b, HEADER_SIZE + size);
+  if (moved == NULL)
+    S_refuse(account, 0);
+
+  // The block keeps its place in its owner's list.
+  if (moved->prev)
+    moved->prev->next = moved;
+  else if (moved->owner)
+    moved->owner->blocks = moved;
+  if (moved->next)
+    moved->next->prev = moved;
+  moved->size = size;
+
+  account->usage.reallocations[account->phase]++;
+  if (size > old_size)
+    S_grow(account, size - old_size);
+  else
+    account->usage.live -= old_size - size;
+  return DATA(moved);
+}
+
+static void S_free_block(cmark_mem_account *account, block *b) {
+  if (b->prev)
+    b->prev->next = b->next;
+  else if (b->owner)
+    b->owner->blocks = b->next;
+  if (b->next)
+    b->next->prev = b->prev;
+  account->usage.live -= b->size;
+  account->usage.frees++;
+  account->inner->free(b);
+  if (--account->blocks == 0 && account->freed)
+    account->inner->free(account);
+}
+
+void cmark_mem_account_release(void *ptr) {
+  block *b;
+
+  if (ptr == NULL)
+    return;
+  b = HEADER(ptr);
+  if (b->account)
+    S_free_block(b->account, b);
+  else
+    free(b);
+}
+
+cmark_mem_account *cmark_mem_account_new(size_t limit) {
+  return cmark_mem_account_new_with_mem(limit, &SYSTEM_MEM);
+}
+
+cmark_mem_account *cmark_mem_account_new_with_mem(size_t limit,
+                                                  cmark_mem *mem) {
+  cmark_mem_account *account =
+      (cmark_mem_account *)mem->calloc(1, sizeof(cmark_mem_account));
+
+  account->mem.calloc = S_calloc;
+  account->mem.realloc = S_realloc;
+  account->mem.free = cmark_mem_account_release;
+  account->inner = mem;
+  account->limit = limit;
+  account->phase = CMARK_MEM_PARSE;
+  return account;
+}
+
+void cmark_mem_account_free(cmark_mem_account *account) {
+  if (account == NULL)
+    return;
+  if (account->blocks)
+    account->freed = true;
+  else
+    account->inner->free(account);
+}
+
+cmark_mem *cmark_mem_account_get_mem(cmark_mem_account *account) {
+  return &account->mem;
+}
+
+const cmark_mem_usage *cmark_mem_account_get_usage(cmark_mem_account *account) {
+  return &account->usage;
+}
+
+cmark_mem *cmark_node_get_mem(cmark_node *node) {
+  return cmark_node_mem(node);
+}
+
+cmark_mem_phase cmark_mem_set_phase(cmark_mem *mem, cmark_mem_phase phase) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+  cmark_mem_phase previous;
+
+  if (account == NULL)
+    return phase;
+  previous = account->phase;
+  account->phase = phase;
+  return previous;
+}
+
+void cmark_mem_guard(cmark_mem *mem, cmark_mem_jump *jump,
+                     cmark_mem_owner *owner) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+
+  jump->owner = owner;
+  jump->outer = NULL;
+  if (account == NULL)
+    return;
+  jump->outer = account->jump;
+  account->jump = jump;
+}
+
+void cmark_mem_unguard(cmark_mem *mem, cmark_mem_jump *jump) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+
+  if (account)
+    account->jump = jump->outer;
+}
+
+cmark_mem_jump *cmark_mem_suspend(cmark_mem *mem) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+  cmark_mem_jump *jump;
+
+  if (account == NULL)
+    return NULL;
+  jump = account->jump;
+  account->jump = NULL;
+  return jump;
+}
+
+void cmark_mem_resume(cmark_mem *mem, cmark_mem_jump *jump) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+
+  if (account)
+    account->jump = jump;
+}
+
+void cmark_mem_release(cmark_mem *mem, cmark_mem_owner *owner) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+
+  if (account == NULL)
+    return;
+  while (owner->blocks)
+    S_free_block(account, owner->blocks);
+}
+
+void cmark_mem_disown(cmark_mem_owner *owner) {
+  block *b, *next;
+
+  for (b = owner->blocks; b; b = next) {
+    next = b->next;
+    b->prev = b->next = NULL;
+    b->owner = NULL;
+  }
+  owner->blocks = NULL;
+}
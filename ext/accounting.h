@@ -0,0 +1,84 @@
+#ifndef CMARK_ACCOUNTING_H
+#define CMARK_ACCOUNTING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <setjmp.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "cmark.h"
+
+void *cmark_mem_account_calloc(cmark_mem_account *account, size_t nmem,
+                               size_t size);
+void *cmark_mem_account_realloc(cmark_mem_account *account, void *ptr,
+                                size_t size);
+void cmark_mem_account_release(void *ptr);
+
+// Returns the account of 'mem', or NULL if it is not an account.
+static CMARK_INLINE cmark_mem_account *cmark_mem_account_of(cmark_mem *mem) {
+  return mem->free == cmark_mem_account_release ? (cmark_mem_account *)mem
+                                                : NULL;
+}
+
+// The library allocates through these rather than the functions of
+// 'mem', so that an account knows what an allocation is for.
+static CMARK_INLINE void *cmark_mem_calloc(cmark_mem *mem, size_t nmem,
+                                           size_t size) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+  return account ? cmark_mem_account_calloc(account, nmem, size)
+                 : mem->calloc(nmem, size);
+}
+
+static CMARK_INLINE void *cmark_mem_realloc(cmark_mem *mem, void *ptr,
+                                            size_t size) {
+  cmark_mem_account *account = cmark_mem_account_of(mem);
+  return account ? cmark_mem_account_realloc(account, ptr, size)
+                 : mem->realloc(ptr, size);
+}
+
+// Attributes the allocations made through 'mem', if it is an account,
+// to 'phase'.  Returns the phase they were attributed to.
+cmark_mem_phase cmark_mem_set_phase(cmark_mem *mem, cmark_mem_phase phase);
+
+// The blocks allocated through an account for one user of it (a
+// parser), and not freed yet.
+typedef struct cmark_mem_owner {
+  struct cmark_mem_block *blocks;
+} cmark_mem_owner;
+
+// Where an allocation that is refused jumps to, and who owns what is
+// allocated meanwhile.
+typedef struct cmark_mem_jump {
+  jmp_buf env;
+  cmark_mem_owner *owner; // may be NULL, and may be changed while set
+  struct cmark_mem_jump *outer;
+} cmark_mem_jump;
+
+// Makes an allocation through 'mem' that would go past the limit of
+// its account (or that its allocator refuses) longjmp to 'jump->env'
+// instead, and adds the blocks allocated to 'owner', until
+// cmark_mem_unguard restores the jump it replaced.
+void cmark_mem_guard(cmark_mem *mem, cmark_mem_jump *jump,
+                     cmark_mem_owner *owner);
+void cmark_mem_unguard(cmark_mem *mem, cmark_mem_jump *jump);
+
+// Lifts the guard of 'mem' around a call out of the library, whose
+// allocations are not the owner's.  Returns what cmark_mem_resume
+// restores.
+cmark_mem_jump *cmark_mem_suspend(cmark_mem *mem);
+void cmark_mem_resume(cmark_mem *mem, cmark_mem_jump *jump);
+
+// Frees the blocks of 'owner'.
+void cmark_mem_release(cmark_mem *mem, cmark_mem_owner *owner);
+
+// Leaves the blocks of 'owner' allocated, but no longer its own.
+void cmark_mem_disown(cmark_mem_owner *owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,16 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <setjmp.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include "cmark_ctype.h"
 #include "config.h"
@@ -18,8 +28,11 @@
 #include "utf8.h"
 #include "scanners.h"
 #include "inlines.h"
+#include "accounting.h"
 #include "houdini.h"
 #include "buffer.h"
+#include "stats.h"
+#include "limiter.h"
 
 #define CODE_INDENT 4
 #define TAB_STOP 4
@@ -54,16 +67,16 @@ static CMARK_INLINE bool S_is_space_or_tab(char c) {
 }
 
 static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
-                          size_t len, bool eof);
+                          size_t len, bool eof, bool in_place);
 
 static void S_process_line(cmark_parser *parser, const unsigned char *buffer,
-                           bufsize_t bytes);
+                           bufsize_t bytes, bool in_place);
 
 static cmark_node *make_block(cmark_mem *mem, cmark_node_type tag,
                               int start_line, int start_column) {
   cmark_node *e;
 
-  e = (cmark_node *)mem->calloc(1, sizeof(*e));
+  e = (cmark_node *)cmark_mem_calloc(mem, 1, sizeof(*e));
   cmark_strbuf_init(mem, &e->content, 32);
   e->type = (uint16_t)tag;
   e->flags = CMARK_NODE__OPEN;
@@ -80,8 +93,8 @@ static cmark_node *make_document(cmark_mem *mem) {
   return e;
 }
 
-cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem) {
-  cmark_parser *parser = (cmark_parser *)mem->calloc(1, sizeof(cmark_parser));
+static void S_parser_init(cmark_parser *parser, int options,
+                          cmark_mem *mem) {
   parser->mem = mem;
 
   cmark_node *document = make_document(mem);
@@ -104,6 +117,33 @@ cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem) {
   parser->options = options;
   parser->last_buffer_ended_with_cr = false;
 
+  if (options & CMARK_OPT_STATS) {
+    parser->stats =
+        (cmark_stats *)cmark_mem_calloc(mem, 1, sizeof(cmark_stats));
+    parser->stats->nodes[CMARK_NODE_DOCUMENT] = 1;
+    document->as.document.stats = parser->stats;
+  }
+}
+
+cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem) {
+  cmark_mem_jump jump;
+  cmark_parser *volatile parser = NULL;
+
+  cmark_mem_guard(mem, &jump, NULL);
+  if (setjmp(jump.env)) {
+    cmark_mem_unguard(mem, &jump);
+    if (parser) {
+      cmark_mem_release(mem, &parser->mem_owner);
+      mem->free(parser);
+    }
+    return NULL;
+  }
+  // The parser itself is not among its blocks, which it frees if it
+  // fails.
+  parser = (cmark_parser *)cmark_mem_calloc(mem, 1, sizeof(cmark_parser));
+  jump.owner = &parser->mem_owner;
+  S_parser_init(parser, options, mem);
+  cmark_mem_unguard(mem, &jump);
   return parser;
 }
 
@@ -114,6 +154,7 @@ cmark_parser *cmark_parser_new(int options) {
 
 void cmark_parser_free(cmark_parser *parser) {
   cmark_mem *mem = parser->mem;
+  cmark_mem_disown(&parser->mem_owner);
   cmark_strbuf_free(&parser->curline);
   cmark_strbuf_free(&parser->linebuf);
   cmark_reference_map_free(parser->refmap);
@@ -162,10 +203,48 @@ static CMARK_INLINE bool contains_inlines(cmark_node_type block_type) {
           block_type == CMARK_NODE_HEADING);
 }
 
+// Keeps track of whether the lines of a leaf block are contiguous in
+// the input, so that its content can be borrowed when it is finalized.
+static void S_track_line(cmark_parser *parser, cmark_node *node,
+                         const unsigned char *data, bufsize_t len) {
+  if (node->content.size == 0) {
+    parser->borrow_node = node;
+    parser->borrow_start = data;
+    parser->borrow_len = 0;
+    parser->borrow_contiguous = true;
+  } else if (node != parser->borrow_node) {
+    return;
+  }
+  if (!parser->line_in_place || parser->partially_consumed_tab ||
+      data != parser->borrow_start + parser->borrow_len)
+    parser->borrow_contiguous = false;
+  parser->borrow_len += len;
+}
+
+// Returns where the content of 'node', less the first 'offset' bytes
+// added to it, is found in the input, or NULL if it is not a slice of
+// the input.
+static const unsigned char *S_borrowable(cmark_parser *parser,
+                                         cmark_node *node, bufsize_t offset) {
+  const unsigned char *data;
+
+  if (!parser->borrow || node != parser->borrow_node ||
+      !parser->borrow_contiguous ||
+      offset + node->content.size > parser->borrow_len)
+    return NULL;
+  data = parser->borrow_start + offset;
+  if (memcmp(data, node->content.ptr, node->content.size) != 0)
+    return NULL;
+  return data;
+}
+
 static void add_line(cmark_node *node, cmark_chunk *ch, cmark_parser *parser) {
   int chars_to_tab;
   int i;
   assert(node->flags & CMARK_NODE__OPEN);
+  if (parser->borrow)
+    S_track_line(parser, node, ch->data + parser->offset,
+                 ch->len - parser->offset);
   if (parser->partially_consumed_tab) {
     parser->offset += 1; // skip over tab
     // add space characters:
@@ -233,7 +312,7 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
          CMARK_NODE__OPEN); // shouldn't call finalize on closed blocks
   b->flags &= ~CMARK_NODE__OPEN;
 
-  if (parser->curline.size == 0) {
+  if (parser->line.len == 0) {
     // end of input - line number has not been incremented
     b->end_line = parser->line_number;
     b->end_column = parser->last_line_length;
@@ -241,10 +320,10 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
              (S_type(b) == CMARK_NODE_CODE_BLOCK && b->as.code.fenced) ||
              (S_type(b) == CMARK_NODE_HEADING && b->as.heading.setext)) {
     b->end_line = parser->line_number;
-    b->end_column = parser->curline.size;
-    if (b->end_column && parser->curline.ptr[b->end_column - 1] == '\n')
+    b->end_column = parser->line.len;
+    if (b->end_column && parser->line.data[b->end_column - 1] == '\n')
       b->end_column -= 1;
-    if (b->end_column && parser->curline.ptr[b->end_column - 1] == '\r')
+    if (b->end_column && parser->line.data[b->end_column - 1] == '\r')
       b->end_column -= 1;
   } else {
     b->end_line = parser->line_number - 1;
@@ -252,21 +331,47 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
   }
 
   cmark_strbuf *node_content = &b->content;
+  cmark_chunk rest;
+  const unsigned char *borrowed;
+  bufsize_t dropped = 0;
+  uint64_t start = 0;
 
   switch (S_type(b)) {
   case CMARK_NODE_PARAGRAPH:
-    while (cmark_strbuf_at(node_content, 0) == '[' &&
-           (pos = cmark_parse_reference_inline(parser->mem, node_content,
+    if (parser->stats && cmark_strbuf_at(node_content, 0) == '[')
+      start = cmark_stats_now();
+    // The definitions are skipped over and dropped together, so that a
+    // paragraph of many definitions is not moved once for each.
+    rest.data = node_content->ptr;
+    rest.len = node_content->size;
+    rest.alloc = 0;
+    while (rest.len && rest.data[0] == '[' &&
+           (pos = cmark_parse_reference_inline(parser->mem, &rest,
                                                parser->refmap))) {
-
-      cmark_strbuf_drop(node_content, pos);
+      rest.data += pos;
+      rest.len -= pos;
+      dropped += pos;
+      if (parser->stats)
+        parser->stats->references_defined++;
     }
+    cmark_strbuf_drop(node_content, dropped);
+    if (start)
+      parser->stats->reference_ns += cmark_stats_now() - start;
     if (is_blank(node_content, 0)) {
       // remove blank node (former reference def)
       cmark_node_free(b);
+      if (parser->stats)
+        parser->stats->nodes[CMARK_NODE_PARAGRAPH]--;
+    } else if ((borrowed = S_borrowable(parser, b, dropped))) {
+      cmark_strbuf_borrow(node_content, borrowed, node_content->size);
     }
     break;
 
+  case CMARK_NODE_HEADING:
+    if ((borrowed = S_borrowable(parser, b, 0)))
+      cmark_strbuf_borrow(node_content, borrowed, node_content->size);
+    break;
+
   case CMARK_NODE_CODE_BLOCK:
     if (!b->as.code.fenced) { // indented code
       remove_trailing_blank_lines(node_content);
@@ -290,12 +395,27 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
       if (node_content->ptr[pos] == '\n')
         pos += 1;
       cmark_strbuf_drop(node_content, pos);
+      dropped = pos;
+    }
+    if ((borrowed = S_borrowable(parser, b, dropped))) {
+      b->as.code.literal.data = (unsigned char *)borrowed;
+      b->as.code.literal.len = node_content->size;
+      b->as.code.literal.alloc = 0;
+      cmark_strbuf_free(node_content);
+    } else {
+      b->as.code.literal = cmark_chunk_buf_detach(node_content);
     }
-    b->as.code.literal = cmark_chunk_buf_detach(node_content);
     break;
 
   case CMARK_NODE_HTML_BLOCK:
-    b->as.literal = cmark_chunk_buf_detach(node_content);
+    if ((borrowed = S_borrowable(parser, b, 0))) {
+      b->as.literal.data = (unsigned char *)borrowed;
+      b->as.literal.len = node_content->size;
+      b->as.literal.alloc = 0;
+      cmark_strbuf_free(node_content);
+    } else {
+      b->as.literal = cmark_chunk_buf_detach(node_content);
+    }
     break;
 
   case CMARK_NODE_LIST:      // determine tight/loose status
@@ -347,6 +467,10 @@ static cmark_node *add_child(cmark_parser *parser, cmark_node *parent,
   cmark_node *child =
       make_block(parser->mem, block_type, parser->line_number, start_column);
   child->parent = parent;
+  if (parser->stats)
+    parser->stats->nodes[block_type]++;
+  if (parser->limiter)
+    cmark_limiter_add_nodes(parser->limiter, 1);
 
   if (parent->last_child) {
     parent->last_child->next = child;
@@ -361,8 +485,8 @@ static cmark_node *add_child(cmark_parser *parser, cmark_node *parent,
 
 // Walk through node and all children, recursively, parsing
 // string content into inline content where appropriate.
-static void process_inlines(cmark_mem *mem, cmark_node *root,
-                            cmark_reference_map *refmap, int options) {
+static void process_inlines(cmark_parser *parser, cmark_node *root,
+                            cmark_reference_map *refmap) {
   cmark_iter *iter = cmark_iter_new(root);
   cmark_node *cur;
   cmark_event_type ev_type;
@@ -371,14 +495,106 @@ static void process_inlines(cmark_mem *mem, cmark_node *root,
     cur = cmark_iter_get_node(iter);
     if (ev_type == CMARK_EVENT_ENTER) {
       if (contains_inlines(S_type(cur))) {
-        cmark_parse_inlines(mem, cur, refmap, options);
+        cmark_parse_inlines(parser->mem, cur, refmap, parser->options,
+                            parser->stats, parser->limiter);
+      }
+    }
+  }
+
+  cmark_iter_free(iter);
+}
+
+// Marks every block under 'root' that contains inlines, so that they
+// are parsed when the block's children are first asked for.
+static void defer_inlines(cmark_node *root) {
+  cmark_iter *iter = cmark_iter_new(root);
+  cmark_node *cur;
+  cmark_event_type ev_type;
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    if (ev_type == CMARK_EVENT_ENTER && contains_inlines(S_type(cur))) {
+      cur->flags |= CMARK_NODE__PENDING_INLINES;
+    }
+  }
+
+  cmark_iter_free(iter);
+}
+
+// Frees the inline children of every block under 'root' that contains
+// inlines, so that they can be parsed again.
+static void clear_inlines(cmark_node *root) {
+  cmark_iter *iter = cmark_iter_new(root);
+  cmark_node *cur;
+  cmark_event_type ev_type;
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    if (ev_type == CMARK_EVENT_ENTER && contains_inlines(S_type(cur))) {
+      while (cur->first_child) {
+        cmark_node_free(cur->first_child);
       }
+      // The iterator has already stepped to the first child.
+      cmark_iter_reset(iter, cur, CMARK_EVENT_EXIT);
     }
   }
 
   cmark_iter_free(iter);
 }
 
+// Renders the closed blocks at the start of the document to the
+// parser's HTML sink and frees them.  A block with a link label that
+// matched no reference is held back, with everything after it, until
+// more references have been defined or 'flush' is set.
+static void S_stream_blocks(cmark_parser *parser, bool flush) {
+  cmark_reference_map *refmap = parser->refmap;
+  cmark_node *b;
+  char *html;
+
+  while ((b = parser->root->first_child) != NULL &&
+         !(b->flags & CMARK_NODE__OPEN)) {
+    if (!parser->stream_held || refmap->size != parser->stream_refs) {
+      if (parser->stream_held)
+        clear_inlines(b);
+      refmap->misses = 0;
+      process_inlines(parser, b, refmap);
+      parser->stream_held = refmap->misses > 0 &&
+                            !(parser->options & CMARK_OPT_REFERENCES_FIRST);
+      parser->stream_refs = refmap->size;
+    }
+    if (parser->stream_held && !flush)
+      return;
+    parser->stream_held = false;
+
+    if (parser->options & CMARK_OPT_NORMALIZE) {
+      cmark_consolidate_text_nodes(b);
+    }
+    html = cmark_render_html(b, parser->options);
+    if (html) {
+      // What the sink allocates is not the parser's.
+      cmark_mem_jump *jump = cmark_mem_suspend(parser->mem);
+      parser->html_sink(html, strlen(html), parser->html_sink_data);
+      cmark_mem_resume(parser->mem, jump);
+    } else { // past the output limit
+      parser->limiter->stopped = true;
+    }
+    parser->mem->free(html);
+    cmark_node_free(b);
+  }
+}
+
+// Unlinks the closed blocks at the start of the document and passes
+// them to the parser's block handler.
+static void S_hand_off_blocks(cmark_parser *parser) {
+  cmark_node *b;
+
+  while ((b = parser->root->first_child) != NULL &&
+         !(b->flags & CMARK_NODE__OPEN)) {
+    cmark_node_unlink(b);
+    parser->block_handler(b, parser->block_handler_data);
+  }
+}
+
 // Attempts to parse a list item marker (bullet or enumerated).
 // On success, returns length of the marker, and populates
 // data with the details.  On failure, returns 0.
@@ -410,7 +626,7 @@ static bufsize_t parse_list_marker(cmark_mem *mem, cmark_chunk *input,
       }
     }
 
-    data = (cmark_list *)mem->calloc(1, sizeof(*data));
+    data = (cmark_list *)cmark_mem_calloc(mem, 1, sizeof(*data));
     data->marker_offset = 0; // will be adjusted later
     data->list_type = CMARK_BULLET_LIST;
     data->bullet_char = c;
@@ -450,7 +666,7 @@ static bufsize_t parse_list_marker(cmark_mem *mem, cmark_chunk *input,
         }
       }
 
-      data = (cmark_list *)mem->calloc(1, sizeof(*data));
+      data = (cmark_list *)cmark_mem_calloc(mem, 1, sizeof(*data));
       data->marker_offset = 0; // will be adjusted later
       data->list_type = CMARK_ORDERED_LIST;
       data->bullet_char = 0;
@@ -482,7 +698,15 @@ static cmark_node *finalize_document(cmark_parser *parser) {
   }
 
   finalize(parser, parser->root);
-  process_inlines(parser->mem, parser->root, parser->refmap, parser->options);
+  parser->root->as.document.options = parser->options;
+  if (parser->options & CMARK_OPT_LAZY_INLINES) {
+    defer_inlines(parser->root);
+    // The document takes over the reference map.
+    parser->root->as.document.refmap = parser->refmap;
+    parser->refmap = cmark_reference_map_new(parser->mem);
+  } else {
+    process_inlines(parser, parser->root, parser->refmap);
+  }
 
   return parser->root;
 }
@@ -495,7 +719,7 @@ cmark_node *cmark_parse_file(FILE *f, int options) {
 
   while ((bytes = fread(buffer, 1, sizeof(buffer), f)) > 0) {
     bool eof = bytes < sizeof(buffer);
-    S_parser_feed(parser, buffer, bytes, eof);
+    S_parser_feed(parser, buffer, bytes, eof, false);
     if (eof) {
       break;
     }
@@ -506,25 +730,177 @@ cmark_node *cmark_parse_file(FILE *f, int options) {
   return document;
 }
 
+// Parses whatever can be read from 'fd', for files that cannot be mapped.
+static cmark_node *S_parse_fd_read(int fd, int options) {
+  unsigned char buffer[65536];
+  cmark_parser *parser = cmark_parser_new(options);
+  cmark_node *document;
+  long bytes;
+
+  while ((bytes = (long)read(fd, buffer, sizeof(buffer))) > 0) {
+    S_parser_feed(parser, buffer, (size_t)bytes, false, false);
+  }
+
+  document = cmark_parser_finish(parser);
+  cmark_parser_free(parser);
+
+  if (bytes < 0) {
+    cmark_node_free(document);
+    return NULL;
+  }
+  return document;
+}
+
+cmark_node *cmark_parse_fd(int fd, int options) {
+#ifndef _WIN32
+  struct stat st;
+  cmark_parser *parser;
+  cmark_node *document;
+  unsigned char *map;
+  size_t len;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+      (unsigned long long)st.st_size <= (unsigned long long)SIZE_MAX) {
+    len = (size_t)st.st_size;
+    // The mapping is read-only: lines processed in place are only
+    // read, so the file's pages are shared with the page cache and
+    // never copied.
+    map = (unsigned char *)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+      madvise(map, len, MADV_SEQUENTIAL);
+#endif
+      parser = cmark_parser_new(options);
+      S_parser_feed(parser, map, len, true, true);
+      document = cmark_parser_finish(parser);
+      cmark_parser_free(parser);
+      munmap(map, len);
+      return document;
+    }
+  }
+#endif
+
+  return S_parse_fd_read(fd, options);
+}
+
+cmark_node *cmark_parse_path(const char *path, int options) {
+  cmark_node *document;
+  int fd;
+
+#ifdef _WIN32
+  fd = open(path, O_RDONLY | O_BINARY);
+#else
+  fd = open(path, O_RDONLY);
+#endif
+  if (fd < 0) {
+    return NULL;
+  }
+
+  document = cmark_parse_fd(fd, options);
+  close(fd);
+  return document;
+}
+
 cmark_node *cmark_parse_document(const char *buffer, size_t len, int options) {
   cmark_parser *parser = cmark_parser_new(options);
   cmark_node *document;
 
-  S_parser_feed(parser, (const unsigned char *)buffer, len, true);
+  S_parser_feed(parser, (const unsigned char *)buffer, len, true, false);
 
   document = cmark_parser_finish(parser);
   cmark_parser_free(parser);
   return document;
 }
 
+cmark_node *cmark_parse_document_borrowed(const char *buffer, size_t len,
+                                          int options) {
+  cmark_parser *parser = cmark_parser_new(options);
+  cmark_node *document;
+
+  parser->borrow = true;
+  S_parser_feed(parser, (const unsigned char *)buffer, len, true, true);
+
+  document = cmark_parser_finish(parser);
+  cmark_parser_free(parser);
+  return document;
+}
+
+// Called when an allocation past the limit of the parser's memory
+// account has jumped out of it.  The parser's structures may be half
+// updated, so instead of being walked, the blocks the parser allocated
+// are freed.
+static void S_parser_fail(cmark_parser *parser) {
+  cmark_mem_release(parser->mem, &parser->mem_owner);
+  cmark_mem_set_phase(parser->mem, CMARK_MEM_PARSE);
+  cmark_strbuf_init(parser->mem, &parser->curline, 0);
+  cmark_strbuf_init(parser->mem, &parser->linebuf, 0);
+  parser->refmap = NULL;
+  parser->root = NULL;
+  parser->current = NULL;
+  parser->borrow_node = NULL;
+  parser->stats = NULL;
+  parser->limiter = NULL;
+  parser->failed = true;
+}
+
+// Called when the parse has reached the node or time limit.  The
+// parser is between lines or blocks, so the document can be freed as
+// usual.
+static void S_parser_stop(cmark_parser *parser) {
+  parser->exceeded = parser->limiter->exceeded;
+  cmark_node_free(parser->root);
+  parser->root = NULL;
+  parser->current = NULL;
+  parser->borrow_node = NULL;
+  parser->stats = NULL;
+  parser->limiter = NULL;
+  parser->failed = true;
+}
+
 void cmark_parser_feed(cmark_parser *parser, const char *buffer, size_t len) {
-  S_parser_feed(parser, (const unsigned char *)buffer, len, false);
+  cmark_mem_jump jump;
+
+  // Input after a failed or finished parse is ignored.
+  if (parser->failed || parser->root == NULL)
+    return;
+  cmark_mem_guard(parser->mem, &jump, &parser->mem_owner);
+  if (setjmp(jump.env)) {
+    cmark_mem_unguard(parser->mem, &jump);
+    S_parser_fail(parser);
+    return;
+  }
+  S_parser_feed(parser, (const unsigned char *)buffer, len, false, false);
+  cmark_mem_unguard(parser->mem, &jump);
+}
+
+// If 'in_place' is set, lines that end in a newline (other than the
+// last one) are processed without being copied.  'buffer' is never
+// written to.
+// Block parsing is timed from the outside, so the time of the phases
+// recorded inside it is taken out: the start time is moved forward by
+// the time they had taken so far, and the end time by the time they
+// have taken by then.
+static uint64_t S_nested_time(cmark_stats *stats) {
+  return stats->reference_ns + stats->inline_ns + stats->render_ns;
+}
+
+static uint64_t S_start_block_time(cmark_parser *parser) {
+  if (parser->stats == NULL)
+    return 0;
+  return cmark_stats_now() - S_nested_time(parser->stats);
+}
+
+static void S_end_block_time(cmark_parser *parser, uint64_t start) {
+  if (parser->stats)
+    parser->stats->block_ns +=
+        cmark_stats_now() - S_nested_time(parser->stats) - start;
 }
 
 static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
-                          size_t len, bool eof) {
+                          size_t len, bool eof, bool in_place) {
   const unsigned char *end = buffer + len;
   static const uint8_t repl[] = {239, 191, 189};
+  uint64_t start = S_start_block_time(parser);
 
   if (parser->last_buffer_ended_with_cr && *buffer == '\n') {
     // skip NL if last buffer ended with CR ; see #117
@@ -552,10 +928,18 @@ static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
     if (process) {
       if (parser->linebuf.size > 0) {
         cmark_strbuf_put(&parser->linebuf, buffer, chunk_len);
-        S_process_line(parser, parser->linebuf.ptr, parser->linebuf.size);
+        S_process_line(parser, parser->linebuf.ptr, parser->linebuf.size,
+                       false);
         cmark_strbuf_clear(&parser->linebuf);
+      } else if (in_place && eol + 1 < end && *eol == '\n' &&
+                 !(parser->options & CMARK_OPT_VALIDATE_UTF8)) {
+        // The line already ends with a newline and is followed by at
+        // least one more byte, so that looking one byte past the end
+        // of the line stays inside 'buffer'.  It is scanned in a copy
+        // (see S_scannable).
+        S_process_line(parser, buffer, chunk_len + 1, true);
       } else {
-        S_process_line(parser, buffer, chunk_len);
+        S_process_line(parser, buffer, chunk_len, false);
       }
     } else {
       if (eol < end && *eol == '\0') {
@@ -585,6 +969,7 @@ static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
       }
     }
   }
+  S_end_block_time(parser, start);
 }
 
 static void chop_trailing_hashtags(cmark_chunk *ch) {
@@ -607,26 +992,31 @@ static void chop_trailing_hashtags(cmark_chunk *ch) {
 // Find first nonspace character from current offset, setting
 // parser->first_nonspace, parser->first_nonspace_column,
 // parser->indent, and parser->blank. Does not advance parser->offset.
+// The result is kept while parser->offset has not moved past it, so
+// that the containers of a deeply indented line do not each scan the
+// same whitespace.
 static void S_find_first_nonspace(cmark_parser *parser, cmark_chunk *input) {
   char c;
   int chars_to_tab = TAB_STOP - (parser->column % TAB_STOP);
 
-  parser->first_nonspace = parser->offset;
-  parser->first_nonspace_column = parser->column;
-  while ((c = peek_at(input, parser->first_nonspace))) {
-    if (c == ' ') {
-      parser->first_nonspace += 1;
-      parser->first_nonspace_column += 1;
-      chars_to_tab = chars_to_tab - 1;
-      if (chars_to_tab == 0) {
+  if (parser->first_nonspace <= parser->offset) {
+    parser->first_nonspace = parser->offset;
+    parser->first_nonspace_column = parser->column;
+    while ((c = peek_at(input, parser->first_nonspace))) {
+      if (c == ' ') {
+        parser->first_nonspace += 1;
+        parser->first_nonspace_column += 1;
+        chars_to_tab = chars_to_tab - 1;
+        if (chars_to_tab == 0) {
+          chars_to_tab = TAB_STOP;
+        }
+      } else if (c == '\t') {
+        parser->first_nonspace += 1;
+        parser->first_nonspace_column += chars_to_tab;
         chars_to_tab = TAB_STOP;
+      } else {
+        break;
       }
-    } else if (c == '\t') {
-      parser->first_nonspace += 1;
-      parser->first_nonspace_column += chars_to_tab;
-      chars_to_tab = TAB_STOP;
-    } else {
-      break;
     }
   }
 
@@ -672,6 +1062,21 @@ static void S_advance_offset(cmark_parser *parser, cmark_chunk *input,
   }
 }
 
+// The scanners NUL-terminate what they scan while they run, which must
+// not happen to a line processed in place: that one is scanned in a
+// copy, made in 'curline' the first time it is needed.  The offsets
+// into both are the same.
+static cmark_chunk *S_scannable(cmark_parser *parser, cmark_chunk *input) {
+  if (!parser->line_in_place)
+    return input;
+  if (parser->curline.size == 0)
+    cmark_strbuf_put(&parser->curline, input->data, input->len);
+  parser->scan_line.data = parser->curline.ptr;
+  parser->scan_line.len = parser->curline.size;
+  parser->scan_line.alloc = 0;
+  return &parser->scan_line;
+}
+
 static bool S_last_child_is_open(cmark_node *container) {
   return container->last_child &&
          (container->last_child->flags & CMARK_NODE__OPEN);
@@ -736,7 +1141,8 @@ static bool parse_code_block_prefix(cmark_parser *parser, cmark_chunk *input,
 
     if (parser->indent <= 3 && (peek_at(input, parser->first_nonspace) ==
                                 container->as.code.fence_char)) {
-      matched = scan_close_code_fence(input, parser->first_nonspace);
+      matched = scan_close_code_fence(S_scannable(parser, input),
+                                      parser->first_nonspace);
     }
 
     if (matched >= container->as.code.fence_length) {
@@ -848,6 +1254,23 @@ done:
   return container;
 }
 
+// Returns whether 'levels' more containers can be opened under
+// 'container' without going past the depth limit.  Opening a container
+// closes a leaf or a list that cannot hold it, so they are counted
+// from the block that will.
+static bool S_can_nest(cmark_parser *parser, cmark_node *container,
+                       int levels) {
+  int depth = levels;
+
+  if (parser->limiter == NULL || parser->limiter->limits.max_depth <= 0)
+    return true;
+  if (!can_contain(S_type(container), CMARK_NODE_BLOCK_QUOTE))
+    container = container->parent;
+  for (; container->parent; container = container->parent)
+    depth++;
+  return depth <= parser->limiter->limits.max_depth;
+}
+
 static void open_new_blocks(cmark_parser *parser, cmark_node **container,
                             cmark_chunk *input, bool all_matched) {
   bool indented;
@@ -866,7 +1289,8 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
     S_find_first_nonspace(parser, input);
     indented = parser->indent >= CODE_INDENT;
 
-    if (!indented && peek_at(input, parser->first_nonspace) == '>') {
+    if (!indented && peek_at(input, parser->first_nonspace) == '>' &&
+        S_can_nest(parser, *container, 1)) {
 
       bufsize_t blockquote_startpos = parser->first_nonspace;
 
@@ -879,8 +1303,9 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
       *container = add_child(parser, *container, CMARK_NODE_BLOCK_QUOTE,
                              blockquote_startpos + 1);
 
-    } else if (!indented && (matched = scan_atx_heading_start(
-                                 input, parser->first_nonspace))) {
+    } else if (!indented &&
+               (matched = scan_atx_heading_start(S_scannable(parser, input),
+                                                 parser->first_nonspace))) {
       bufsize_t hashpos;
       int level = 0;
       bufsize_t heading_startpos = parser->first_nonspace;
@@ -901,8 +1326,9 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
       (*container)->as.heading.level = level;
       (*container)->as.heading.setext = false;
 
-    } else if (!indented && (matched = scan_open_code_fence(
-                                 input, parser->first_nonspace))) {
+    } else if (!indented &&
+               (matched = scan_open_code_fence(S_scannable(parser, input),
+                                               parser->first_nonspace))) {
       *container = add_child(parser, *container, CMARK_NODE_CODE_BLOCK,
                              parser->first_nonspace + 1);
       (*container)->as.code.fenced = true;
@@ -915,31 +1341,38 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
                        parser->first_nonspace + matched - parser->offset,
                        false);
 
-    } else if (!indented && ((matched = scan_html_block_start(
-                                  input, parser->first_nonspace)) ||
-                             (cont_type != CMARK_NODE_PARAGRAPH &&
-                              (matched = scan_html_block_start_7(
-                                   input, parser->first_nonspace))))) {
+    } else if (!indented &&
+               ((matched = scan_html_block_start(S_scannable(parser, input),
+                                                 parser->first_nonspace)) ||
+                (cont_type != CMARK_NODE_PARAGRAPH &&
+                 (matched = scan_html_block_start_7(
+                      S_scannable(parser, input), parser->first_nonspace))))) {
       *container = add_child(parser, *container, CMARK_NODE_HTML_BLOCK,
                              parser->first_nonspace + 1);
       (*container)->as.html_block_type = matched;
       // note, we don't adjust parser->offset because the tag is part of the
       // text
     } else if (!indented && cont_type == CMARK_NODE_PARAGRAPH &&
-               (lev =
-                    scan_setext_heading_line(input, parser->first_nonspace))) {
+               (lev = scan_setext_heading_line(S_scannable(parser, input),
+                                               parser->first_nonspace))) {
       (*container)->type = (uint16_t)CMARK_NODE_HEADING;
+      if (parser->stats) {
+        parser->stats->nodes[CMARK_NODE_PARAGRAPH]--;
+        parser->stats->nodes[CMARK_NODE_HEADING]++;
+      }
       (*container)->as.heading.level = lev;
       (*container)->as.heading.setext = true;
       S_advance_offset(parser, input, input->len - 1 - parser->offset, false);
     } else if (!indented &&
                !(cont_type == CMARK_NODE_PARAGRAPH && !all_matched) &&
-               (matched = scan_thematic_break(input, parser->first_nonspace))) {
+               (matched = scan_thematic_break(S_scannable(parser, input),
+                                              parser->first_nonspace))) {
       // it's only now that we know the line is not part of a setext heading:
       *container = add_child(parser, *container, CMARK_NODE_THEMATIC_BREAK,
                              parser->first_nonspace + 1);
       S_advance_offset(parser, input, input->len - 1 - parser->offset, false);
     } else if ((!indented || cont_type == CMARK_NODE_LIST) &&
+               S_can_nest(parser, *container, 2) &&
                (matched = parse_list_marker(
                     parser->mem, input, parser->first_nonspace,
                     (*container)->type == CMARK_NODE_PARAGRAPH, &data))) {
@@ -1079,27 +1512,32 @@ static void add_text_to_container(cmark_parser *parser, cmark_node *container,
       case 1:
         // </script>, </style>, </pre>
         matches_end_condition =
-            scan_html_block_end_1(input, parser->first_nonspace);
+            scan_html_block_end_1(S_scannable(parser, input),
+                                  parser->first_nonspace);
         break;
       case 2:
         // -->
         matches_end_condition =
-            scan_html_block_end_2(input, parser->first_nonspace);
+            scan_html_block_end_2(S_scannable(parser, input),
+                                  parser->first_nonspace);
         break;
       case 3:
         // ?>
         matches_end_condition =
-            scan_html_block_end_3(input, parser->first_nonspace);
+            scan_html_block_end_3(S_scannable(parser, input),
+                                  parser->first_nonspace);
         break;
       case 4:
         // >
         matches_end_condition =
-            scan_html_block_end_4(input, parser->first_nonspace);
+            scan_html_block_end_4(S_scannable(parser, input),
+                                  parser->first_nonspace);
         break;
       case 5:
         // ]]>
         matches_end_condition =
-            scan_html_block_end_5(input, parser->first_nonspace);
+            scan_html_block_end_5(S_scannable(parser, input),
+                                  parser->first_nonspace);
         break;
       default:
         matches_end_condition = 0;
@@ -1135,29 +1573,46 @@ static void add_text_to_container(cmark_parser *parser, cmark_node *container,
 
 /* See http://spec.commonmark.org/0.24/#phase-1-block-structure */
 static void S_process_line(cmark_parser *parser, const unsigned char *buffer,
-                           bufsize_t bytes) {
+                           bufsize_t bytes, bool in_place) {
   cmark_node *last_matched_container;
   bool all_matched = true;
   cmark_node *container;
   cmark_chunk input;
 
-  if (parser->options & CMARK_OPT_VALIDATE_UTF8)
-    cmark_utf8proc_check(&parser->curline, buffer, bytes);
-  else
-    cmark_strbuf_put(&parser->curline, buffer, bytes);
+  if (parser->limiter && !cmark_limiter_step(parser->limiter))
+    return;
+
+  if (in_place) {
+    // 'buffer' already ends with a newline; it is only read.
+    input.data = (unsigned char *)buffer;
+    input.len = bytes;
+  } else {
+    if (parser->options & CMARK_OPT_VALIDATE_UTF8)
+      cmark_utf8proc_check(&parser->curline, buffer, bytes);
+    else
+      cmark_strbuf_put(&parser->curline, buffer, bytes);
 
-  // ensure line ends with a newline:
-  if (bytes == 0 || !S_is_line_end_char(parser->curline.ptr[bytes - 1]))
-    cmark_strbuf_putc(&parser->curline, '\n');
+    // ensure line ends with a newline:
+    if (bytes == 0 || !S_is_line_end_char(parser->curline.ptr[bytes - 1]))
+      cmark_strbuf_putc(&parser->curline, '\n');
+
+    input.data = parser->curline.ptr;
+    input.len = parser->curline.size;
+  }
+  input.alloc = 0;
+  parser->line = input;
+  parser->line_in_place = in_place;
+  if (parser->stats)
+    parser->stats->lines++;
 
   parser->offset = 0;
   parser->column = 0;
+  parser->first_nonspace = 0;
+  parser->first_nonspace_column = 0;
+  parser->indent = 0;
   parser->blank = false;
   parser->partially_consumed_tab = false;
 
-  input.data = parser->curline.ptr;
-  input.len = parser->curline.size;
-
   parser->line_number++;
 
   last_matched_container = check_open_blocks(parser, &input, &all_matched);
@@ -1181,21 +1636,49 @@ finished:
     parser->last_line_length -= 1;
 
   cmark_strbuf_clear(&parser->curline);
+  parser->line.data = NULL;
+  parser->line.len = 0;
+
+  if (parser->html_sink)
+    S_stream_blocks(parser, false);
+  else if (parser->block_handler)
+    S_hand_off_blocks(parser);
 }
 
-cmark_node *cmark_parser_finish(cmark_parser *parser) {
+void cmark_parser_set_html_sink(cmark_parser *parser, cmark_sink sink,
+                                void *userdata) {
+  parser->html_sink = sink;
+  parser->html_sink_data = userdata;
+}
+
+static cmark_node *S_parser_finish(cmark_parser *parser) {
+  uint64_t start = S_start_block_time(parser);
+
   if (parser->linebuf.size) {
-    S_process_line(parser, parser->linebuf.ptr, parser->linebuf.size);
+    S_process_line(parser, parser->linebuf.ptr, parser->linebuf.size, false);
     cmark_strbuf_clear(&parser->linebuf);
   }
 
+  if (parser->html_sink || parser->block_handler) {
+    while (parser->current != parser->root) {
+      parser->current = finalize(parser, parser->current);
+    }
+    if (parser->html_sink)
+      S_stream_blocks(parser, true);
+    else
+      S_hand_off_blocks(parser);
+  }
+
   finalize_document(parser);
 
-  if (parser->options & CMARK_OPT_NORMALIZE) {
+  // With lazy inlines, blocks are normalized as their inlines are parsed.
+  if ((parser->options & CMARK_OPT_NORMALIZE) &&
+      !(parser->options & CMARK_OPT_LAZY_INLINES)) {
     cmark_consolidate_text_nodes(parser->root);
   }
 
   cmark_strbuf_free(&parser->curline);
+  S_end_block_time(parser, start);
 
 #if CMARK_DEBUG_NODES
   if (cmark_node_check(parser->root, stderr)) {
@@ -1204,3 +1687,40 @@ cmark_node *cmark_parser_finish(cmark_parser *parser) {
 #endif
   return parser->root;
 }
+
+cmark_node *cmark_parser_finish(cmark_parser *parser) {
+  cmark_mem_jump jump;
+  cmark_node *document;
+
+  if (parser->failed || parser->root == NULL)
+    return NULL;
+  if (parser->limiter && parser->limiter->stopped) {
+    S_parser_stop(parser);
+    return NULL;
+  }
+  cmark_mem_guard(parser->mem, &jump, &parser->mem_owner);
+  if (setjmp(jump.env)) {
+    cmark_mem_unguard(parser->mem, &jump);
+    S_parser_fail(parser);
+    return NULL;
+  }
+  document = S_parser_finish(parser);
+  cmark_mem_unguard(parser->mem, &jump);
+  if (parser->limiter) {
+    if (parser->limiter->stopped) {
+      S_parser_stop(parser);
+      return NULL;
+    }
+    // Lazy inlines and renderings are not timed.
+    parser->limiter->deadline = 0;
+    // The limiter is freed with the document, so the parser keeps its
+    // verdict only.
+    parser->exceeded = parser->limiter->exceeded;
+    parser->limiter = NULL;
+  }
+  // The document is the caller's now.
+  parser->root = NULL;
+  parser->current = NULL;
+  cmark_mem_disown(&parser->mem_owner);
+  return document;
+}
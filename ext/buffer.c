@@ -10,6 +10,7 @@
 #include "config.h"
 #include "cmark_ctype.h"
 #include "buffer.h"
+#include "accounting.h"
 #include "memory.h"
 
 /* Used as default value for cmark_strbuf->ptr so that people can always
@@ -51,8 +52,16 @@ void cmark_strbuf_grow(cmark_strbuf *buf, bufsize_t target_size) {
   new_size += 1;
   new_size = (new_size + 7) & ~7;
 
-  buf->ptr = (unsigned char *)buf->mem->realloc(buf->asize ? buf->ptr : NULL,
-                                                new_size);
+  if (buf->asize == 0 && buf->size > 0) {
+    // Borrowed contents are copied on the first write.
+    unsigned char *new_ptr =
+        (unsigned char *)cmark_mem_realloc(buf->mem, NULL, new_size);
+    memcpy(new_ptr, buf->ptr, buf->size);
+    buf->ptr = new_ptr;
+  } else {
+    buf->ptr = (unsigned char *)cmark_mem_realloc(
+        buf->mem, buf->asize ? buf->ptr : NULL, new_size);
+  }
   buf->asize = new_size;
 }
 
@@ -62,7 +71,7 @@ void cmark_strbuf_free(cmark_strbuf *buf) {
   if (!buf)
     return;
 
-  if (buf->ptr != cmark_strbuf__initbuf)
+  if (buf->asize > 0)
     buf->mem->free(buf->ptr);
 
   cmark_strbuf_init(buf->mem, buf, 0);
@@ -75,6 +84,15 @@ void cmark_strbuf_clear(cmark_strbuf *buf) {
     buf->ptr[0] = '\0';
 }
 
+void cmark_strbuf_borrow(cmark_strbuf *buf, const unsigned char *data,
+                         bufsize_t len) {
+  cmark_strbuf_free(buf);
+  if (len > 0) {
+    buf->ptr = (unsigned char *)data;
+    buf->size = len;
+  }
+}
+
 void cmark_strbuf_set(cmark_strbuf *buf, const unsigned char *data,
                       bufsize_t len) {
   if (len <= 0 || data == NULL) {
@@ -143,11 +161,18 @@ void cmark_strbuf_swap(cmark_strbuf *buf_a, cmark_strbuf *buf_b) {
 }
 
 unsigned char *cmark_strbuf_detach(cmark_strbuf *buf) {
-  unsigned char *data = buf->ptr;
+  unsigned char *data;
+
+  if (buf->asize == 0 && buf->size > 0) {
+    /* copy borrowed contents */
+    cmark_strbuf_grow(buf, buf->size);
+    buf->ptr[buf->size] = '\0';
+  }
 
+  data = buf->ptr;
   if (buf->asize == 0) {
     /* return an empty string */
-    return (unsigned char *)buf->mem->calloc(1, 1);
+    return (unsigned char *)cmark_mem_calloc(buf->mem, 1, 1);
   }
 
   cmark_strbuf_init(buf->mem, buf, 0);
@@ -66,6 +66,15 @@ void cmark_strbuf_put(cmark_strbuf *buf, const unsigned char *data,
 void cmark_strbuf_puts(cmark_strbuf *buf, const char *string);
 void cmark_strbuf_clear(cmark_strbuf *buf);
 
+/**
+ * Make `buf` refer to `len` bytes at `data` without copying them.  The
+ * bytes are not NUL-terminated and are not owned by `buf`: they are
+ * copied when something is appended, and must not be modified in place
+ * (by truncating, dropping or trimming) before that.
+ */
+void cmark_strbuf_borrow(cmark_strbuf *buf, const unsigned char *data,
+                         bufsize_t len);
+
 bufsize_t cmark_strbuf_strchr(const cmark_strbuf *buf, int c, bufsize_t pos);
 bufsize_t cmark_strbuf_strrchr(const cmark_strbuf *buf, int c, bufsize_t pos);
 void cmark_strbuf_drop(cmark_strbuf *buf, bufsize_t n);
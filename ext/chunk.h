@@ -6,6 +6,7 @@
 #include <assert.h>
 #include "cmark.h"
 #include "buffer.h"
+#include "accounting.h"
 #include "memory.h"
 #include "cmark_ctype.h"
 
@@ -64,7 +65,7 @@ static CMARK_INLINE const char *cmark_chunk_to_cstr(cmark_mem *mem,
   if (c->alloc) {
     return (char *)c->data;
   }
-  str = (unsigned char *)mem->calloc(c->len + 1, 1);
+  str = (unsigned char *)cmark_mem_calloc(mem, c->len + 1, 1);
   if (c->len > 0) {
     memcpy(str, c->data, c->len);
   }
@@ -84,7 +85,7 @@ static CMARK_INLINE void cmark_chunk_set_cstr(cmark_mem *mem, cmark_chunk *c,
     c->alloc = 0;
   } else {
     c->len = (bufsize_t)strlen(str);
-    c->data = (unsigned char *)mem->calloc(c->len + 1, 1);
+    c->data = (unsigned char *)cmark_mem_calloc(mem, c->len + 1, 1);
     c->alloc = 1;
     memcpy(c->data, str, c->len + 1);
   }
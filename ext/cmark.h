@@ -2,6 +2,7 @@
 #define CMARK_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <cmark_export.h>
 #include <cmark_version.h>
 
@@ -87,6 +88,11 @@ typedef struct cmark_node cmark_node;
 typedef struct cmark_parser cmark_parser;
 typedef struct cmark_iter cmark_iter;
 
+/** Receives rendered output in pieces: 'len' bytes at 'data', which are
+ * only valid for the duration of the call.
+ */
+typedef void (*cmark_sink)(const char *data, size_t len, void *userdata);
+
 /**
  * ## Custom memory allocator support
  */
@@ -100,6 +106,153 @@ typedef struct cmark_mem {
   void (*free)(void *);
 } cmark_mem;
 
+/**
+ * ## Memory Accounting
+ */
+
+/** What an allocation is made for: parsing blocks, parsing inlines or
+ * rendering.
+ */
+typedef enum {
+  CMARK_MEM_PARSE,
+  CMARK_MEM_INLINES,
+  CMARK_MEM_RENDER
+} cmark_mem_phase;
+
+#define CMARK_MEM_PHASES 3
+
+/** What has been allocated through a memory account.  'live' is the
+ * number of bytes allocated and not freed yet, and 'peak' the most
+ * there have been.  'allocations', 'reallocations' and 'bytes' (the
+ * number of bytes allocated, including what reallocations added) are
+ * indexed by `cmark_mem_phase`.  'exceeded' is set once an allocation
+ * has gone past the limit of the account.
+ */
+typedef struct cmark_mem_usage {
+  size_t live;
+  size_t peak;
+  size_t frees;
+  size_t allocations[CMARK_MEM_PHASES];
+  size_t reallocations[CMARK_MEM_PHASES];
+  size_t bytes[CMARK_MEM_PHASES];
+  int exceeded;
+} cmark_mem_usage;
+
+/** An allocator that wraps another one and accounts for what is
+ * allocated through it.
+ */
+typedef struct cmark_mem_account cmark_mem_account;
+
+/** Creates a memory account over the system allocator.  If 'limit' is
+ * not 0, a parser using the account's allocator (see
+ * `cmark_mem_account_get_mem`) fails when more than 'limit' bytes would
+ * be live, or when the system allocator runs out of memory: everything
+ * the parser allocated is freed, `cmark_parser_feed` ignores further
+ * input and `cmark_parser_finish` returns NULL (or, if it happens while
+ * the parser is created, `cmark_parser_new_with_mem` returns NULL).
+ * Allocations made outside a parser, for example when rendering or
+ * parsing inlines with `CMARK_OPT_LAZY_INLINES`, are counted but not
+ * refused.  Several parsers and documents can share an account: a
+ * parser that fails only frees what it allocated itself.
+ */
+CMARK_EXPORT
+cmark_mem_account *cmark_mem_account_new(size_t limit);
+
+/** Same as `cmark_mem_account_new`, but wrapping the allocator 'mem'.
+ * If 'mem' returns NULL, a parser fails as if the limit was reached.
+ */
+CMARK_EXPORT
+cmark_mem_account *cmark_mem_account_new_with_mem(size_t limit,
+                                                  cmark_mem *mem);
+
+/** Frees a memory account.  If blocks allocated through it are still
+ * live, it is freed when the last of them is.
+ */
+CMARK_EXPORT
+void cmark_mem_account_free(cmark_mem_account *account);
+
+/** Returns the allocator of 'account', to be passed to
+ * `cmark_parser_new_with_mem` or `cmark_node_new_with_mem`.  Only the
+ * allocations made by the library are counted; calling its functions
+ * directly allocates outside the account.
+ */
+CMARK_EXPORT
+cmark_mem *cmark_mem_account_get_mem(cmark_mem_account *account);
+
+/** Returns what has been allocated through 'account' so far.
+ */
+CMARK_EXPORT
+const cmark_mem_usage *cmark_mem_account_get_usage(cmark_mem_account *account);
+
+/** Returns the allocator that 'node' was allocated with.  Buffers
+ * returned for a node, such as the result of `cmark_node_serialize`,
+ * are freed with its 'free' function.
+ */
+CMARK_EXPORT
+cmark_mem *cmark_node_get_mem(cmark_node *node);
+
+/**
+ * ## Statistics
+ */
+
+/** What parsing and rendering a document cost, recorded when it is
+ * parsed with `CMARK_OPT_STATS`.  Times are in nanoseconds of a
+ * monotonic clock.  'block_ns' is the time spent in
+ * `cmark_parser_feed` and `cmark_parser_finish` other than parsing
+ * reference definitions ('reference_ns') and inlines ('inline_ns', of
+ * which 'emphasis_ns' is spent matching emphasis delimiters).  Inlines
+ * parsed later with `CMARK_OPT_LAZY_INLINES` and every rendering of the
+ * document are recorded too.  'nodes' counts the nodes parsed by type,
+ * 'delimiters_processed' the delimiters looked at as closers,
+ * 'renders' the renderings and 'output_bytes' their output.
+ */
+typedef struct cmark_stats {
+  uint64_t block_ns;
+  uint64_t reference_ns;
+  uint64_t inline_ns;
+  uint64_t emphasis_ns;
+  uint64_t render_ns;
+  size_t lines;
+  size_t nodes[CMARK_NODE_LAST_INLINE + 1];
+  size_t delimiters_pushed;
+  size_t delimiters_processed;
+  size_t references_defined;
+  size_t references_looked_up;
+  size_t renders;
+  size_t output_bytes;
+} cmark_stats;
+
+/**
+ * ## Resource Limits
+ */
+
+/** Bounds on what parsing and rendering a document may cost, for
+ * input that cannot be trusted.  A field that is 0 sets no bound.
+ * Block quotes, lists and list items that would be nested more than
+ * 'max_depth' deep are not opened, and their markers are read as
+ * text.  An inline subject (the content of a paragraph or heading) has
+ * at most 'max_delimiters' emphasis delimiters and brackets; the rest
+ * stay literal text.  A parse that creates more than 'max_nodes' nodes
+ * or runs for more than 'max_time' seconds fails, and a rendering that
+ * produces more than 'max_output' bytes fails too.
+ */
+typedef struct cmark_limits {
+  int max_depth;
+  size_t max_nodes;
+  size_t max_delimiters;
+  size_t max_output;
+  double max_time;
+} cmark_limits;
+
+/** The limit that made a parse or a rendering fail.
+ */
+typedef enum {
+  CMARK_LIMIT_NONE,
+  CMARK_LIMIT_NODES,
+  CMARK_LIMIT_TIME,
+  CMARK_LIMIT_OUTPUT
+} cmark_limit;
+
 /**
  * ## Creating and Destroying Nodes
  */
@@ -207,6 +360,12 @@ typedef enum {
 CMARK_EXPORT
 cmark_iter *cmark_iter_new(cmark_node *root);
 
+/** Same as `cmark_iter_new`, but allocating the iterator with 'mem'
+ * rather than the allocator of 'root'.
+ */
+CMARK_EXPORT
+cmark_iter *cmark_iter_new_with_mem(cmark_node *root, cmark_mem *mem);
+
 /** Frees the memory allocated for an iterator.
  */
 CMARK_EXPORT
@@ -254,6 +413,14 @@ CMARK_EXPORT void *cmark_node_get_user_data(cmark_node *node);
  */
 CMARK_EXPORT int cmark_node_set_user_data(cmark_node *node, void *user_data);
 
+/** Marks 'node' as having a handle in a language binding, and returns
+ * 1 if it was marked already, 0 otherwise.  Nodes are created
+ * unmarked, so a binding that keeps its handles in a table keyed by
+ * node address can tell a node apart from a freed one that had the
+ * same address.
+ */
+CMARK_EXPORT int cmark_node_mark_handle(cmark_node *node);
+
 /** Returns the type of 'node', or `CMARK_NODE_NONE` on error.
  */
 CMARK_EXPORT cmark_node_type cmark_node_get_type(cmark_node *node);
@@ -430,6 +597,70 @@ CMARK_EXPORT int cmark_node_append_child(cmark_node *node, cmark_node *child);
  */
 CMARK_EXPORT void cmark_consolidate_text_nodes(cmark_node *root);
 
+/**
+ * ## Hashing
+ */
+
+/** Returns a 64-bit structural hash of the subtree rooted at 'node',
+ * covering node types, literals, URLs, titles, code block info
+ * strings, custom block contents, list attributes and heading levels.
+ * Source positions and user data are not included.  Subtrees with
+ * equal content have equal hashes, so the hash can be used to detect
+ * duplicate content and to memoize work done per subtree.  Hashes are
+ * cached on the nodes and invalidated when a node or one of its
+ * descendants is changed through this API, so hashing an unchanged
+ * tree again is cheap.  Hashes are not stable across platforms of
+ * different endianness.
+ */
+CMARK_EXPORT uint64_t cmark_node_hash(cmark_node *node);
+
+/**
+ * ## Serialization
+ */
+
+/** Serializes the tree rooted at 'root' into a compact, versioned
+ * binary format and stores its length in 'len'.  It is the caller's
+ * responsibility to free the returned buffer.
+ */
+CMARK_EXPORT char *cmark_node_serialize(cmark_node *root, size_t *len);
+
+/** Reconstructs a tree from a buffer of length 'len' produced by
+ * `cmark_node_serialize`, copying all strings.  Returns NULL if the
+ * buffer is not a valid serialized tree.
+ */
+CMARK_EXPORT cmark_node *cmark_node_deserialize(const char *buffer,
+                                                size_t len);
+
+/** Same as `cmark_node_deserialize`, but literals, URLs and other
+ * strings point into 'buffer' instead of being copied, so that a tree
+ * can be loaded cheaply from a memory-mapped file.  'buffer' must
+ * remain valid and unmodified until the tree is freed.  It is never
+ * written to, so it may be a read-only mapping.
+ */
+CMARK_EXPORT cmark_node *cmark_node_deserialize_borrowed(const char *buffer,
+                                                         size_t len);
+
+/**
+ * ## Selecting nodes
+ */
+
+/** The bit of node type 'type' in the type masks of `cmark_node_select`.
+ */
+#define CMARK_NODE_MASK(type) (1u << (type))
+
+/** Returns the nodes in the tree rooted at 'root' (including 'root')
+ * whose type is in 'type_mask', in document order, and stores their
+ * number in 'count'.  At most 'max' nodes are returned, or all of them
+ * if 'max' is 0.  Returns NULL if no node matches.  It is the caller's
+ * responsibility to free the returned array.  For a document parsed
+ * with `CMARK_OPT_NODE_INDEX`, the first call builds an index of its
+ * nodes by type, and later calls on the document only look at the nodes
+ * they return, until the tree is changed.
+ */
+CMARK_EXPORT cmark_node **cmark_node_select(cmark_node *root,
+                                            unsigned int type_mask,
+                                            size_t max, size_t *count);
+
 /**
  * ## Parsing
  *
@@ -477,6 +708,59 @@ void cmark_parser_feed(cmark_parser *parser, const char *buffer, size_t len);
 CMARK_EXPORT
 cmark_node *cmark_parser_finish(cmark_parser *parser);
 
+/** Switches 'parser' to streaming HTML output.  Each top-level block is
+ * rendered with the parser's options and passed to 'sink' as soon as it
+ * has been closed, then freed, so memory use is bounded by the largest
+ * open block rather than the size of the document.  A block containing
+ * a link label that does not match any reference definition seen so
+ * far is held back, together with the blocks after it, until a new
+ * definition appears or parsing finishes; pass
+ * `CMARK_OPT_REFERENCES_FIRST` to never hold blocks back.
+ * `cmark_parser_finish` emits whatever remains and returns an empty
+ * document.  Must be called before anything is fed to the parser.
+ */
+CMARK_EXPORT
+void cmark_parser_set_html_sink(cmark_parser *parser, cmark_sink sink,
+                                void *userdata);
+
+/** Returns the statistics of the document being parsed, or NULL if the
+ * parser was not created with `CMARK_OPT_STATS`.
+ */
+CMARK_EXPORT
+const cmark_stats *cmark_parser_get_stats(cmark_parser *parser);
+
+/** Returns the statistics of the document that 'node' belongs to, or
+ * NULL if it was not parsed with `CMARK_OPT_STATS`.  They are freed
+ * with the document.
+ */
+CMARK_EXPORT
+const cmark_stats *cmark_node_get_stats(cmark_node *node);
+
+/** Applies 'limits' to the document being parsed, and to inlines
+ * parsed and renderings made from it later; the time limit runs from
+ * this call to the end of `cmark_parser_finish`.  When the node or
+ * time limit is reached, `cmark_parser_feed` ignores further input and
+ * `cmark_parser_finish` frees the document and returns NULL.  Inlines
+ * parsed later with `CMARK_OPT_LAZY_INLINES` stop at the node limit
+ * instead, leaving the rest of their block as text.  A rendering that
+ * goes past the output limit returns NULL (or, rendering to a sink,
+ * stops).  Must be called before anything is fed to the parser.
+ */
+CMARK_EXPORT
+void cmark_parser_set_limits(cmark_parser *parser, const cmark_limits *limits);
+
+/** Returns the limit that made the parse fail, or `CMARK_LIMIT_NONE`.
+ */
+CMARK_EXPORT
+cmark_limit cmark_parser_get_exceeded_limit(cmark_parser *parser);
+
+/** Returns the limit that the document of 'node' has reached since it
+ * was parsed, by parsing lazy inlines or rendering, or
+ * `CMARK_LIMIT_NONE`.
+ */
+CMARK_EXPORT
+cmark_limit cmark_node_get_exceeded_limit(cmark_node *node);
+
 /** Parse a CommonMark document in 'buffer' of length 'len'.
  * Returns a pointer to a tree of nodes.  The memory allocated for
  * the node tree should be released using 'cmark_node_free'
@@ -485,6 +769,18 @@ cmark_node *cmark_parser_finish(cmark_parser *parser);
 CMARK_EXPORT
 cmark_node *cmark_parse_document(const char *buffer, size_t len, int options);
 
+/** Same as `cmark_parse_document`, but block content that is found
+ * unchanged in 'buffer' (typically paragraphs, headings, HTML blocks
+ * and fenced code whose lines are not indented or nested in other
+ * containers) points into 'buffer' instead of being copied, and so does
+ * the text of its inlines.  'buffer' must remain valid and unmodified
+ * until the tree is freed.  'buffer' is only read, both while parsing
+ * and when inlines are parsed later (see `CMARK_OPT_LAZY_INLINES`).
+ */
+CMARK_EXPORT
+cmark_node *cmark_parse_document_borrowed(const char *buffer, size_t len,
+                                          int options);
+
 /** Parse a CommonMark document in file 'f', returning a pointer to
  * a tree of nodes.  The memory allocated for the node tree should be
  * released using 'cmark_node_free' when it is no longer needed.
@@ -492,6 +788,25 @@ cmark_node *cmark_parse_document(const char *buffer, size_t len, int options);
 CMARK_EXPORT
 cmark_node *cmark_parse_file(FILE *f, int options);
 
+/** Parse a CommonMark document read from the file descriptor 'fd',
+ * returning a pointer to a tree of nodes, or NULL if reading fails.
+ * Regular files are memory-mapped and parsed as a whole, regardless of
+ * the current file offset, with most lines processed in place rather
+ * than copied; the file must not be truncated while it is being parsed.
+ * Other descriptors, such as pipes, are read until end of file.  The
+ * descriptor is not closed.  The memory allocated for the node tree
+ * should be released using 'cmark_node_free' when it is no longer
+ * needed.
+ */
+CMARK_EXPORT
+cmark_node *cmark_parse_fd(int fd, int options);
+
+/** Same as `cmark_parse_fd`, but opens the file at 'path'.  Returns
+ * NULL if the file cannot be opened or read.
+ */
+CMARK_EXPORT
+cmark_node *cmark_parse_path(const char *path, int options);
+
 /**
  * ## Rendering
  */
@@ -502,6 +817,57 @@ cmark_node *cmark_parse_file(FILE *f, int options);
 CMARK_EXPORT
 char *cmark_render_xml(cmark_node *root, int options);
 
+/** Render a 'node' tree as JSON.  Each node is an object with its
+ * "type", its "sourcepos" as an array of four numbers if
+ * `CMARK_OPT_SOURCEPOS` is given and the position is known, the fields of its type ("literal",
+ * "info", "level", "list_type", "start", "delim", "tight",
+ * "destination", "title", "on_enter" and "on_exit", as in the XML
+ * output) and, unless it cannot have children, an array of "children".
+ * The schema is described in detail in json.c.  It is the caller's
+ * responsibility to free the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_render_json(cmark_node *root, int options);
+
+/** Same as `cmark_render_json`, but passes the output to 'sink' in
+ * pieces as it is rendered, instead of returning it as one buffer.
+ * Returns 0 if the rendering stopped at the output limit of the
+ * document (see `cmark_limits`), and 1 otherwise.
+ */
+CMARK_EXPORT
+int cmark_render_json_to_sink(cmark_node *root, int options, cmark_sink sink,
+                              void *userdata);
+
+/** Receives the position 'offset' in the output of a renderer at which
+ * the text of a block starting on source line 'line' begins.
+ */
+typedef void (*cmark_anchor_fn)(size_t offset, int line, void *userdata);
+
+/** Render the text content of a 'node' tree, for example for search
+ * indexing.  Text and code are kept, including image descriptions and
+ * the content of code blocks; link destinations, raw HTML and the
+ * strings of custom nodes are skipped.  Soft breaks become spaces (or
+ * newlines with `CMARK_OPT_HARDBREAKS`) and hard breaks newlines.  The
+ * text of consecutive paragraphs, headings and code blocks is joined
+ * with 'separator', or with a blank line if it is NULL.  It is the
+ * caller's responsibility to free the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_render_plaintext(cmark_node *root, int options,
+                             const char *separator);
+
+/** Same as `cmark_render_plaintext`, but passes the output to 'sink' in
+ * pieces as it is rendered.  If 'anchor' is not NULL, it is called
+ * with the byte offset in the output and the source line of each
+ * block that contributes text, in order, before that text reaches the
+ * sink.  Returns 0 if the rendering stopped at the output limit of the
+ * document, and 1 otherwise.
+ */
+CMARK_EXPORT
+int cmark_render_plaintext_to_sink(cmark_node *root, int options,
+                                   const char *separator, cmark_sink sink,
+                                   cmark_anchor_fn anchor, void *userdata);
+
 /** Render a 'node' tree as an HTML fragment.  It is up to the user
  * to add an appropriate header and footer. It is the caller's
  * responsibility to free the returned buffer.
@@ -527,6 +893,231 @@ char *cmark_render_commonmark(cmark_node *root, int options, int width);
 CMARK_EXPORT
 char *cmark_render_latex(cmark_node *root, int options, int width);
 
+/**
+ * ## HTML Render Cache
+ */
+
+typedef struct cmark_html_cache cmark_html_cache;
+
+/** Eviction policies for a 'cmark_html_cache'.  `CMARK_HTML_CACHE_LRU`
+ * discards the least recently used entry, `CMARK_HTML_CACHE_FIFO`
+ * discards the oldest one regardless of use.
+ */
+typedef enum {
+  CMARK_HTML_CACHE_LRU,
+  CMARK_HTML_CACHE_FIFO
+} cmark_html_cache_policy;
+
+/** Creates a cache holding the rendered HTML of at most 'capacity'
+ * top-level blocks, evicting entries in LRU order.
+ */
+CMARK_EXPORT
+cmark_html_cache *cmark_html_cache_new(int capacity);
+
+/** Same as `cmark_html_cache_new`, but explicitly listing the memory
+ * allocator used for the cache and its entries.
+ */
+CMARK_EXPORT
+cmark_html_cache *cmark_html_cache_new_with_mem(int capacity, cmark_mem *mem);
+
+/** Frees the memory allocated for a cache and all of its entries.
+ */
+CMARK_EXPORT
+void cmark_html_cache_free(cmark_html_cache *cache);
+
+/** Discards all entries and resets the hit, miss and eviction counters.
+ */
+CMARK_EXPORT
+void cmark_html_cache_clear(cmark_html_cache *cache);
+
+/** Returns the maximum number of entries held by 'cache'.
+ */
+CMARK_EXPORT
+int cmark_html_cache_get_capacity(cmark_html_cache *cache);
+
+/** Sets the maximum number of entries held by 'cache', evicting
+ * entries if it currently holds more.  A capacity of 0 disables
+ * caching.  Returns 1 on success, 0 on failure.
+ */
+CMARK_EXPORT
+int cmark_html_cache_set_capacity(cmark_html_cache *cache, int capacity);
+
+/** Returns the eviction policy of 'cache'.
+ */
+CMARK_EXPORT
+cmark_html_cache_policy cmark_html_cache_get_policy(cmark_html_cache *cache);
+
+/** Sets the eviction policy of 'cache'.  Returns 1 on success,
+ * 0 on failure.
+ */
+CMARK_EXPORT
+int cmark_html_cache_set_policy(cmark_html_cache *cache,
+                                cmark_html_cache_policy policy);
+
+/** Returns the number of entries currently held by 'cache'.
+ */
+CMARK_EXPORT
+int cmark_html_cache_get_size(cmark_html_cache *cache);
+
+/** Returns the number of blocks served from 'cache'.
+ */
+CMARK_EXPORT
+size_t cmark_html_cache_get_hits(cmark_html_cache *cache);
+
+/** Returns the number of blocks that had to be rendered.
+ */
+CMARK_EXPORT
+size_t cmark_html_cache_get_misses(cmark_html_cache *cache);
+
+/** Returns the number of entries evicted from 'cache'.
+ */
+CMARK_EXPORT
+size_t cmark_html_cache_get_evictions(cmark_html_cache *cache);
+
+/** Same as `cmark_render_html`, but looks up each top-level block of
+ * the document 'root' in 'cache' before rendering it.  Blocks are
+ * keyed by a hash of their content and of the options affecting
+ * their HTML, so unchanged blocks of an edited document are copied
+ * from the cache.  Each entry keeps a copy of its block's content,
+ * which is compared with the block on a hit, so blocks whose 64-bit
+ * keys collide, by chance or by crafted input, never get each other's
+ * HTML.  Such input can still make many blocks share a key, and a
+ * lookup then compares the block with each of their entries in turn.
+ * If 'root' is not a document, or 'cache' is NULL, this is equivalent
+ * to `cmark_render_html`.  It is the caller's responsibility to free
+ * the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_render_html_cached(cmark_node *root, int options,
+                               cmark_html_cache *cache);
+
+/**
+ * ## Render hooks
+ *
+ * Render hooks override the HTML of nodes of particular types, without
+ * walking the tree or post-processing the output.  Nodes of types with
+ * no hook are rendered as by `cmark_render_html`.
+ */
+
+typedef struct cmark_html_hooks cmark_html_hooks;
+typedef struct cmark_html_output cmark_html_output;
+
+/** What a hook did with a node.  With `CMARK_HTML_HOOK_DEFAULT` the
+ * node is rendered as usual, after anything the hook has output.  With
+ * `CMARK_HTML_HOOK_REPLACE` the hook's output replaces the node's own
+ * for this event.  `CMARK_HTML_HOOK_SKIP` is the same, but on entering
+ * a node its children are skipped too, and there is no exit event.
+ */
+typedef enum {
+  CMARK_HTML_HOOK_DEFAULT,
+  CMARK_HTML_HOOK_REPLACE,
+  CMARK_HTML_HOOK_SKIP
+} cmark_html_hook_result;
+
+/** Called when 'node' is entered or exited ('ev_type'), with the
+ * rendering options and the 'userdata' it was registered with.  Output
+ * is added with `cmark_html_output_put` and `cmark_html_output_escape`.
+ * Hooks are not called for the description of an image, which is
+ * rendered as plain text.
+ */
+typedef cmark_html_hook_result (*cmark_html_hook)(cmark_node *node,
+                                                  cmark_event_type ev_type,
+                                                  int options,
+                                                  cmark_html_output *out,
+                                                  void *userdata);
+
+/** Creates an empty table of render hooks.
+ */
+CMARK_EXPORT
+cmark_html_hooks *cmark_html_hooks_new(void);
+
+/** Frees a table of render hooks.
+ */
+CMARK_EXPORT
+void cmark_html_hooks_free(cmark_html_hooks *hooks);
+
+/** Registers 'hook' for nodes of type 'type', replacing any previous
+ * hook; a NULL 'hook' removes it.  Returns 1 on success, 0 if 'type'
+ * is not a node type.
+ */
+CMARK_EXPORT
+int cmark_html_hooks_set(cmark_html_hooks *hooks, cmark_node_type type,
+                         cmark_html_hook hook, void *userdata);
+
+/** Adds 'len' bytes of HTML at 'data' to the output.
+ */
+CMARK_EXPORT
+void cmark_html_output_put(cmark_html_output *out, const char *data,
+                           size_t len);
+
+/** Adds 'len' bytes of text at 'data' to the output, escaped for HTML.
+ */
+CMARK_EXPORT
+void cmark_html_output_escape(cmark_html_output *out, const char *data,
+                              size_t len);
+
+/** Same as `cmark_render_html`, but calls the hooks in 'hooks' for nodes
+ * of the types they are registered for.  It is the caller's
+ * responsibility to free the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_render_html_with_hooks(cmark_node *root, int options,
+                                   cmark_html_hooks *hooks);
+
+/**
+ * ## Outline
+ */
+
+typedef struct cmark_outline cmark_outline;
+
+/** Extracts the headings of the CommonMark document in 'buffer' of
+ * length 'len', without building the document tree: blocks other than
+ * headings are freed as soon as they are closed, and inlines are only
+ * parsed inside headings.  Each entry has the heading level, its plain
+ * text, a unique anchor name (slug) derived from the text, and the
+ * line the heading starts on.  The outline should be released using
+ * 'cmark_outline_free' when it is no longer needed.
+ */
+CMARK_EXPORT
+cmark_outline *cmark_extract_outline(const char *buffer, size_t len,
+                                     int options);
+
+/** Frees the memory allocated for an outline.
+ */
+CMARK_EXPORT
+void cmark_outline_free(cmark_outline *outline);
+
+/** Returns the number of headings in 'outline'.
+ */
+CMARK_EXPORT
+int cmark_outline_get_length(cmark_outline *outline);
+
+/** Returns the level of heading 'i' (counting from 0), or 0 if there
+ * is no such heading.
+ */
+CMARK_EXPORT
+int cmark_outline_get_level(cmark_outline *outline, int i);
+
+/** Returns the plain text of heading 'i', or NULL if there is no such
+ * heading.
+ */
+CMARK_EXPORT
+const char *cmark_outline_get_text(cmark_outline *outline, int i);
+
+/** Returns the anchor name of heading 'i', or NULL if there is no such
+ * heading.  Anchor names are formed as on GitHub: lowercased, with
+ * spaces replaced by hyphens, punctuation removed, and "-1", "-2"...
+ * appended to names already taken.
+ */
+CMARK_EXPORT
+const char *cmark_outline_get_slug(cmark_outline *outline, int i);
+
+/** Returns the line on which heading 'i' starts, or 0 if there is no
+ * such heading.
+ */
+CMARK_EXPORT
+int cmark_outline_get_start_line(cmark_outline *outline, int i);
+
 /**
  * ## Options
  */
@@ -576,6 +1167,31 @@ char *cmark_render_latex(cmark_node *root, int options, int width);
  */
 #define CMARK_OPT_SMART (1 << 10)
 
+/** When streaming HTML, only resolve links against reference
+ * definitions that precede them in the document.
+ */
+#define CMARK_OPT_REFERENCES_FIRST (1 << 11)
+
+/** Parse the inline content of paragraphs and headings only when it is
+ * first needed: when the block's children are requested, iterated over
+ * or rendered.  Consumers that only look at the block structure skip
+ * most of the work of inline parsing.  The document keeps its link
+ * reference definitions until it is freed.
+ */
+#define CMARK_OPT_LAZY_INLINES (1 << 12)
+
+/** Keep an index of the nodes of the document by type, so that
+ * repeated calls to `cmark_node_select` on it take time proportional to
+ * the number of nodes they return.  The index is built by the first
+ * call and dropped when nodes are added to or removed from the document.
+ */
+#define CMARK_OPT_NODE_INDEX (1 << 13)
+
+/** Record what parsing and rendering the document cost (see
+ * `cmark_stats`).
+ */
+#define CMARK_OPT_STATS (1 << 14)
+
 /**
  * ## Version information
  */
@@ -11,8 +11,11 @@
 #include "scanners.h"
 #include "render.h"
 
-#define OUT(s, wrap, escaping) renderer->out(renderer, s, wrap, escaping)
-#define LIT(s) renderer->out(renderer, s, false, LITERAL)
+#define OUT(s, wrap, escaping)                                                 \
+  renderer->out(renderer, s, strlen(s), wrap, escaping)
+#define OUT_CHUNK(c, wrap, escaping)                                           \
+  renderer->out(renderer, (const char *)(c).data, (c).len, wrap, escaping)
+#define LIT(s) renderer->out(renderer, s, strlen(s), false, LITERAL)
 #define CR() renderer->cr(renderer)
 #define BLANKLINE() renderer->blankline(renderer)
 #define ENCODED_SIZE 20
@@ -20,6 +23,17 @@
 
 // Functions to convert cmark_nodes to commonmark strings.
 
+// Characters outc may escape: *_[]#<>\`!&-+=.) in normal text,
+// `<>"\ in titles and `<>\() and whitespace in URLs.
+static const unsigned char ESCAPES[] = {
+0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 8, 2, 4, 2, 0, 0, 2, 0, 8, 10, 2, 2, 0, 2, 2, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 2, 14, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 14, 2, 0, 2, 14, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0,
+};
+
 static CMARK_INLINE void outc(cmark_renderer *renderer, cmark_escaping escape,
                               int32_t c, unsigned char nextc) {
   bool needs_escaping = false;
@@ -61,13 +75,12 @@ static CMARK_INLINE void outc(cmark_renderer *renderer, cmark_escaping escape,
   }
 }
 
-static int longest_backtick_sequence(const char *code) {
+static int longest_backtick_sequence(const cmark_chunk *code) {
   int longest = 0;
   int current = 0;
-  size_t i = 0;
-  size_t code_len = strlen(code);
-  while (i <= code_len) {
-    if (code[i] == '`') {
+  bufsize_t i = 0;
+  while (i <= code->len) {
+    if (i < code->len && code->data[i] == '`') {
       current++;
     } else {
       if (current > longest) {
@@ -80,13 +93,12 @@ static int longest_backtick_sequence(const char *code) {
   return longest;
 }
 
-static int shortest_unused_backtick_sequence(const char *code) {
+static int shortest_unused_backtick_sequence(const cmark_chunk *code) {
   int32_t used = 1;
   int current = 0;
-  size_t i = 0;
-  size_t code_len = strlen(code);
-  while (i <= code_len) {
-    if (code[i] == '`') {
+  bufsize_t i = 0;
+  while (i <= code->len) {
+    if (i < code->len && code->data[i] == '`') {
       current++;
     } else {
       if (current) {
@@ -102,22 +114,46 @@ static int shortest_unused_backtick_sequence(const char *code) {
     used = used >> 1;
     i++;
   }
-  return (int)i;
+  return i;
+}
+
+static bool S_is_mailto(const cmark_chunk *url) {
+  return url->len >= 7 && memcmp(url->data, "mailto:", 7) == 0;
+}
+
+// Compares the literal of 'node' and of any text nodes directly
+// following it with 's', as though adjacent text nodes had been merged.
+// This leaves the tree alone, unlike cmark_consolidate_text_nodes.
+static bool S_text_equals(cmark_node *node, const unsigned char *s,
+                          bufsize_t len) {
+  do {
+    if (node->as.literal.len > len ||
+        memcmp(node->as.literal.data, s, node->as.literal.len) != 0) {
+      return false;
+    }
+    s += node->as.literal.len;
+    len -= node->as.literal.len;
+    if (node->type != CMARK_NODE_TEXT) {
+      break;
+    }
+    node = node->next;
+  } while (node && node->type == CMARK_NODE_TEXT);
+  return len == 0;
 }
 
 static bool is_autolink(cmark_node *node) {
   cmark_chunk *title;
   cmark_chunk *url;
   cmark_node *link_text;
-  char *realurl;
-  int realurllen;
+  const unsigned char *realurl;
+  bufsize_t realurllen;
 
   if (node->type != CMARK_NODE_LINK) {
     return false;
   }
 
   url = &node->as.link.url;
-  if (url->len == 0 || scan_scheme(url, 0) == 0) {
+  if (url->len == 0 || cmark_node_scan_url(node, &_scan_scheme) == 0) {
     return false;
   }
 
@@ -131,16 +167,13 @@ static bool is_autolink(cmark_node *node) {
   if (link_text == NULL) {
     return false;
   }
-  cmark_consolidate_text_nodes(link_text);
-  realurl = (char *)url->data;
+  realurl = url->data;
   realurllen = url->len;
-  if (strncmp(realurl, "mailto:", 7) == 0) {
+  if (S_is_mailto(url)) {
     realurl += 7;
     realurllen -= 7;
   }
-  return (realurllen == link_text->as.literal.len &&
-          strncmp(realurl, (char *)link_text->as.literal.data,
-                  link_text->as.literal.len) == 0);
+  return S_text_equals(link_text, realurl, realurllen);
 }
 
 // if node is a block node, returns node.
@@ -166,8 +199,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
   int numticks;
   int i;
   bool entering = (ev_type == CMARK_EVENT_ENTER);
-  const char *info, *code, *title;
-  size_t info_len, code_len;
+  cmark_chunk info, code, title;
   char listmarker[LISTMARKER_SIZE];
   char *emph_delim;
   bool first_in_list_item;
@@ -272,23 +304,22 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     if (!first_in_list_item) {
       BLANKLINE();
     }
-    info = cmark_node_get_fence_info(node);
-    info_len = strlen(info);
-    code = cmark_node_get_literal(node);
-    code_len = strlen(code);
+    info = node->as.code.info;
+    code = node->as.code.literal;
     // use indented form if no info, and code doesn't
     // begin or end with a blank line, and code isn't
     // first thing in a list item
-    if (info_len == 0 && (code_len > 2 && !cmark_isspace(code[0]) &&
-                          !(cmark_isspace(code[code_len - 1]) &&
-                            cmark_isspace(code[code_len - 2]))) &&
+    if (info.len == 0 &&
+        (code.len > 2 && !cmark_isspace(code.data[0]) &&
+         !(cmark_isspace(code.data[code.len - 1]) &&
+           cmark_isspace(code.data[code.len - 2]))) &&
         !first_in_list_item) {
       LIT("    ");
       cmark_strbuf_puts(renderer->prefix, "    ");
-      OUT(cmark_node_get_literal(node), false, LITERAL);
+      OUT_CHUNK(code, false, LITERAL);
       cmark_strbuf_truncate(renderer->prefix, renderer->prefix->size - 4);
     } else {
-      numticks = longest_backtick_sequence(code) + 1;
+      numticks = longest_backtick_sequence(&code) + 1;
       if (numticks < 3) {
         numticks = 3;
       }
@@ -296,9 +327,9 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
         LIT("`");
       }
       LIT(" ");
-      OUT(info, false, LITERAL);
+      OUT_CHUNK(info, false, LITERAL);
       CR();
-      OUT(cmark_node_get_literal(node), false, LITERAL);
+      OUT_CHUNK(code, false, LITERAL);
       CR();
       for (i = 0; i < numticks; i++) {
         LIT("`");
@@ -309,14 +340,14 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_HTML_BLOCK:
     BLANKLINE();
-    OUT(cmark_node_get_literal(node), false, LITERAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), false, LITERAL);
     BLANKLINE();
     break;
 
   case CMARK_NODE_CUSTOM_BLOCK:
     BLANKLINE();
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     BLANKLINE();
     break;
 
@@ -333,7 +364,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_TEXT:
-    OUT(cmark_node_get_literal(node), allow_wrap, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), allow_wrap, NORMAL);
     break;
 
   case CMARK_NODE_LINEBREAK:
@@ -357,17 +388,16 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_CODE:
-    code = cmark_node_get_literal(node);
-    code_len = strlen(code);
-    numticks = shortest_unused_backtick_sequence(code);
+    code = node->as.literal;
+    numticks = shortest_unused_backtick_sequence(&code);
     for (i = 0; i < numticks; i++) {
       LIT("`");
     }
-    if (code_len == 0 || code[0] == '`') {
+    if (code.len == 0 || code.data[0] == '`') {
       LIT(" ");
     }
-    OUT(cmark_node_get_literal(node), allow_wrap, LITERAL);
-    if (code_len == 0 || code[code_len - 1] == '`') {
+    OUT_CHUNK(code, allow_wrap, LITERAL);
+    if (code.len == 0 || code.data[code.len - 1] == '`') {
       LIT(" ");
     }
     for (i = 0; i < numticks; i++) {
@@ -376,12 +406,12 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_HTML_INLINE:
-    OUT(cmark_node_get_literal(node), false, LITERAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), false, LITERAL);
     break;
 
   case CMARK_NODE_CUSTOM_INLINE:
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     break;
 
   case CMARK_NODE_STRONG:
@@ -412,10 +442,11 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     if (is_autolink(node)) {
       if (entering) {
         LIT("<");
-        if (strncmp(cmark_node_get_url(node), "mailto:", 7) == 0) {
-          LIT((const char *)cmark_node_get_url(node) + 7);
+        if (S_is_mailto(&node->as.link.url)) {
+          renderer->out(renderer, (const char *)node->as.link.url.data + 7,
+                        node->as.link.url.len - 7, false, LITERAL);
         } else {
-          LIT((const char *)cmark_node_get_url(node));
+          OUT_CHUNK(node->as.link.url, false, LITERAL);
         }
         LIT(">");
         // return signal to skip contents of node...
@@ -426,11 +457,11 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
         LIT("[");
       } else {
         LIT("](");
-        OUT(cmark_node_get_url(node), false, URL);
-        title = cmark_node_get_title(node);
-        if (strlen(title) > 0) {
+        OUT_CHUNK(node->as.link.url, false, URL);
+        title = node->as.link.title;
+        if (title.len > 0) {
           LIT(" \"");
-          OUT(title, false, TITLE);
+          OUT_CHUNK(title, false, TITLE);
           LIT("\"");
         }
         LIT(")");
@@ -443,11 +474,11 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
       LIT("![");
     } else {
       LIT("](");
-      OUT(cmark_node_get_url(node), false, URL);
-      title = cmark_node_get_title(node);
-      if (strlen(title) > 0) {
+      OUT_CHUNK(node->as.link.url, false, URL);
+      title = node->as.link.title;
+      if (title.len > 0) {
         OUT(" \"", allow_wrap, LITERAL);
-        OUT(title, false, TITLE);
+        OUT_CHUNK(title, false, TITLE);
         LIT("\"");
       }
       LIT(")");
@@ -468,5 +499,5 @@ char *cmark_render_commonmark(cmark_node *root, int options, int width) {
     // a different meaning with OPT_HARDBREAKS
     width = 0;
   }
-  return cmark_render(root, options, width, outc, S_render_node);
+  return cmark_render(root, options, width, outc, ESCAPES, S_render_node);
 }
@@ -0,0 +1,84 @@
+#ifndef CMARK_HASH_H
+#define CMARK_HASH_H
+
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Non-cryptographic 64-bit hashing (a variant of MurmurHash64A),
+ * consuming eight bytes per round.  Hashes are only meant to be
+ * compared within a single process: they are not stable across
+ * platforms of different endianness.
+ */
+
+#define CMARK_HASH_SEED 0x9e3779b97f4a7c15ULL
+#define CMARK_HASH_M 0xc6a4a7935bd1e995ULL
+#define CMARK_HASH_R 47
+
+static CMARK_INLINE uint64_t cmark_hash_int(uint64_t h, uint64_t k) {
+  k *= CMARK_HASH_M;
+  k ^= k >> CMARK_HASH_R;
+  k *= CMARK_HASH_M;
+  h ^= k;
+  h *= CMARK_HASH_M;
+  return h;
+}
+
+static CMARK_INLINE uint64_t cmark_hash_bytes(uint64_t h,
+                                              const unsigned char *data,
+                                              bufsize_t len) {
+  uint64_t k;
+
+  h ^= (uint64_t)len * CMARK_HASH_M;
+
+  while (len >= 8) {
+    memcpy(&k, data, 8);
+    h = cmark_hash_int(h, k);
+    data += 8;
+    len -= 8;
+  }
+
+  switch (len) {
+  case 7:
+    h ^= (uint64_t)data[6] << 48;
+    /* fallthrough */
+  case 6:
+    h ^= (uint64_t)data[5] << 40;
+    /* fallthrough */
+  case 5:
+    h ^= (uint64_t)data[4] << 32;
+    /* fallthrough */
+  case 4:
+    h ^= (uint64_t)data[3] << 24;
+    /* fallthrough */
+  case 3:
+    h ^= (uint64_t)data[2] << 16;
+    /* fallthrough */
+  case 2:
+    h ^= (uint64_t)data[1] << 8;
+    /* fallthrough */
+  case 1:
+    h ^= (uint64_t)data[0];
+    h *= CMARK_HASH_M;
+  }
+
+  return h;
+}
+
+static CMARK_INLINE uint64_t cmark_hash_finish(uint64_t h) {
+  h ^= h >> CMARK_HASH_R;
+  h *= CMARK_HASH_M;
+  h ^= h >> CMARK_HASH_R;
+  return h;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
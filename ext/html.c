@@ -8,7 +8,11 @@
 #include "node.h"
 #include "buffer.h"
 #include "houdini.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
 #include "scanners.h"
+#include "hash.h"
 
 #define BUFFER_SIZE 100
 
@@ -27,6 +31,19 @@ static CMARK_INLINE void cr(cmark_strbuf *html) {
 struct render_state {
   cmark_strbuf *html;
   cmark_node *plain;
+  cmark_html_hooks *hooks;
+  // Rendering stops once the output is longer than this, if not 0.
+  size_t max_output;
+};
+
+struct cmark_html_hooks {
+  cmark_mem *mem;
+  cmark_html_hook hook[CMARK_NODE_LAST_INLINE + 1];
+  void *userdata[CMARK_NODE_LAST_INLINE + 1];
+};
+
+struct cmark_html_output {
+  cmark_strbuf *html;
 };
 
 static void S_render_sourcepos(cmark_node *node, cmark_strbuf *html,
@@ -279,7 +296,7 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
     if (entering) {
       cmark_strbuf_puts(html, "<a href=\"");
       if (!((options & CMARK_OPT_SAFE) &&
-            scan_dangerous_url(&node->as.link.url, 0))) {
+            cmark_node_scan_url(node, &_scan_dangerous_url))) {
         houdini_escape_href(html, node->as.link.url.data,
                             node->as.link.url.len);
       }
@@ -297,7 +314,7 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
     if (entering) {
       cmark_strbuf_puts(html, "<img src=\"");
       if (!((options & CMARK_OPT_SAFE) &&
-            scan_dangerous_url(&node->as.link.url, 0))) {
+            cmark_node_scan_url(node, &_scan_dangerous_url))) {
         houdini_escape_href(html, node->as.link.url.data,
                             node->as.link.url.len);
       }
@@ -322,20 +339,452 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
   return 1;
 }
 
-char *cmark_render_html(cmark_node *root, int options) {
-  char *result;
-  cmark_strbuf html = CMARK_BUF_INIT(cmark_node_mem(root));
+// Gives the hook registered for the type of 'node', if any, a chance to
+// render it.  Returns true if the node has been dealt with.  Hooks are
+// not called for the description of an image, which is rendered as
+// plain text.
+static bool S_run_hook(cmark_iter *iter, cmark_node *node,
+                       cmark_event_type ev_type, struct render_state *state,
+                       int options) {
+  cmark_html_hook hook = state->hooks->hook[node->type];
+  void *userdata = state->hooks->userdata[node->type];
+  cmark_html_output out = {state->html};
+
+  if (hook == NULL || state->plain != NULL)
+    return false;
+
+  switch (hook(node, ev_type, options, &out, userdata)) {
+  case CMARK_HTML_HOOK_SKIP:
+    if (ev_type == CMARK_EVENT_ENTER)
+      cmark_iter_reset(iter, node, CMARK_EVENT_EXIT);
+    return true;
+  case CMARK_HTML_HOOK_REPLACE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void S_render_tree(cmark_node *root, struct render_state *state,
+                          int options) {
   cmark_event_type ev_type;
   cmark_node *cur;
-  struct render_state state = {&html, NULL};
   cmark_iter *iter = cmark_iter_new(root);
 
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
-    S_render_node(cur, ev_type, &state, options);
+    if (state->hooks && S_run_hook(iter, cur, ev_type, state, options))
+      continue;
+    S_render_node(cur, ev_type, state, options);
+    if (state->max_output && (size_t)state->html->size > state->max_output)
+      break;
   }
-  result = (char *)cmark_strbuf_detach(&html);
 
   cmark_iter_free(iter);
-  return result;
+}
+
+char *cmark_render_html(cmark_node *root, int options) {
+  cmark_strbuf html = CMARK_BUF_INIT(cmark_node_mem(root));
+  struct render_state state = {&html, NULL, NULL, 0};
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+
+  state.max_output = cmark_limiter_max_output(root);
+  S_render_tree(root, &state, options);
+  if (stats)
+    cmark_stats_add_render(stats, start, html.size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+  if (!cmark_limiter_check_output(root, html.size)) {
+    cmark_strbuf_free(&html);
+    return NULL;
+  }
+  return (char *)cmark_strbuf_detach(&html);
+}
+
+// Render hooks.
+
+cmark_html_hooks *cmark_html_hooks_new(void) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_mem *mem = &DEFAULT_MEM_ALLOCATOR;
+  cmark_html_hooks *hooks =
+      (cmark_html_hooks *)cmark_mem_calloc(mem, 1, sizeof(cmark_html_hooks));
+  hooks->mem = mem;
+  return hooks;
+}
+
+void cmark_html_hooks_free(cmark_html_hooks *hooks) {
+  if (hooks)
+    hooks->mem->free(hooks);
+}
+
+int cmark_html_hooks_set(cmark_html_hooks *hooks, cmark_node_type type,
+                         cmark_html_hook hook, void *userdata) {
+  if (type <= CMARK_NODE_NONE || type > CMARK_NODE_LAST_INLINE)
+    return 0;
+  hooks->hook[type] = hook;
+  hooks->userdata[type] = userdata;
+  return 1;
+}
+
+void cmark_html_output_put(cmark_html_output *out, const char *data,
+                           size_t len) {
+  cmark_strbuf_put(out->html, (const unsigned char *)data, (bufsize_t)len);
+}
+
+void cmark_html_output_escape(cmark_html_output *out, const char *data,
+                              size_t len) {
+  escape_html(out->html, (const unsigned char *)data, (bufsize_t)len);
+}
+
+char *cmark_render_html_with_hooks(cmark_node *root, int options,
+                                   cmark_html_hooks *hooks) {
+  cmark_strbuf html = CMARK_BUF_INIT(cmark_node_mem(root));
+  struct render_state state = {&html, NULL, hooks, 0};
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+
+  state.max_output = cmark_limiter_max_output(root);
+  S_render_tree(root, &state, options);
+  if (stats)
+    cmark_stats_add_render(stats, start, html.size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+  if (!cmark_limiter_check_output(root, html.size)) {
+    cmark_strbuf_free(&html);
+    return NULL;
+  }
+  return (char *)cmark_strbuf_detach(&html);
+}
+
+// Per-block render cache.
+
+// Options that change the HTML produced for a block.
+#define HTML_CACHE_OPTIONS                                                     \
+  (CMARK_OPT_SOURCEPOS | CMARK_OPT_HARDBREAKS | CMARK_OPT_SAFE |             \
+   CMARK_OPT_NOBREAKS)
+
+typedef struct html_cache_entry {
+  uint64_t key;
+  unsigned char *html; // followed by the block's content (S_cache_content)
+  bufsize_t len;
+  bufsize_t content_len;
+  struct html_cache_entry *chain; // next entry in the same bucket
+  struct html_cache_entry *newer; // towards the most recently used end
+  struct html_cache_entry *older; // towards the eviction end
+} html_cache_entry;
+
+struct cmark_html_cache {
+  cmark_mem *mem;
+  html_cache_entry **buckets;
+  size_t nbuckets;
+  html_cache_entry *newest;
+  html_cache_entry *oldest;
+  int size;
+  int capacity;
+  cmark_html_cache_policy policy;
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+};
+
+// Cache key for 'block': its structural hash combined with the
+// options affecting its HTML and, if they are rendered, the source
+// positions in the block.  Link references have already been resolved
+// into URLs and titles by the parser, so the reference set is covered
+// by the link nodes themselves.
+static uint64_t S_cache_key(cmark_node *block, int options) {
+  uint64_t h = cmark_hash_int(cmark_node_hash(block),
+                              options & HTML_CACHE_OPTIONS);
+  cmark_node *cur = block;
+
+  if (!(options & CMARK_OPT_SOURCEPOS))
+    return h;
+
+  while (true) {
+    h = cmark_hash_int(h, ((uint64_t)(uint32_t)cur->start_line << 32) |
+                              (uint32_t)cur->start_column);
+    h = cmark_hash_int(h, ((uint64_t)(uint32_t)cur->end_line << 32) |
+                              (uint32_t)cur->end_column);
+    if (cur->first_child) {
+      cur = cur->first_child;
+      continue;
+    }
+    while (cur != block && cur->next == NULL)
+      cur = cur->parent;
+    if (cur == block)
+      return cmark_hash_finish(h);
+    cur = cur->next;
+  }
+}
+
+static void S_cache_put_int(cmark_strbuf *buf, uint32_t n) {
+  cmark_strbuf_put(buf, (const unsigned char *)&n, sizeof(n));
+}
+
+// Sets 'buf' to everything the cache key of 'block' is computed from.
+// An entry is only used if its block's content is the same, since the
+// 64-bit key alone can be made to collide by crafted input.  The
+// inlines of 'block' have been parsed when its key was computed.
+static void S_cache_content(cmark_strbuf *buf, cmark_node *block,
+                            int options) {
+  cmark_node *cur = block, *child;
+  uint32_t children;
+
+  cmark_strbuf_clear(buf);
+  S_cache_put_int(buf, options & HTML_CACHE_OPTIONS);
+  while (true) {
+    cmark_node_put_attributes(buf, cur);
+    children = 0;
+    for (child = cur->first_child; child; child = child->next)
+      children++;
+    S_cache_put_int(buf, children);
+    if (options & CMARK_OPT_SOURCEPOS) {
+      S_cache_put_int(buf, (uint32_t)cur->start_line);
+      S_cache_put_int(buf, (uint32_t)cur->start_column);
+      S_cache_put_int(buf, (uint32_t)cur->end_line);
+      S_cache_put_int(buf, (uint32_t)cur->end_column);
+    }
+    if (cur->first_child) {
+      cur = cur->first_child;
+      continue;
+    }
+    while (cur != block && cur->next == NULL)
+      cur = cur->parent;
+    if (cur == block)
+      return;
+    cur = cur->next;
+  }
+}
+
+static void S_cache_unlink(cmark_html_cache *cache, html_cache_entry *entry) {
+  if (entry->newer)
+    entry->newer->older = entry->older;
+  else
+    cache->newest = entry->older;
+  if (entry->older)
+    entry->older->newer = entry->newer;
+  else
+    cache->oldest = entry->newer;
+  entry->newer = entry->older = NULL;
+}
+
+static void S_cache_push(cmark_html_cache *cache, html_cache_entry *entry) {
+  entry->older = cache->newest;
+  entry->newer = NULL;
+  if (cache->newest)
+    cache->newest->newer = entry;
+  else
+    cache->oldest = entry;
+  cache->newest = entry;
+}
+
+static void S_cache_evict(cmark_html_cache *cache) {
+  html_cache_entry *entry = cache->oldest;
+  html_cache_entry **slot = &cache->buckets[entry->key & (cache->nbuckets - 1)];
+
+  while (*slot != entry)
+    slot = &(*slot)->chain;
+  *slot = entry->chain;
+
+  S_cache_unlink(cache, entry);
+  cache->mem->free(entry->html);
+  cache->mem->free(entry);
+  cache->size--;
+  cache->evictions++;
+}
+
+static html_cache_entry *S_cache_lookup(cmark_html_cache *cache, uint64_t key,
+                                        const cmark_strbuf *content) {
+  html_cache_entry *entry;
+
+  if (cache->nbuckets == 0)
+    return NULL;
+
+  for (entry = cache->buckets[key & (cache->nbuckets - 1)]; entry;
+       entry = entry->chain) {
+    if (entry->key == key && entry->content_len == content->size &&
+        memcmp(entry->html + entry->len, content->ptr, content->size) == 0) {
+      if (cache->policy == CMARK_HTML_CACHE_LRU) {
+        S_cache_unlink(cache, entry);
+        S_cache_push(cache, entry);
+      }
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void S_cache_insert(cmark_html_cache *cache, uint64_t key,
+                           const cmark_strbuf *content,
+                           const unsigned char *html, bufsize_t len) {
+  html_cache_entry *entry;
+  size_t bucket;
+
+  if (cache->capacity <= 0)
+    return;
+
+  while (cache->size >= cache->capacity)
+    S_cache_evict(cache);
+
+  entry = (html_cache_entry *)cmark_mem_calloc(cache->mem, 1, sizeof(*entry));
+  entry->key = key;
+  entry->len = len;
+  entry->content_len = content->size;
+  entry->html = (unsigned char *)cmark_mem_calloc(
+      cache->mem, (size_t)len + (size_t)content->size + 1, 1);
+  memcpy(entry->html, html, len);
+  memcpy(entry->html + len, content->ptr, content->size);
+
+  bucket = key & (cache->nbuckets - 1);
+  entry->chain = cache->buckets[bucket];
+  cache->buckets[bucket] = entry;
+  S_cache_push(cache, entry);
+  cache->size++;
+}
+
+cmark_html_cache *cmark_html_cache_new_with_mem(int capacity,
+                                                cmark_mem *mem) {
+  cmark_html_cache *cache =
+      (cmark_html_cache *)cmark_mem_calloc(mem, 1, sizeof(cmark_html_cache));
+  cache->mem = mem;
+  cache->policy = CMARK_HTML_CACHE_LRU;
+  cmark_html_cache_set_capacity(cache, capacity);
+  return cache;
+}
+
+cmark_html_cache *cmark_html_cache_new(int capacity) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  return cmark_html_cache_new_with_mem(capacity, &DEFAULT_MEM_ALLOCATOR);
+}
+
+void cmark_html_cache_clear(cmark_html_cache *cache) {
+  while (cache->oldest)
+    S_cache_evict(cache);
+  cache->hits = cache->misses = cache->evictions = 0;
+}
+
+void cmark_html_cache_free(cmark_html_cache *cache) {
+  if (cache == NULL)
+    return;
+  cmark_html_cache_clear(cache);
+  cache->mem->free(cache->buckets);
+  cache->mem->free(cache);
+}
+
+int cmark_html_cache_get_capacity(cmark_html_cache *cache) {
+  return cache->capacity;
+}
+
+int cmark_html_cache_set_capacity(cmark_html_cache *cache, int capacity) {
+  html_cache_entry *entry;
+  size_t nbuckets = 16;
+  size_t i;
+
+  if (capacity < 0)
+    return 0;
+
+  cache->capacity = capacity;
+  while (cache->size > capacity)
+    S_cache_evict(cache);
+
+  // Keep the load factor at or below one entry per bucket.
+  while (nbuckets < (size_t)capacity)
+    nbuckets <<= 1;
+  if (nbuckets == cache->nbuckets)
+    return 1;
+
+  cache->mem->free(cache->buckets);
+  cache->buckets = (html_cache_entry **)cmark_mem_calloc(
+      cache->mem, nbuckets, sizeof(html_cache_entry *));
+  cache->nbuckets = nbuckets;
+  for (entry = cache->oldest; entry; entry = entry->newer) {
+    i = entry->key & (nbuckets - 1);
+    entry->chain = cache->buckets[i];
+    cache->buckets[i] = entry;
+  }
+  return 1;
+}
+
+cmark_html_cache_policy cmark_html_cache_get_policy(cmark_html_cache *cache) {
+  return cache->policy;
+}
+
+int cmark_html_cache_set_policy(cmark_html_cache *cache,
+                                cmark_html_cache_policy policy) {
+  switch (policy) {
+  case CMARK_HTML_CACHE_LRU:
+  case CMARK_HTML_CACHE_FIFO:
+    cache->policy = policy;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+int cmark_html_cache_get_size(cmark_html_cache *cache) { return cache->size; }
+
+size_t cmark_html_cache_get_hits(cmark_html_cache *cache) {
+  return cache->hits;
+}
+
+size_t cmark_html_cache_get_misses(cmark_html_cache *cache) {
+  return cache->misses;
+}
+
+size_t cmark_html_cache_get_evictions(cmark_html_cache *cache) {
+  return cache->evictions;
+}
+
+char *cmark_render_html_cached(cmark_node *root, int options,
+                               cmark_html_cache *cache) {
+  cmark_strbuf html = CMARK_BUF_INIT(cmark_node_mem(root));
+  cmark_strbuf content = CMARK_BUF_INIT(cmark_node_mem(root));
+  struct render_state state = {&html, NULL, NULL, 0};
+  html_cache_entry *entry;
+  cmark_node *block;
+  cmark_stats *stats;
+  bufsize_t start;
+  uint64_t key, stats_start;
+  cmark_mem_phase phase;
+
+  if (cache == NULL || root->type != CMARK_NODE_DOCUMENT)
+    return cmark_render_html(root, options);
+  stats = cmark_stats_of(root);
+  stats_start = stats ? cmark_stats_start_render(stats) : 0;
+  phase = cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+  state.max_output = cmark_limiter_max_output(root);
+
+  // The document itself renders as nothing, and every top-level block
+  // ends its output with a newline, so blocks can be rendered (and
+  // cached) independently of their neighbours.
+  for (block = root->first_child; block; block = block->next) {
+    key = S_cache_key(block, options);
+    S_cache_content(&content, block, options);
+    entry = S_cache_lookup(cache, key, &content);
+    if (entry) {
+      cache->hits++;
+      cmark_strbuf_put(&html, entry->html, entry->len);
+      continue;
+    }
+
+    cache->misses++;
+    start = html.size;
+    S_render_tree(block, &state, options);
+    if (state.max_output && (size_t)html.size > state.max_output)
+      break; // cut short, so not cached
+    S_cache_insert(cache, key, &content, html.ptr + start, html.size - start);
+  }
+  cmark_strbuf_free(&content);
+
+  if (stats)
+    cmark_stats_add_render(stats, stats_start, html.size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+  if (!cmark_limiter_check_output(root, html.size)) {
+    cmark_strbuf_free(&html);
+    return NULL;
+  }
+  return (char *)cmark_strbuf_detach(&html);
 }
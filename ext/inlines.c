@@ -12,6 +12,9 @@
 #include "utf8.h"
 #include "scanners.h"
 #include "inlines.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
 
 static const char *EMDASH = "\xE2\x80\x94";
 static const char *ENDASH = "\xE2\x80\x93";
@@ -56,6 +59,15 @@ typedef struct {
   cmark_reference_map *refmap;
   delimiter *last_delim;
   bracket *last_bracket;
+  cmark_stats *stats;
+  cmark_limiter *limiter;
+  // Delimiters and brackets pushed so far.
+  size_t delimiters;
+  // Whether 'input' is borrowed from the source, and the copy of it that
+  // is scanned instead (see S_scannable).
+  bool borrowed;
+  cmark_strbuf scan_copy;
+  cmark_chunk scan_input;
 } subject;
 
 static CMARK_INLINE bool S_is_line_end_char(char c) {
@@ -67,14 +79,14 @@ static delimiter *S_insert_emph(subject *subj, delimiter *opener,
 
 static int parse_inline(subject *subj, cmark_node *parent, int options);
 
-static void subject_from_buf(cmark_mem *mem, subject *e, cmark_strbuf *buffer,
+static void subject_from_buf(cmark_mem *mem, subject *e, cmark_chunk *chunk,
                              cmark_reference_map *refmap);
 static bufsize_t subject_find_special_char(subject *subj, int options);
 
 // Create an inline with a literal string value.
 static CMARK_INLINE cmark_node *make_literal(cmark_mem *mem, cmark_node_type t,
                                              cmark_chunk s) {
-  cmark_node *e = (cmark_node *)mem->calloc(1, sizeof(*e));
+  cmark_node *e = (cmark_node *)cmark_mem_calloc(mem, 1, sizeof(*e));
   cmark_strbuf_init(mem, &e->content, 0);
   e->type = t;
   e->as.literal = s;
@@ -83,7 +95,7 @@ static CMARK_INLINE cmark_node *make_literal(cmark_mem *mem, cmark_node_type t,
 
 // Create an inline with no value.
 static CMARK_INLINE cmark_node *make_simple(cmark_mem *mem, cmark_node_type t) {
-  cmark_node *e = (cmark_node *)mem->calloc(1, sizeof(*e));
+  cmark_node *e = (cmark_node *)cmark_mem_calloc(mem, 1, sizeof(*e));
   cmark_strbuf_init(mem, &e->content, 0);
   e->type = t;
   return e;
@@ -108,7 +120,7 @@ static cmark_chunk chunk_clone(cmark_mem *mem, cmark_chunk *src) {
   bufsize_t len = src->len;
 
   c.len = len;
-  c.data = (unsigned char *)mem->calloc(len + 1, 1);
+  c.data = (unsigned char *)cmark_mem_calloc(mem, len + 1, 1);
   c.alloc = 1;
   memcpy(c.data, src->data, len);
   c.data[len] = '\0';
@@ -143,16 +155,38 @@ static CMARK_INLINE cmark_node *make_autolink(cmark_mem *mem, cmark_chunk url,
   return link;
 }
 
-static void subject_from_buf(cmark_mem *mem, subject *e, cmark_strbuf *buffer,
+static void subject_from_buf(cmark_mem *mem, subject *e, cmark_chunk *chunk,
                              cmark_reference_map *refmap) {
   e->mem = mem;
-  e->input.data = buffer->ptr;
-  e->input.len = buffer->size;
+  e->input.data = chunk->data;
+  e->input.len = chunk->len;
   e->input.alloc = 0;
   e->pos = 0;
   e->refmap = refmap;
   e->last_delim = NULL;
   e->last_bracket = NULL;
+  e->stats = NULL;
+  e->limiter = NULL;
+  e->delimiters = 0;
+  e->borrowed = false;
+  cmark_strbuf_init(mem, &e->scan_copy, 0);
+  e->scan_input.data = NULL;
+  e->scan_input.len = 0;
+  e->scan_input.alloc = 0;
+}
+
+// The scanners NUL-terminate what they scan while they run, which must
+// not happen to borrowed input: that is scanned in a copy, made the
+// first time it is needed.  The offsets into both are the same.
+static cmark_chunk *S_scannable(subject *subj) {
+  if (!subj->borrowed)
+    return &subj->input;
+  if (subj->scan_input.data == NULL) {
+    cmark_strbuf_put(&subj->scan_copy, subj->input.data, subj->input.len);
+    subj->scan_input.data = subj->scan_copy.ptr;
+    subj->scan_input.len = subj->input.len;
+  }
+  return &subj->scan_input;
 }
 
 static CMARK_INLINE int isbacktick(int c) { return (c == '`'); }
@@ -364,9 +398,23 @@ static void pop_bracket(subject *subj) {
   subj->mem->free(b);
 }
 
+// Returns whether another delimiter or bracket can be pushed.  Past the
+// limit, they are left as text.
+static CMARK_INLINE bool S_can_push(subject *subj) {
+  if (subj->limiter && subj->limiter->limits.max_delimiters &&
+      subj->delimiters >= subj->limiter->limits.max_delimiters)
+    return false;
+  subj->delimiters++;
+  return true;
+}
+
 static void push_delimiter(subject *subj, unsigned char c, bool can_open,
                            bool can_close, cmark_node *inl_text) {
-  delimiter *delim = (delimiter *)subj->mem->calloc(1, sizeof(delimiter));
+  delimiter *delim;
+
+  if (!S_can_push(subj))
+    return;
+  delim = (delimiter *)cmark_mem_calloc(subj->mem, 1, sizeof(delimiter));
   delim->delim_char = c;
   delim->can_open = can_open;
   delim->can_close = can_close;
@@ -377,10 +425,16 @@ static void push_delimiter(subject *subj, unsigned char c, bool can_open,
     delim->previous->next = delim;
   }
   subj->last_delim = delim;
+  if (subj->stats)
+    subj->stats->delimiters_pushed++;
 }
 
 static void push_bracket(subject *subj, bool image, cmark_node *inl_text) {
-  bracket *b = (bracket *)subj->mem->calloc(1, sizeof(bracket));
+  bracket *b;
+
+  if (!S_can_push(subj))
+    return;
+  b = (bracket *)cmark_mem_calloc(subj->mem, 1, sizeof(bracket));
   if (subj->last_bracket != NULL) {
     subj->last_bracket->bracket_after = true;
   }
@@ -501,6 +555,8 @@ static void process_emphasis(subject *subj, delimiter *stack_bottom) {
 
   // now move forward, looking for closers, and handling each
   while (closer != NULL) {
+    if (subj->stats)
+      subj->stats->delimiters_processed++;
     if (closer->can_close) {
       // Now look backwards for first matching opener:
       opener = closer->previous;
@@ -605,6 +661,8 @@ static delimiter *S_insert_emph(subject *subj, delimiter *opener,
   // create new emph or strong, and splice it in to our inlines
   // between the opener and closer
   emph = use_delims == 1 ? make_emph(subj->mem) : make_strong(subj->mem);
+  if (subj->limiter)
+    cmark_limiter_add_nodes(subj->limiter, 1);
 
   tmp = opener_inl->next;
   while (tmp && tmp != closer_inl) {
@@ -721,7 +779,7 @@ static cmark_node *handle_pointy_brace(subject *subj) {
   advance(subj); // advance past first <
 
   // first try to match a URL autolink
-  matchlen = scan_autolink_uri(&subj->input, subj->pos);
+  matchlen = scan_autolink_uri(S_scannable(subj), subj->pos);
   if (matchlen > 0) {
     contents = cmark_chunk_dup(&subj->input, subj->pos, matchlen - 1);
     subj->pos += matchlen;
@@ -730,7 +788,7 @@ static cmark_node *handle_pointy_brace(subject *subj) {
   }
 
   // next try to match an email autolink
-  matchlen = scan_autolink_email(&subj->input, subj->pos);
+  matchlen = scan_autolink_email(S_scannable(subj), subj->pos);
   if (matchlen > 0) {
     contents = cmark_chunk_dup(&subj->input, subj->pos, matchlen - 1);
     subj->pos += matchlen;
@@ -739,7 +797,7 @@ static cmark_node *handle_pointy_brace(subject *subj) {
   }
 
   // finally, try to match an html tag
-  matchlen = scan_html_tag(&subj->input, subj->pos);
+  matchlen = scan_html_tag(S_scannable(subj), subj->pos);
   if (matchlen > 0) {
     contents = cmark_chunk_dup(&subj->input, subj->pos - 1, matchlen + 1);
     subj->pos += matchlen;
@@ -836,20 +894,21 @@ static cmark_node *handle_close_bracket(subject *subj) {
 
   // First, look for an inline link.
   if (peek_char(subj) == '(' &&
-      ((sps = scan_spacechars(&subj->input, subj->pos + 1)) > -1) &&
-      ((n = scan_link_url(&subj->input, subj->pos + 1 + sps)) > -1)) {
+      ((sps = scan_spacechars(S_scannable(subj), subj->pos + 1)) > -1) &&
+      ((n = scan_link_url(S_scannable(subj), subj->pos + 1 + sps)) > -1)) {
 
     // try to parse an explicit link:
     starturl = subj->pos + 1 + sps; // after (
     endurl = starturl + n;
-    starttitle = endurl + scan_spacechars(&subj->input, endurl);
+    starttitle = endurl + scan_spacechars(S_scannable(subj), endurl);
 
     // ensure there are spaces btw url and title
     endtitle = (starttitle == endurl)
                    ? starttitle
-                   : starttitle + scan_link_title(&subj->input, starttitle);
+                   : starttitle +
+                         scan_link_title(S_scannable(subj), starttitle);
 
-    endall = endtitle + scan_spacechars(&subj->input, endtitle);
+    endall = endtitle + scan_spacechars(S_scannable(subj), endtitle);
 
     if (peek_at(subj, endall) == ')') {
       subj->pos = endall + 1;
@@ -888,6 +947,8 @@ static cmark_node *handle_close_bracket(subject *subj) {
 
   if (found_label) {
     ref = cmark_reference_lookup(subj->refmap, &raw_label);
+    if (subj->stats)
+      subj->stats->references_looked_up++;
     cmark_chunk_free(subj->mem, &raw_label);
   }
 
@@ -907,6 +968,8 @@ noMatch:
 
 match:
   inl = make_simple(subj->mem, is_image ? CMARK_NODE_IMAGE : CMARK_NODE_LINK);
+  if (subj->limiter)
+    cmark_limiter_add_nodes(subj->limiter, 1);
   inl->as.link.url = url;
   inl->as.link.title = title;
   cmark_node_insert_before(opener->inl_text, inl);
@@ -1085,21 +1148,85 @@ static int parse_inline(subject *subj, cmark_node *parent, int options) {
   return 1;
 }
 
+// Counts the inline about to be parsed against the limits of the
+// document.  Returns false if parsing has to stop.
+static CMARK_INLINE bool S_within_limits(subject *subj) {
+  return subj->limiter == NULL ||
+         (cmark_limiter_add_nodes(subj->limiter, 1) &&
+          cmark_limiter_step(subj->limiter));
+}
+
 // Parse inlines from parent's string_content, adding as children of parent.
 extern void cmark_parse_inlines(cmark_mem *mem, cmark_node *parent,
-                                cmark_reference_map *refmap, int options) {
+                                cmark_reference_map *refmap, int options,
+                                cmark_stats *stats, cmark_limiter *limiter) {
   subject subj;
-  subject_from_buf(mem, &subj, &parent->content, refmap);
+  uint64_t start = 0, emphasis_start = 0;
+  cmark_mem_phase phase = cmark_mem_set_phase(mem, CMARK_MEM_INLINES);
+  cmark_node *child;
+  cmark_chunk content = {parent->content.ptr, parent->content.size, 0};
+
+  subject_from_buf(mem, &subj, &content, refmap);
+  subj.stats = stats;
+  subj.limiter = limiter;
+  subj.borrowed = parent->content.asize == 0;
   cmark_chunk_rtrim(&subj.input);
+  if (stats)
+    start = cmark_stats_now();
 
-  while (!is_eof(&subj) && parse_inline(&subj, parent, options))
+  while (!is_eof(&subj) && S_within_limits(&subj) &&
+         parse_inline(&subj, parent, options))
     ;
+  if (!is_eof(&subj)) {
+    // Stopped by a limit: the rest is text.
+    cmark_node_append_child(
+        parent, make_str(mem, cmark_chunk_dup(&subj.input, subj.pos,
+                                              subj.input.len - subj.pos)));
+  }
 
+  if (stats)
+    emphasis_start = cmark_stats_now();
   process_emphasis(&subj, NULL);
   // free bracket stack
   while (subj.last_bracket) {
     pop_bracket(&subj);
   }
+  cmark_strbuf_free(&subj.scan_copy);
+
+  if (stats) {
+    uint64_t end = cmark_stats_now();
+    stats->emphasis_ns += end - emphasis_start;
+    stats->inline_ns += end - start;
+    for (child = parent->first_child; child; child = child->next)
+      cmark_stats_count_nodes(stats, child);
+  }
+  cmark_mem_set_phase(mem, phase);
+}
+
+void cmark_parse_pending_inlines(cmark_node *node) {
+  cmark_node *root = node;
+  cmark_reference_map *refmap = NULL;
+  cmark_stats *stats = NULL;
+  cmark_limiter *limiter = NULL;
+  int options = CMARK_OPT_DEFAULT;
+
+  node->flags &= ~CMARK_NODE__PENDING_INLINES;
+
+  while (root->parent) {
+    root = root->parent;
+  }
+  if (root->type == CMARK_NODE_DOCUMENT) {
+    refmap = root->as.document.refmap;
+    options = root->as.document.options;
+    stats = root->as.document.stats;
+    limiter = root->as.document.limiter;
+  }
+
+  cmark_parse_inlines(cmark_node_mem(node), node, refmap, options, stats,
+                      limiter);
+  if (options & CMARK_OPT_NORMALIZE) {
+    cmark_consolidate_text_nodes(node);
+  }
 }
 
 // Parse zero or more space characters, including at most one newline.
@@ -1113,8 +1240,9 @@ static void spnl(subject *subj) {
 // Parse reference.  Assumes string begins with '[' character.
 // Modify refmap if a reference is encountered.
 // Return 0 if no reference found, otherwise position of subject
-// after reference is parsed.
-bufsize_t cmark_parse_reference_inline(cmark_mem *mem, cmark_strbuf *input,
+// after reference is parsed.  'input' must end where the block's
+// content ends, which the scanners rely on.
+bufsize_t cmark_parse_reference_inline(cmark_mem *mem, cmark_chunk *input,
                                        cmark_reference_map *refmap) {
   subject subj;
 
@@ -5,6 +5,7 @@
 #include "node.h"
 #include "cmark.h"
 #include "iterator.h"
+#include "accounting.h"
 
 static const int S_leaf_mask =
     (1 << CMARK_NODE_HTML_BLOCK) | (1 << CMARK_NODE_THEMATIC_BREAK) |
@@ -16,8 +17,14 @@ cmark_iter *cmark_iter_new(cmark_node *root) {
   if (root == NULL) {
     return NULL;
   }
-  cmark_mem *mem = root->content.mem;
-  cmark_iter *iter = (cmark_iter *)mem->calloc(1, sizeof(cmark_iter));
+  return cmark_iter_new_with_mem(root, root->content.mem);
+}
+
+cmark_iter *cmark_iter_new_with_mem(cmark_node *root, cmark_mem *mem) {
+  if (root == NULL) {
+    return NULL;
+  }
+  cmark_iter *iter = (cmark_iter *)cmark_mem_calloc(mem, 1, sizeof(cmark_iter));
   iter->mem = mem;
   iter->root = root;
   iter->cur.ev_type = CMARK_EVENT_NONE;
@@ -46,6 +53,7 @@ cmark_event_type cmark_iter_next(cmark_iter *iter) {
 
   /* roll forward to next item, setting both fields */
   if (ev_type == CMARK_EVENT_ENTER && !S_is_leaf(node)) {
+    cmark_node_ensure_inlines(node);
     if (node->first_child == NULL) {
       /* stay on this node but exit */
       iter->next.ev_type = CMARK_EVENT_EXIT;
@@ -112,6 +120,7 @@ void cmark_consolidate_text_nodes(cmark_node *root) {
       }
       cmark_chunk_free(iter->mem, &cur->as.literal);
       cur->as.literal = cmark_chunk_buf_detach(&buf);
+      cmark_node_clear_hash(cur);
     }
   }
 
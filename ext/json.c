@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "buffer.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
+
+#define BUFFER_SIZE 100
+
+// Output is passed to a sink once this much has accumulated.
+#define SINK_CHUNK_SIZE 16384
+
+// Functions to convert cmark_nodes to JSON strings.
+//
+// Each node becomes an object with a "type" (the name returned by
+// cmark_node_get_type_string), a "sourcepos" array of start line,
+// start column, end line and end column if CMARK_OPT_SOURCEPOS is
+// given and the position is known (it is not for inlines), the fields
+// of its type, and, unless it is a leaf, an array of "children":
+//
+//   list:                 "list_type" ("bullet" or "ordered"), "start"
+//                         and "delim" ("period" or "paren") if ordered,
+//                         "tight"
+//   heading:              "level"
+//   code_block:           "info", "literal"
+//   html_block, text,
+//   code, html_inline:    "literal"
+//   custom_block,
+//   custom_inline:        "on_enter", "on_exit"
+//   link, image:          "destination", "title"
+//
+// Leaves are code_block, html_block, thematic_break, text, softbreak,
+// linebreak, code and html_inline.  The output has no whitespace
+// between tokens and ends with a newline.
+
+// Characters that need escaping in JSON strings: 1 for those with a
+// short escape sequence, 2 for other control characters.
+static const char JSON_ESCAPE_TABLE[] = {
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// Appends 'source' as a quoted JSON string.  As in the HTML escaper,
+// runs of characters that need no escaping are copied in one go.
+static void escape_json(cmark_strbuf *dest, const unsigned char *source,
+                        bufsize_t length) {
+  static const char HEX[] = "0123456789abcdef";
+  bufsize_t i = 0, org;
+  unsigned char c;
+  char esc[6] = {'\\', 'u', '0', '0', 0, 0};
+
+  cmark_strbuf_putc(dest, '"');
+  while (i < length) {
+    org = i;
+    while (i < length && JSON_ESCAPE_TABLE[source[i]] == 0)
+      i++;
+
+    if (i > org)
+      cmark_strbuf_put(dest, source + org, i - org);
+
+    if (i >= length)
+      break;
+
+    c = source[i];
+    switch (c) {
+    case '"':
+      cmark_strbuf_puts(dest, "\\\"");
+      break;
+    case '\\':
+      cmark_strbuf_puts(dest, "\\\\");
+      break;
+    case '\b':
+      cmark_strbuf_puts(dest, "\\b");
+      break;
+    case '\f':
+      cmark_strbuf_puts(dest, "\\f");
+      break;
+    case '\n':
+      cmark_strbuf_puts(dest, "\\n");
+      break;
+    case '\r':
+      cmark_strbuf_puts(dest, "\\r");
+      break;
+    case '\t':
+      cmark_strbuf_puts(dest, "\\t");
+      break;
+    default:
+      esc[4] = HEX[c >> 4];
+      esc[5] = HEX[c & 0xf];
+      cmark_strbuf_put(dest, (const unsigned char *)esc, 6);
+      break;
+    }
+    i++;
+  }
+  cmark_strbuf_putc(dest, '"');
+}
+
+static void S_field(cmark_strbuf *json, const char *name,
+                    const cmark_chunk *value) {
+  cmark_strbuf_puts(json, ",\"");
+  cmark_strbuf_puts(json, name);
+  cmark_strbuf_puts(json, "\":");
+  escape_json(json, value->data, value->len);
+}
+
+static bool S_is_leaf(cmark_node *node) {
+  switch (node->type) {
+  case CMARK_NODE_CODE_BLOCK:
+  case CMARK_NODE_HTML_BLOCK:
+  case CMARK_NODE_THEMATIC_BREAK:
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_SOFTBREAK:
+  case CMARK_NODE_LINEBREAK:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void S_render_node(cmark_strbuf *json, cmark_node *root,
+                          cmark_node *node, cmark_event_type ev_type,
+                          int options) {
+  char buffer[BUFFER_SIZE];
+
+  // Leaves have no exit event, so they are closed on entering.
+  if (ev_type == CMARK_EVENT_EXIT) {
+    cmark_strbuf_puts(json, "]}");
+    return;
+  }
+
+  if (node != root && node->prev) {
+    cmark_strbuf_putc(json, ',');
+  }
+  cmark_strbuf_puts(json, "{\"type\":\"");
+  cmark_strbuf_puts(json, cmark_node_get_type_string(node));
+  cmark_strbuf_putc(json, '"');
+
+  if (options & CMARK_OPT_SOURCEPOS && node->start_line != 0) {
+    snprintf(buffer, BUFFER_SIZE, ",\"sourcepos\":[%d,%d,%d,%d]",
+             node->start_line, node->start_column, node->end_line,
+             node->end_column);
+    cmark_strbuf_puts(json, buffer);
+  }
+
+  switch (node->type) {
+  case CMARK_NODE_LIST:
+    if (node->as.list.list_type == CMARK_ORDERED_LIST) {
+      snprintf(buffer, BUFFER_SIZE,
+               ",\"list_type\":\"ordered\",\"start\":%d,\"delim\":\"%s\"",
+               node->as.list.start,
+               node->as.list.delimiter == CMARK_PAREN_DELIM ? "paren"
+                                                            : "period");
+      cmark_strbuf_puts(json, buffer);
+    } else {
+      cmark_strbuf_puts(json, ",\"list_type\":\"bullet\"");
+    }
+    cmark_strbuf_puts(json, node->as.list.tight ? ",\"tight\":true"
+                                                : ",\"tight\":false");
+    break;
+  case CMARK_NODE_HEADING:
+    snprintf(buffer, BUFFER_SIZE, ",\"level\":%d", node->as.heading.level);
+    cmark_strbuf_puts(json, buffer);
+    break;
+  case CMARK_NODE_CODE_BLOCK:
+    S_field(json, "info", &node->as.code.info);
+    S_field(json, "literal", &node->as.code.literal);
+    break;
+  case CMARK_NODE_HTML_BLOCK:
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+    S_field(json, "literal", &node->as.literal);
+    break;
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    S_field(json, "on_enter", &node->as.custom.on_enter);
+    S_field(json, "on_exit", &node->as.custom.on_exit);
+    break;
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    S_field(json, "destination", &node->as.link.url);
+    S_field(json, "title", &node->as.link.title);
+    break;
+  default:
+    break;
+  }
+
+  if (S_is_leaf(node)) {
+    cmark_strbuf_putc(json, '}');
+  } else {
+    cmark_strbuf_puts(json, ",\"children\":[");
+  }
+}
+
+// Renders 'root' into 'json', passing the output to 'sink' in pieces of
+// about SINK_CHUNK_SIZE bytes if it is not NULL.  Returns false if the
+// output went past the limit of the document.
+static bool S_render_json(cmark_strbuf *json, cmark_node *root, int options,
+                          cmark_sink sink, void *userdata) {
+  cmark_event_type ev_type;
+  cmark_node *cur;
+  size_t flushed = 0;
+  size_t max_output = cmark_limiter_max_output(root);
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+  cmark_iter *iter = cmark_iter_new(root);
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    S_render_node(json, root, cur, ev_type, options);
+    if (max_output && flushed + json->size > max_output)
+      break;
+    if (sink && json->size >= SINK_CHUNK_SIZE) {
+      sink((const char *)json->ptr, json->size, userdata);
+      flushed += json->size;
+      cmark_strbuf_clear(json);
+    }
+  }
+  cmark_strbuf_putc(json, '\n');
+  if (stats)
+    cmark_stats_add_render(stats, start, flushed + json->size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+
+  cmark_iter_free(iter);
+  return cmark_limiter_check_output(root, flushed + json->size);
+}
+
+char *cmark_render_json(cmark_node *root, int options) {
+  cmark_strbuf json = CMARK_BUF_INIT(cmark_node_mem(root));
+
+  if (!S_render_json(&json, root, options, NULL, NULL)) {
+    cmark_strbuf_free(&json);
+    return NULL;
+  }
+  return (char *)cmark_strbuf_detach(&json);
+}
+
+int cmark_render_json_to_sink(cmark_node *root, int options, cmark_sink sink,
+                              void *userdata) {
+  cmark_strbuf json = CMARK_BUF_INIT(cmark_node_mem(root));
+  bool complete = S_render_json(&json, root, options, sink, userdata);
+
+  if (complete)
+    sink((const char *)json.ptr, json.size, userdata);
+  cmark_strbuf_free(&json);
+  return complete;
+}
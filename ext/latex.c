@@ -11,12 +11,25 @@
 #include "scanners.h"
 #include "render.h"
 
-#define OUT(s, wrap, escaping) renderer->out(renderer, s, wrap, escaping)
-#define LIT(s) renderer->out(renderer, s, false, LITERAL)
+#define OUT(s, wrap, escaping)                                                 \
+  renderer->out(renderer, s, strlen(s), wrap, escaping)
+#define OUT_CHUNK(c, wrap, escaping)                                           \
+  renderer->out(renderer, (const char *)(c).data, (c).len, wrap, escaping)
+#define LIT(s) renderer->out(renderer, s, strlen(s), false, LITERAL)
 #define CR() renderer->cr(renderer)
 #define BLANKLINE() renderer->blankline(renderer)
 #define LIST_NUMBER_STRING_SIZE 20
 
+// Characters outc may escape: {}#%&$_-~^\|<>[]"' in all contexts.
+static const unsigned char ESCAPES[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 14, 14, 14, 14, 14, 0, 0, 0, 0, 0, 14, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 0, 14, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 14, 14, 14, 14, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 14, 14, 14, 14, 0,
+};
+
 static CMARK_INLINE void outc(cmark_renderer *renderer, cmark_escaping escape,
                               int32_t c, unsigned char nextc) {
   if (escape == LITERAL) {
@@ -149,46 +162,60 @@ typedef enum {
   INTERNAL_LINK
 } link_type;
 
+// Compares the literal of 'node' and of any text nodes directly
+// following it with 's', as though adjacent text nodes had been merged.
+// This leaves the tree alone, unlike cmark_consolidate_text_nodes.
+static bool S_text_equals(cmark_node *node, const unsigned char *s,
+                          bufsize_t len) {
+  do {
+    if (node->as.literal.len > len ||
+        memcmp(node->as.literal.data, s, node->as.literal.len) != 0) {
+      return false;
+    }
+    s += node->as.literal.len;
+    len -= node->as.literal.len;
+    if (node->type != CMARK_NODE_TEXT) {
+      break;
+    }
+    node = node->next;
+  } while (node && node->type == CMARK_NODE_TEXT);
+  return len == 0;
+}
+
 static link_type get_link_type(cmark_node *node) {
-  size_t title_len, url_len;
+  cmark_chunk *url, *title;
   cmark_node *link_text;
-  char *realurl;
-  int realurllen;
+  const unsigned char *realurl;
+  bufsize_t realurllen;
   bool isemail = false;
 
   if (node->type != CMARK_NODE_LINK) {
     return NO_LINK;
   }
 
-  const char *url = cmark_node_get_url(node);
-  cmark_chunk url_chunk = cmark_chunk_literal(url);
+  url = &node->as.link.url;
 
-  if (url && *url == '#') {
+  if (url->len > 0 && url->data[0] == '#') {
     return INTERNAL_LINK;
   }
 
-  url_len = strlen(url);
-  if (url_len == 0 || scan_scheme(&url_chunk, 0) == 0) {
+  if (url->len == 0 || cmark_node_scan_url(node, &_scan_scheme) == 0) {
     return NO_LINK;
   }
 
-  const char *title = cmark_node_get_title(node);
-  title_len = strlen(title);
+  title = &node->as.link.title;
+  link_text = node->first_child;
   // if it has a title, we can't treat it as an autolink:
-  if (title_len == 0) {
+  if (title->len == 0 && link_text != NULL) {
 
-    link_text = node->first_child;
-    cmark_consolidate_text_nodes(link_text);
-    realurl = (char *)url;
-    realurllen = (int)url_len;
-    if (strncmp(realurl, "mailto:", 7) == 0) {
+    realurl = url->data;
+    realurllen = url->len;
+    if (realurllen >= 7 && memcmp(realurl, "mailto:", 7) == 0) {
       realurl += 7;
       realurllen -= 7;
       isemail = true;
     }
-    if (realurllen == link_text->as.literal.len &&
-        strncmp(realurl, (char *)link_text->as.literal.data,
-                link_text->as.literal.len) == 0) {
+    if (S_text_equals(link_text, realurl, realurllen)) {
       if (isemail) {
         return EMAIL_AUTOLINK;
       } else {
@@ -304,7 +331,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     CR();
     LIT("\\begin{verbatim}");
     CR();
-    OUT(cmark_node_get_literal(node), false, LITERAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), false, LITERAL);
     CR();
     LIT("\\end{verbatim}");
     BLANKLINE();
@@ -315,8 +342,8 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_CUSTOM_BLOCK:
     CR();
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     CR();
     break;
 
@@ -333,7 +360,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_TEXT:
-    OUT(cmark_node_get_literal(node), allow_wrap, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), allow_wrap, NORMAL);
     break;
 
   case CMARK_NODE_LINEBREAK:
@@ -354,7 +381,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_CODE:
     LIT("\\texttt{");
-    OUT(cmark_node_get_literal(node), false, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), false, NORMAL);
     LIT("}");
     break;
 
@@ -362,8 +389,8 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_CUSTOM_INLINE:
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     break;
 
   case CMARK_NODE_STRONG:
@@ -384,26 +411,27 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_LINK:
     if (entering) {
-      const char *url = cmark_node_get_url(node);
+      cmark_chunk url = node->as.link.url;
       // requires \usepackage{hyperref}
       switch (get_link_type(node)) {
       case URL_AUTOLINK:
         LIT("\\url{");
-        OUT(url, false, URL);
+        OUT_CHUNK(url, false, URL);
         break;
       case EMAIL_AUTOLINK:
         LIT("\\href{");
-        OUT(url, false, URL);
+        OUT_CHUNK(url, false, URL);
         LIT("}\\nolinkurl{");
         break;
       case NORMAL_LINK:
         LIT("\\href{");
-        OUT(url, false, URL);
+        OUT_CHUNK(url, false, URL);
         LIT("}{");
         break;
       case INTERNAL_LINK:
         LIT("\\protect\\hyperlink{");
-        OUT(url + 1, false, URL);
+        renderer->out(renderer, (const char *)url.data + 1, url.len - 1, false,
+                      URL);
         LIT("}{");
         break;
       case NO_LINK:
@@ -419,7 +447,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     if (entering) {
       LIT("\\protect\\includegraphics{");
       // requires \include{graphicx}
-      OUT(cmark_node_get_url(node), false, URL);
+      OUT_CHUNK(node->as.link.url, false, URL);
       LIT("}");
       return 0;
     }
@@ -434,5 +462,5 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 }
 
 char *cmark_render_latex(cmark_node *root, int options, int width) {
-  return cmark_render(root, options, width, outc, S_render_node);
+  return cmark_render(root, options, width, outc, ESCAPES, S_render_node);
 }
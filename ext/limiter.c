@@ -0,0 +1,68 @@
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "parser.h"
+#include "accounting.h"
+#include "limiter.h"
+
+// Resource limits.
+//
+// Like statistics, the limiter is kept by the document node, so that
+// inlines parsed lazily and renderings are bounded too.  The parser
+// checks the node and time limits between lines and the inline parser
+// between inlines, so a parse that reaches one stops within a line or
+// an inline of it; the depth and delimiter limits never fail, they
+// only leave markers as text.
+
+void cmark_parser_set_limits(cmark_parser *parser,
+                             const cmark_limits *limits) {
+  cmark_limiter *limiter;
+
+  if (parser->root == NULL)
+    return;
+  limiter = parser->limiter;
+  if (limiter == NULL) {
+    limiter = (cmark_limiter *)cmark_mem_calloc(parser->mem, 1,
+                                                sizeof(cmark_limiter));
+    parser->limiter = limiter;
+    parser->root->as.document.limiter = limiter;
+  }
+  limiter->limits = *limits;
+  limiter->deadline = 0;
+  if (limits->max_time > 0)
+    limiter->deadline = cmark_stats_now() + (uint64_t)(limits->max_time * 1e9);
+}
+
+cmark_limit cmark_parser_get_exceeded_limit(cmark_parser *parser) {
+  return parser->limiter ? parser->limiter->exceeded : parser->exceeded;
+}
+
+cmark_limiter *cmark_limiter_of(cmark_node *node) {
+  if (node == NULL)
+    return NULL;
+  while (node->parent)
+    node = node->parent;
+  return node->type == CMARK_NODE_DOCUMENT ? node->as.document.limiter : NULL;
+}
+
+cmark_limit cmark_node_get_exceeded_limit(cmark_node *node) {
+  cmark_limiter *limiter = cmark_limiter_of(node);
+
+  return limiter ? limiter->exceeded : CMARK_LIMIT_NONE;
+}
+
+size_t cmark_limiter_max_output(cmark_node *node) {
+  cmark_limiter *limiter = cmark_limiter_of(node);
+
+  return limiter ? limiter->limits.max_output : 0;
+}
+
+bool cmark_limiter_check_output(cmark_node *node, size_t size) {
+  cmark_limiter *limiter = cmark_limiter_of(node);
+
+  if (limiter == NULL || limiter->limits.max_output == 0 ||
+      size <= limiter->limits.max_output)
+    return true;
+  limiter->exceeded = CMARK_LIMIT_OUTPUT;
+  return false;
+}
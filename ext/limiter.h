@@ -0,0 +1,71 @@
+#ifndef CMARK_LIMITER_H
+#define CMARK_LIMITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "stats.h"
+
+// The clock is read once every this many steps (a power of two).
+#define CMARK_LIMITER_STEPS 256
+
+typedef struct cmark_limiter {
+  cmark_limits limits;
+  // On the clock of cmark_stats_now, or 0 once parsing is over.
+  uint64_t deadline;
+  size_t nodes;
+  unsigned int steps;
+  // Set when the node or time limit is reached: parsing stops.
+  bool stopped;
+  cmark_limit exceeded;
+} cmark_limiter;
+
+// Returns the limiter of the document that 'node' belongs to, or NULL
+// if it has none.
+cmark_limiter *cmark_limiter_of(cmark_node *node);
+
+// Counts 'count' nodes as created.  Returns false once parsing has to
+// stop.
+static CMARK_INLINE bool cmark_limiter_add_nodes(cmark_limiter *limiter,
+                                                 size_t count) {
+  limiter->nodes += count;
+  if (limiter->limits.max_nodes &&
+      limiter->nodes > limiter->limits.max_nodes && !limiter->stopped) {
+    limiter->stopped = true;
+    limiter->exceeded = CMARK_LIMIT_NODES;
+  }
+  return !limiter->stopped;
+}
+
+// Counts a unit of work, such as a line or an inline, checking the
+// deadline every CMARK_LIMITER_STEPS of them.  Returns false once
+// parsing has to stop.
+static CMARK_INLINE bool cmark_limiter_step(cmark_limiter *limiter) {
+  if (limiter->deadline &&
+      (++limiter->steps & (CMARK_LIMITER_STEPS - 1)) == 0 &&
+      cmark_stats_now() > limiter->deadline && !limiter->stopped) {
+    limiter->stopped = true;
+    limiter->exceeded = CMARK_LIMIT_TIME;
+  }
+  return !limiter->stopped;
+}
+
+// Returns how many bytes a rendering of 'node' may produce, or 0 if
+// there is no bound.
+size_t cmark_limiter_max_output(cmark_node *node);
+
+// Checks the 'size' bytes a rendering of 'node' has produced against
+// the bound returned by cmark_limiter_max_output, recording the
+// failure if they go past it.  Returns false if they do.
+bool cmark_limiter_check_output(cmark_node *node, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
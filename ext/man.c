@@ -10,12 +10,25 @@
 #include "utf8.h"
 #include "render.h"
 
-#define OUT(s, wrap, escaping) renderer->out(renderer, s, wrap, escaping)
-#define LIT(s) renderer->out(renderer, s, false, LITERAL)
+#define OUT(s, wrap, escaping)                                                 \
+  renderer->out(renderer, s, strlen(s), wrap, escaping)
+#define OUT_CHUNK(c, wrap, escaping)                                           \
+  renderer->out(renderer, (const char *)(c).data, (c).len, wrap, escaping)
+#define LIT(s) renderer->out(renderer, s, strlen(s), false, LITERAL)
 #define CR() renderer->cr(renderer)
 #define BLANKLINE() renderer->blankline(renderer)
 #define LIST_NUMBER_SIZE 20
 
+// Characters S_outc may escape: .'-\ in all contexts.
+static const unsigned char ESCAPES[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 0, 0, 0, 0, 0, 14, 14, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 14, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0,
+};
+
 // Functions to convert cmark_nodes to groff man strings.
 static void S_outc(cmark_renderer *renderer, cmark_escaping escape, int32_t c,
                    unsigned char nextc) {
@@ -135,7 +148,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
   case CMARK_NODE_CODE_BLOCK:
     CR();
     LIT(".IP\n.nf\n\\f[C]\n");
-    OUT(cmark_node_get_literal(node), false, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), false, NORMAL);
     CR();
     LIT("\\f[]\n.fi");
     CR();
@@ -146,8 +159,8 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_CUSTOM_BLOCK:
     CR();
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     CR();
     break;
 
@@ -174,7 +187,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_TEXT:
-    OUT(cmark_node_get_literal(node), allow_wrap, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), allow_wrap, NORMAL);
     break;
 
   case CMARK_NODE_LINEBREAK:
@@ -195,7 +208,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 
   case CMARK_NODE_CODE:
     LIT("\\f[C]");
-    OUT(cmark_node_get_literal(node), allow_wrap, NORMAL);
+    OUT_CHUNK(cmark_node_literal_chunk(node), allow_wrap, NORMAL);
     LIT("\\f[]");
     break;
 
@@ -203,8 +216,8 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
     break;
 
   case CMARK_NODE_CUSTOM_INLINE:
-    OUT(entering ? cmark_node_get_on_enter(node) : cmark_node_get_on_exit(node),
-        false, LITERAL);
+    OUT_CHUNK(entering ? node->as.custom.on_enter : node->as.custom.on_exit,
+              false, LITERAL);
     break;
 
   case CMARK_NODE_STRONG:
@@ -226,7 +239,7 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
   case CMARK_NODE_LINK:
     if (!entering) {
       LIT(" (");
-      OUT(cmark_node_get_url(node), allow_wrap, URL);
+      OUT_CHUNK(node->as.link.url, allow_wrap, URL);
       LIT(")");
     }
     break;
@@ -248,5 +261,5 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 }
 
 char *cmark_render_man(cmark_node *root, int options, int width) {
-  return cmark_render(root, options, width, S_outc, S_render_node);
+  return cmark_render(root, options, width, S_outc, ESCAPES, S_render_node);
 }
@@ -3,6 +3,10 @@
 
 #include "config.h"
 #include "node.h"
+#include "references.h"
+#include "hash.h"
+#include "accounting.h"
+#include "scanners.h"
 
 static void S_node_unlink(cmark_node *node);
 
@@ -73,7 +77,7 @@ static bool S_can_contain(cmark_node *node, cmark_node *child) {
 }
 
 cmark_node *cmark_node_new_with_mem(cmark_node_type type, cmark_mem *mem) {
-  cmark_node *node = (cmark_node *)mem->calloc(1, sizeof(*node));
+  cmark_node *node = (cmark_node *)cmark_mem_calloc(mem, 1, sizeof(*node));
   cmark_strbuf_init(mem, &node->content, 0);
   node->type = (uint16_t)type;
 
@@ -128,6 +132,12 @@ static void S_free_nodes(cmark_node *e) {
       cmark_chunk_free(NODE_MEM(e), &e->as.custom.on_enter);
       cmark_chunk_free(NODE_MEM(e), &e->as.custom.on_exit);
       break;
+    case CMARK_NODE_DOCUMENT:
+      cmark_reference_map_free(e->as.document.refmap);
+      cmark_node_index_free(e);
+      NODE_MEM(e)->free(e->as.document.stats);
+      NODE_MEM(e)->free(e->as.document.limiter);
+      break;
     default:
       break;
     }
@@ -237,6 +247,7 @@ cmark_node *cmark_node_first_child(cmark_node *node) {
   if (node == NULL) {
     return NULL;
   } else {
+    cmark_node_ensure_inlines(node);
     return node->first_child;
   }
 }
@@ -245,6 +256,7 @@ cmark_node *cmark_node_last_child(cmark_node *node) {
   if (node == NULL) {
     return NULL;
   } else {
+    cmark_node_ensure_inlines(node);
     return node->last_child;
   }
 }
@@ -265,6 +277,17 @@ int cmark_node_set_user_data(cmark_node *node, void *user_data) {
   return 1;
 }
 
+int cmark_node_mark_handle(cmark_node *node) {
+  int marked;
+
+  if (node == NULL) {
+    return 0;
+  }
+  marked = (node->flags & CMARK_NODE__HANDLE) != 0;
+  node->flags |= CMARK_NODE__HANDLE;
+  return marked;
+}
+
 const char *cmark_node_get_literal(cmark_node *node) {
   if (node == NULL) {
     return NULL;
@@ -298,10 +321,12 @@ int cmark_node_set_literal(cmark_node *node, const char *content) {
   case CMARK_NODE_HTML_INLINE:
   case CMARK_NODE_CODE:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.literal, content);
+    cmark_node_clear_hash(node);
     return 1;
 
   case CMARK_NODE_CODE_BLOCK:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.code.literal, content);
+    cmark_node_clear_hash(node);
     return 1;
 
   default:
@@ -335,6 +360,7 @@ int cmark_node_set_heading_level(cmark_node *node, int level) {
   switch (node->type) {
   case CMARK_NODE_HEADING:
     node->as.heading.level = level;
+    cmark_node_clear_hash(node);
     return 1;
 
   default:
@@ -367,6 +393,7 @@ int cmark_node_set_list_type(cmark_node *node, cmark_list_type type) {
 
   if (node->type == CMARK_NODE_LIST) {
     node->as.list.list_type = type;
+    cmark_node_clear_hash(node);
     return 1;
   } else {
     return 0;
@@ -396,6 +423,7 @@ int cmark_node_set_list_delim(cmark_node *node, cmark_delim_type delim) {
 
   if (node->type == CMARK_NODE_LIST) {
     node->as.list.delimiter = delim;
+    cmark_node_clear_hash(node);
     return 1;
   } else {
     return 0;
@@ -421,6 +449,7 @@ int cmark_node_set_list_start(cmark_node *node, int start) {
 
   if (node->type == CMARK_NODE_LIST) {
     node->as.list.start = start;
+    cmark_node_clear_hash(node);
     return 1;
   } else {
     return 0;
@@ -446,6 +475,7 @@ int cmark_node_set_list_tight(cmark_node *node, int tight) {
 
   if (node->type == CMARK_NODE_LIST) {
     node->as.list.tight = tight == 1;
+    cmark_node_clear_hash(node);
     return 1;
   } else {
     return 0;
@@ -471,6 +501,7 @@ int cmark_node_set_fence_info(cmark_node *node, const char *info) {
 
   if (node->type == CMARK_NODE_CODE_BLOCK) {
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.code.info, info);
+    cmark_node_clear_hash(node);
     return 1;
   } else {
     return 0;
@@ -502,6 +533,7 @@ int cmark_node_set_url(cmark_node *node, const char *url) {
   case CMARK_NODE_LINK:
   case CMARK_NODE_IMAGE:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.link.url, url);
+    cmark_node_clear_hash(node);
     return 1;
   default:
     break;
@@ -535,6 +567,7 @@ int cmark_node_set_title(cmark_node *node, const char *title) {
   case CMARK_NODE_LINK:
   case CMARK_NODE_IMAGE:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.link.title, title);
+    cmark_node_clear_hash(node);
     return 1;
   default:
     break;
@@ -568,6 +601,7 @@ int cmark_node_set_on_enter(cmark_node *node, const char *on_enter) {
   case CMARK_NODE_CUSTOM_INLINE:
   case CMARK_NODE_CUSTOM_BLOCK:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.custom.on_enter, on_enter);
+    cmark_node_clear_hash(node);
     return 1;
   default:
     break;
@@ -601,6 +635,7 @@ int cmark_node_set_on_exit(cmark_node *node, const char *on_exit) {
   case CMARK_NODE_CUSTOM_INLINE:
   case CMARK_NODE_CUSTOM_BLOCK:
     cmark_chunk_set_cstr(NODE_MEM(node), &node->as.custom.on_exit, on_exit);
+    cmark_node_clear_hash(node);
     return 1;
   default:
     break;
@@ -637,6 +672,195 @@ int cmark_node_get_end_column(cmark_node *node) {
   return node->end_column;
 }
 
+static uint64_t S_hash_chunk(uint64_t h, const cmark_chunk *c) {
+  return cmark_hash_bytes(h, c->data, c->len);
+}
+
+// Hash of the type and attributes of 'node', not including children.
+// cmark_node_put_attributes must cover the same fields.
+static uint64_t S_hash_attributes(cmark_node *node) {
+  uint64_t h = cmark_hash_int(CMARK_HASH_SEED, node->type);
+
+  switch (node->type) {
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_HTML_BLOCK:
+    h = S_hash_chunk(h, &node->as.literal);
+    break;
+
+  case CMARK_NODE_CODE_BLOCK:
+    h = S_hash_chunk(h, &node->as.code.info);
+    h = S_hash_chunk(h, &node->as.code.literal);
+    break;
+
+  case CMARK_NODE_LIST:
+    h = cmark_hash_int(h, node->as.list.list_type);
+    h = cmark_hash_int(h, node->as.list.delimiter);
+    h = cmark_hash_int(h, (uint32_t)node->as.list.start);
+    h = cmark_hash_int(h, node->as.list.tight);
+    break;
+
+  case CMARK_NODE_HEADING:
+    h = cmark_hash_int(h, (uint32_t)node->as.heading.level);
+    break;
+
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    h = S_hash_chunk(h, &node->as.link.url);
+    h = S_hash_chunk(h, &node->as.link.title);
+    break;
+
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    h = S_hash_chunk(h, &node->as.custom.on_enter);
+    h = S_hash_chunk(h, &node->as.custom.on_exit);
+    break;
+
+  default:
+    break;
+  }
+
+  return h;
+}
+
+static void S_put_int(cmark_strbuf *buf, uint32_t n) {
+  cmark_strbuf_put(buf, (const unsigned char *)&n, sizeof(n));
+}
+
+static void S_put_chunk(cmark_strbuf *buf, const cmark_chunk *c) {
+  S_put_int(buf, (uint32_t)c->len);
+  cmark_strbuf_put(buf, c->data, c->len);
+}
+
+void cmark_node_put_attributes(cmark_strbuf *buf, cmark_node *node) {
+  S_put_int(buf, node->type);
+
+  switch (node->type) {
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_HTML_BLOCK:
+    S_put_chunk(buf, &node->as.literal);
+    break;
+
+  case CMARK_NODE_CODE_BLOCK:
+    S_put_chunk(buf, &node->as.code.info);
+    S_put_chunk(buf, &node->as.code.literal);
+    break;
+
+  case CMARK_NODE_LIST:
+    S_put_int(buf, node->as.list.list_type);
+    S_put_int(buf, node->as.list.delimiter);
+    S_put_int(buf, (uint32_t)node->as.list.start);
+    S_put_int(buf, node->as.list.tight);
+    break;
+
+  case CMARK_NODE_HEADING:
+    S_put_int(buf, (uint32_t)node->as.heading.level);
+    break;
+
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    S_put_chunk(buf, &node->as.link.url);
+    S_put_chunk(buf, &node->as.link.title);
+    break;
+
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    S_put_chunk(buf, &node->as.custom.on_enter);
+    S_put_chunk(buf, &node->as.custom.on_exit);
+    break;
+
+  default:
+    break;
+  }
+}
+
+bufsize_t cmark_node_scan_url(cmark_node *node,
+                              bufsize_t (*scanner)(const unsigned char *)) {
+  cmark_chunk *url = &node->as.link.url;
+  cmark_strbuf copy;
+  cmark_chunk c;
+  bufsize_t res;
+
+  if (url->alloc || url->data == NULL)
+    return _scan_at(scanner, url, 0);
+
+  cmark_strbuf_init(NODE_MEM(node), &copy, 0);
+  cmark_strbuf_put(&copy, url->data, url->len);
+  c.data = copy.ptr;
+  c.len = copy.size;
+  c.alloc = 0;
+  res = _scan_at(scanner, &c, 0);
+  cmark_strbuf_free(&copy);
+  return res;
+}
+
+uint64_t cmark_node_hash(cmark_node *node) {
+  cmark_node *cur = node;
+  bool entering = true;
+
+  if (node == NULL) {
+    return 0;
+  }
+
+  // Post-order traversal.  While a node is open, 'hash' accumulates
+  // the hashes of its children; subtrees that already carry a hash
+  // are not descended into.
+  while (true) {
+    if (entering && !(cur->flags & CMARK_NODE__HASHED)) {
+      cmark_node_ensure_inlines(cur);
+      cur->hash = S_hash_attributes(cur);
+      if (cur->first_child) {
+        cur = cur->first_child;
+        continue;
+      }
+    }
+
+    if (!(cur->flags & CMARK_NODE__HASHED)) {
+      cur->hash = cmark_hash_finish(cur->hash);
+      cur->flags |= CMARK_NODE__HASHED;
+    }
+
+    if (cur == node) {
+      return cur->hash;
+    }
+
+    cur->parent->hash = cmark_hash_int(cur->parent->hash, cur->hash);
+    if (cur->next) {
+      cur = cur->next;
+      entering = true;
+    } else {
+      cur = cur->parent;
+      entering = false;
+    }
+  }
+}
+
+// Blocks with pending inlines look up their document's reference map
+// when they are parsed, so parse them before 'node' is taken out of a
+// document that still has one.
+static void S_parse_pending_before_move(cmark_node *node) {
+  cmark_node *root = node->parent;
+  cmark_iter *iter;
+
+  if (root == NULL) {
+    return;
+  }
+  while (root->parent) {
+    root = root->parent;
+  }
+  if (root->type != CMARK_NODE_DOCUMENT || root->as.document.refmap == NULL) {
+    return;
+  }
+
+  iter = cmark_iter_new(node);
+  while (cmark_iter_next(iter) != CMARK_EVENT_DONE)
+    ;
+  cmark_iter_free(iter);
+}
+
 // Unlink a node without adjusting its next, prev, and parent pointers.
 static void S_node_unlink(cmark_node *node) {
   if (node == NULL) {
@@ -653,6 +877,8 @@ static void S_node_unlink(cmark_node *node) {
   // Adjust first_child and last_child of parent.
   cmark_node *parent = node->parent;
   if (parent) {
+    cmark_node_clear_hash(parent);
+    cmark_node_clear_index(parent);
     if (parent->first_child == node) {
       parent->first_child = node->next;
     }
@@ -663,6 +889,9 @@ static void S_node_unlink(cmark_node *node) {
 }
 
 void cmark_node_unlink(cmark_node *node) {
+  if (node) {
+    S_parse_pending_before_move(node);
+  }
   S_node_unlink(node);
 
   node->next = NULL;
@@ -679,6 +908,7 @@ int cmark_node_insert_before(cmark_node *node, cmark_node *sibling) {
     return 0;
   }
 
+  S_parse_pending_before_move(sibling);
   S_node_unlink(sibling);
 
   cmark_node *old_prev = node->prev;
@@ -694,6 +924,8 @@ int cmark_node_insert_before(cmark_node *node, cmark_node *sibling) {
   // Set new parent.
   cmark_node *parent = node->parent;
   sibling->parent = parent;
+  cmark_node_clear_hash(parent);
+  cmark_node_clear_index(parent);
 
   // Adjust first_child of parent if inserted as first child.
   if (parent && !old_prev) {
@@ -712,6 +944,7 @@ int cmark_node_insert_after(cmark_node *node, cmark_node *sibling) {
     return 0;
   }
 
+  S_parse_pending_before_move(sibling);
   S_node_unlink(sibling);
 
   cmark_node *old_next = node->next;
@@ -727,6 +960,8 @@ int cmark_node_insert_after(cmark_node *node, cmark_node *sibling) {
   // Set new parent.
   cmark_node *parent = node->parent;
   sibling->parent = parent;
+  cmark_node_clear_hash(parent);
+  cmark_node_clear_index(parent);
 
   // Adjust last_child of parent if inserted as last child.
   if (parent && !old_next) {
@@ -749,7 +984,11 @@ int cmark_node_prepend_child(cmark_node *node, cmark_node *child) {
     return 0;
   }
 
+  cmark_node_ensure_inlines(node);
+  S_parse_pending_before_move(child);
   S_node_unlink(child);
+  cmark_node_clear_hash(node);
+  cmark_node_clear_index(node);
 
   cmark_node *old_first_child = node->first_child;
 
@@ -773,7 +1012,11 @@ int cmark_node_append_child(cmark_node *node, cmark_node *child) {
     return 0;
   }
 
+  cmark_node_ensure_inlines(node);
+  S_parse_pending_before_move(child);
   S_node_unlink(child);
+  cmark_node_clear_hash(node);
+  cmark_node_clear_index(node);
 
   cmark_node *old_last_child = node->last_child;
 
@@ -46,9 +46,25 @@ typedef struct {
   cmark_chunk on_exit;
 } cmark_custom;
 
+typedef struct {
+  // Kept when inlines are parsed lazily (CMARK_OPT_LAZY_INLINES).
+  struct cmark_reference_map *refmap;
+  int options;
+  // Built by cmark_node_select with CMARK_OPT_NODE_INDEX (see select.c).
+  struct cmark_node_index *index;
+  // Kept with CMARK_OPT_STATS (see stats.c).
+  cmark_stats *stats;
+  // Set by cmark_parser_set_limits (see limiter.c).
+  struct cmark_limiter *limiter;
+} cmark_document;
+
 enum cmark_node__internal_flags {
   CMARK_NODE__OPEN = (1 << 0),
   CMARK_NODE__LAST_LINE_BLANK = (1 << 1),
+  CMARK_NODE__HASHED = (1 << 2),
+  CMARK_NODE__PENDING_INLINES = (1 << 3),
+  CMARK_NODE__HANDLE = (1 << 4),
+  CMARK_NODE__INDEXED = (1 << 5),
 };
 
 struct cmark_node {
@@ -66,6 +82,7 @@ struct cmark_node {
   int start_column;
   int end_line;
   int end_column;
+  uint64_t hash; // valid only if CMARK_NODE__HASHED is set
   uint16_t type;
   uint16_t flags;
 
@@ -76,6 +93,7 @@ struct cmark_node {
     cmark_heading heading;
     cmark_link link;
     cmark_custom custom;
+    cmark_document document;
     int html_block_type;
   } as;
 };
@@ -83,6 +101,71 @@ struct cmark_node {
 static CMARK_INLINE cmark_mem *cmark_node_mem(cmark_node *node) {
   return node->content.mem;
 }
+// Invalidates the cached hash of 'node' and of its ancestors.  A hashed
+// node only ever has hashed descendants, so we can stop at the first
+// node without a cached hash.
+static CMARK_INLINE void cmark_node_clear_hash(cmark_node *node) {
+  while (node && (node->flags & CMARK_NODE__HASHED)) {
+    node->flags &= ~CMARK_NODE__HASHED;
+    node = node->parent;
+  }
+}
+
+// Appends the type and attributes of 'node' that cmark_node_hash
+// covers to 'buf', in a form that two nodes share only if they are
+// equal in those respects.  Children are not included.
+void cmark_node_put_attributes(cmark_strbuf *buf, cmark_node *node);
+
+// Runs 'scanner' over the URL of a link or image, as _scan_at does.
+// _scan_at NUL-terminates the URL while it runs, so one that the node
+// does not own (as read by cmark_node_deserialize_borrowed, possibly
+// from read-only memory) is scanned in a copy.
+bufsize_t cmark_node_scan_url(cmark_node *node,
+                              bufsize_t (*scanner)(const unsigned char *));
+
+// Frees the node index of a document (see select.c).
+void cmark_node_index_free(cmark_node *document);
+
+// Drops the node index of the document that 'node' belongs to, if it
+// has one, before a node is added below 'node' or removed.  All nodes of
+// an indexed document are flagged, so we can stop at the first node
+// without the flag.
+static CMARK_INLINE void cmark_node_clear_index(cmark_node *node) {
+  while (node && (node->flags & CMARK_NODE__INDEXED)) {
+    node->flags &= ~CMARK_NODE__INDEXED;
+    if (node->parent == NULL && node->type == CMARK_NODE_DOCUMENT)
+      cmark_node_index_free(node);
+    node = node->parent;
+  }
+}
+
+// Parses the content of a block whose inlines are still pending, using
+// the reference map and options of its document (see inlines.c).
+void cmark_parse_pending_inlines(cmark_node *node);
+
+static CMARK_INLINE void cmark_node_ensure_inlines(cmark_node *node) {
+  if (node->flags & CMARK_NODE__PENDING_INLINES)
+    cmark_parse_pending_inlines(node);
+}
+
+// Returns the literal content of 'node' without copying it, or an
+// empty chunk for nodes that have none.  Unlike cmark_node_get_literal,
+// this never allocates or modifies the node, so the renderers use it.
+// The chunk is not NUL-terminated.
+static CMARK_INLINE cmark_chunk cmark_node_literal_chunk(cmark_node *node) {
+  switch (node->type) {
+  case CMARK_NODE_HTML_BLOCK:
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_CODE:
+    return node->as.literal;
+  case CMARK_NODE_CODE_BLOCK:
+    return node->as.code.literal;
+  default:
+    return cmark_chunk_literal(NULL);
+  }
+}
+
 CMARK_EXPORT int cmark_node_check(cmark_node *node, FILE *out);
 
 #ifdef __cplusplus
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "parser.h"
+#include "references.h"
+#include "inlines.h"
+#include "buffer.h"
+#include "accounting.h"
+#include "cmark_ctype.h"
+#include "hash.h"
+
+// Outline extraction.
+//
+// The block parser runs as usual, but each top-level block is handed
+// to S_take_headings as soon as it is closed.  Headings are moved to a
+// separate document and everything else is freed right away.  Inlines
+// are parsed for the headings only, once the whole input has been seen,
+// so that links may refer to definitions further down.
+
+typedef struct {
+  int level;
+  int start_line;
+  unsigned char *text;
+  unsigned char *slug;
+  bufsize_t slug_len;
+  uint64_t slug_hash;
+  int chain;       // next entry in the same bucket, or -1
+  int last_suffix; // last suffix tried when this slug was taken
+} outline_entry;
+
+struct cmark_outline {
+  cmark_mem *mem;
+  outline_entry *entries;
+  int size;
+  int *buckets; // first entry of each bucket, or -1
+  int num_buckets;
+};
+
+static void S_take_headings(cmark_node *block, void *data) {
+  cmark_node *headings = (cmark_node *)data;
+  cmark_iter *iter = cmark_iter_new(block);
+  cmark_event_type ev_type;
+  cmark_node *cur;
+
+  // Headings can be nested in block quotes and list items.  Moving a
+  // heading on its exit event is safe, as the iterator has already
+  // stepped past it.
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    if (ev_type == CMARK_EVENT_EXIT && cur->type == CMARK_NODE_HEADING) {
+      cmark_node_append_child(headings, cur);
+    }
+  }
+  cmark_iter_free(iter);
+
+  if (block->parent == NULL) {
+    cmark_node_free(block);
+  }
+}
+
+static void S_plain_text(cmark_strbuf *buf, cmark_node *heading) {
+  cmark_iter *iter = cmark_iter_new(heading);
+  cmark_event_type ev_type;
+  cmark_node *cur;
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    if (ev_type != CMARK_EVENT_ENTER)
+      continue;
+    switch (cur->type) {
+    case CMARK_NODE_TEXT:
+    case CMARK_NODE_CODE:
+      cmark_strbuf_put(buf, cur->as.literal.data, cur->as.literal.len);
+      break;
+    case CMARK_NODE_SOFTBREAK:
+    case CMARK_NODE_LINEBREAK:
+      cmark_strbuf_putc(buf, ' ');
+      break;
+    default:
+      break;
+    }
+  }
+
+  cmark_iter_free(iter);
+}
+
+// Turns heading text into an anchor name the way GitHub does: ASCII
+// letters are lowercased, spaces become hyphens, and ASCII punctuation
+// other than '-' and '_' is dropped.  Other bytes are kept.
+static void S_slugify(cmark_strbuf *slug, const unsigned char *text,
+                      bufsize_t len) {
+  bufsize_t i;
+  unsigned char c;
+
+  for (i = 0; i < len; i++) {
+    c = text[i];
+    if (c == ' ') {
+      cmark_strbuf_putc(slug, '-');
+    } else if (c >= 'A' && c <= 'Z') {
+      cmark_strbuf_putc(slug, c + ('a' - 'A'));
+    } else if (c == '-' || c == '_' || c >= 0x80 || cmark_isalnum(c)) {
+      cmark_strbuf_putc(slug, c);
+    }
+  }
+}
+
+static uint64_t S_slug_hash(const unsigned char *slug, bufsize_t len) {
+  return cmark_hash_finish(cmark_hash_bytes(CMARK_HASH_SEED, slug, len));
+}
+
+static outline_entry *S_find_slug(cmark_outline *outline,
+                                  const unsigned char *slug, bufsize_t len,
+                                  uint64_t hash) {
+  int i = outline->buckets[hash & (uint64_t)(outline->num_buckets - 1)];
+
+  while (i >= 0) {
+    outline_entry *e = &outline->entries[i];
+    if (e->slug_hash == hash && e->slug_len == len &&
+        memcmp(e->slug, slug, len) == 0)
+      return e;
+    i = e->chain;
+  }
+  return NULL;
+}
+
+// Adds an entry for 'heading', whose inlines have been parsed.  Slugs
+// that are already taken get a numeric suffix, starting with "-1".  The
+// entry holding the plain slug remembers the last suffix tried, so that
+// many headings with the same text take linear time.
+static void S_add_entry(cmark_outline *outline, cmark_node *heading) {
+  cmark_mem *mem = outline->mem;
+  outline_entry *e = &outline->entries[outline->size];
+  cmark_strbuf text = CMARK_BUF_INIT(mem);
+  cmark_strbuf slug = CMARK_BUF_INIT(mem);
+  outline_entry *taken;
+  bufsize_t base_len;
+  uint64_t hash;
+  size_t bucket;
+  char suffix[16];
+
+  S_plain_text(&text, heading);
+  S_slugify(&slug, text.ptr, text.size);
+  base_len = slug.size;
+  hash = S_slug_hash(slug.ptr, slug.size);
+  taken = S_find_slug(outline, slug.ptr, slug.size, hash);
+  if (taken) {
+    do {
+      cmark_strbuf_truncate(&slug, base_len);
+      snprintf(suffix, sizeof(suffix), "-%d", ++taken->last_suffix);
+      cmark_strbuf_puts(&slug, suffix);
+      hash = S_slug_hash(slug.ptr, slug.size);
+    } while (S_find_slug(outline, slug.ptr, slug.size, hash));
+  }
+
+  e->level = heading->as.heading.level;
+  e->start_line = heading->start_line;
+  e->slug_len = slug.size;
+  e->slug_hash = hash;
+  e->text = cmark_strbuf_detach(&text);
+  e->slug = cmark_strbuf_detach(&slug);
+
+  bucket = (size_t)(hash & (uint64_t)(outline->num_buckets - 1));
+  e->chain = outline->buckets[bucket];
+  outline->buckets[bucket] = outline->size;
+  outline->size++;
+}
+
+cmark_outline *cmark_extract_outline(const char *buffer, size_t len,
+                                     int options) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_mem *mem = &DEFAULT_MEM_ALLOCATOR;
+  // The headings are parsed here, against the reference map of the
+  // parser, which lazy inlines would move into the document.
+  cmark_parser *parser = cmark_parser_new_with_mem(
+      options & ~(CMARK_OPT_LAZY_INLINES | CMARK_OPT_NODE_INDEX), mem);
+  cmark_node *headings = cmark_node_new_with_mem(CMARK_NODE_DOCUMENT, mem);
+  cmark_outline *outline;
+  cmark_node *cur;
+  int count = 0;
+  int i;
+
+  parser->block_handler = S_take_headings;
+  parser->block_handler_data = headings;
+  cmark_parser_feed(parser, buffer, len);
+  cmark_node_free(cmark_parser_finish(parser));
+
+  for (cur = headings->first_child; cur; cur = cur->next) {
+    count++;
+  }
+
+  outline = (cmark_outline *)cmark_mem_calloc(mem, 1, sizeof(*outline));
+  outline->mem = mem;
+  outline->entries =
+      (outline_entry *)cmark_mem_calloc(mem, count ? count : 1,
+                                        sizeof(outline_entry));
+  outline->num_buckets = 16;
+  while (outline->num_buckets < 2 * count) {
+    outline->num_buckets *= 2;
+  }
+  outline->buckets =
+      (int *)cmark_mem_calloc(mem, outline->num_buckets, sizeof(int));
+  for (i = 0; i < outline->num_buckets; i++) {
+    outline->buckets[i] = -1;
+  }
+
+  for (cur = headings->first_child; cur; cur = cur->next) {
+    cmark_parse_inlines(mem, cur, parser->refmap, options, NULL, NULL);
+    S_add_entry(outline, cur);
+  }
+
+  cmark_node_free(headings);
+  cmark_parser_free(parser);
+  return outline;
+}
+
+void cmark_outline_free(cmark_outline *outline) {
+  int i;
+
+  if (outline == NULL)
+    return;
+
+  for (i = 0; i < outline->size; i++) {
+    outline->mem->free(outline->entries[i].text);
+    outline->mem->free(outline->entries[i].slug);
+  }
+  outline->mem->free(outline->entries);
+  outline->mem->free(outline->buckets);
+  outline->mem->free(outline);
+}
+
+int cmark_outline_get_length(cmark_outline *outline) {
+  return outline->size;
+}
+
+int cmark_outline_get_level(cmark_outline *outline, int i) {
+  if (i < 0 || i >= outline->size)
+    return 0;
+  return outline->entries[i].level;
+}
+
+const char *cmark_outline_get_text(cmark_outline *outline, int i) {
+  if (i < 0 || i >= outline->size)
+    return NULL;
+  return (const char *)outline->entries[i].text;
+}
+
+const char *cmark_outline_get_slug(cmark_outline *outline, int i) {
+  if (i < 0 || i >= outline->size)
+    return NULL;
+  return (const char *)outline->entries[i].slug;
+}
+
+int cmark_outline_get_start_line(cmark_outline *outline, int i) {
+  if (i < 0 || i >= outline->size)
+    return 0;
+  return outline->entries[i].start_line;
+}
@@ -5,6 +5,7 @@
 #include "node.h"
 #include "buffer.h"
 #include "memory.h"
+#include "accounting.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,6 +13,9 @@ extern "C" {
 
 #define MAX_LINK_LABEL_LENGTH 1000
 
+// Receives a closed top-level block, which it takes over.
+typedef void (*cmark_block_handler)(cmark_node *block, void *data);
+
 struct cmark_parser {
   struct cmark_mem *mem;
   struct cmark_reference_map *refmap;
@@ -26,10 +30,50 @@ struct cmark_parser {
   bool blank;
   bool partially_consumed_tab;
   cmark_strbuf curline;
+  // The line being processed: either the contents of 'curline' or,
+  // when lines are processed in place, a slice of the input.  Empty
+  // between lines.
+  cmark_chunk line;
   bufsize_t last_line_length;
   cmark_strbuf linebuf;
   int options;
   bool last_buffer_ended_with_cr;
+  // Streaming HTML output; see cmark_parser_set_html_sink.
+  cmark_sink html_sink;
+  void *html_sink_data;
+  // Whether the first top-level block is held back for an unmatched
+  // link label, and the number of references known when it was parsed.
+  bool stream_held;
+  size_t stream_refs;
+  // If set, closed top-level blocks are handed to this as soon as the
+  // line that closed them has been processed (see outline.c).
+  cmark_block_handler block_handler;
+  void *block_handler_data;
+  // Set by cmark_parse_document_borrowed.  Lines are then processed in
+  // place, and the content of a leaf block that turns out to be a slice
+  // of the input points into it instead of being kept as a copy.
+  bool borrow;
+  // Whether the line being processed is a slice of the input, and the
+  // copy of it that is scanned instead (see S_scannable).
+  bool line_in_place;
+  cmark_chunk scan_line;
+  // The leaf block whose lines are tracked, where its first line starts
+  // in the input, the number of bytes added since, and whether they
+  // are all contiguous in the input.
+  struct cmark_node *borrow_node;
+  const unsigned char *borrow_start;
+  bufsize_t borrow_len;
+  bool borrow_contiguous;
+  // The statistics of the document, with CMARK_OPT_STATS.
+  cmark_stats *stats;
+  // With a memory account, the blocks allocated by the parser that it
+  // has to free if an allocation is refused, and whether one was.
+  cmark_mem_owner mem_owner;
+  bool failed;
+  // The resource limits of the document, if any, and the one that made
+  // the parse fail once the document is gone.
+  struct cmark_limiter *limiter;
+  cmark_limit exceeded;
 };
 
 #ifdef __cplusplus
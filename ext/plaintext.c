@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "buffer.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
+
+// Output is passed to a sink once this much has accumulated.
+#define SINK_CHUNK_SIZE 16384
+
+// Functions to convert cmark_nodes to plain text.
+//
+// Only text that a reader would see is kept: the literals of text and
+// code nodes (including the descriptions of images), and the content
+// of code blocks.  Link destinations and titles, raw HTML and the
+// on_enter and on_exit strings of custom nodes are skipped.  Soft line
+// breaks become spaces and hard line breaks newlines.  The separator
+// is put between the text of consecutive paragraphs, headings and code
+// blocks.
+
+struct render_state {
+  cmark_strbuf *text;
+  const char *separator;
+  bool need_separator;
+  int pending_line;   // start line of the block whose text is next
+  size_t flushed;     // bytes already passed to the sink
+  cmark_sink sink;
+  cmark_anchor_fn anchor;
+  void *userdata;
+};
+
+// Appends text, preceded by the block separator and anchored to the
+// block's start line if it is the first text of a block.
+static void S_put(struct render_state *state, const unsigned char *data,
+                  bufsize_t len) {
+  if (len == 0)
+    return;
+
+  if (state->need_separator) {
+    if (state->flushed + state->text->size > 0)
+      cmark_strbuf_puts(state->text, state->separator);
+    state->need_separator = false;
+  }
+  if (state->pending_line) {
+    if (state->anchor)
+      state->anchor(state->flushed + state->text->size, state->pending_line,
+                    state->userdata);
+    state->pending_line = 0;
+  }
+  cmark_strbuf_put(state->text, data, len);
+}
+
+static void S_render_node(struct render_state *state, cmark_node *node,
+                          cmark_event_type ev_type, int options) {
+  bool entering = (ev_type == CMARK_EVENT_ENTER);
+  cmark_chunk *literal;
+  bufsize_t len;
+
+  switch (node->type) {
+  case CMARK_NODE_PARAGRAPH:
+  case CMARK_NODE_HEADING:
+    if (entering) {
+      state->pending_line = node->start_line;
+    } else {
+      state->need_separator = true;
+      state->pending_line = 0;
+    }
+    break;
+
+  case CMARK_NODE_CODE_BLOCK:
+    literal = &node->as.code.literal;
+    len = literal->len;
+    // The final newline is part of the block, not its text.
+    if (len > 0 && literal->data[len - 1] == '\n')
+      len--;
+    state->pending_line = node->start_line;
+    S_put(state, literal->data, len);
+    state->need_separator = true;
+    state->pending_line = 0;
+    break;
+
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+    S_put(state, node->as.literal.data, node->as.literal.len);
+    break;
+
+  case CMARK_NODE_SOFTBREAK:
+    if (options & CMARK_OPT_HARDBREAKS) {
+      S_put(state, (const unsigned char *)"\n", 1);
+    } else {
+      S_put(state, (const unsigned char *)" ", 1);
+    }
+    break;
+
+  case CMARK_NODE_LINEBREAK:
+    S_put(state, (const unsigned char *)"\n", 1);
+    break;
+
+  default:
+    break;
+  }
+}
+
+// Returns false if the output went past the limit of the document.
+static bool S_render_plaintext(struct render_state *state, cmark_node *root,
+                               int options) {
+  cmark_event_type ev_type;
+  cmark_node *cur;
+  size_t max_output = cmark_limiter_max_output(root);
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+  cmark_iter *iter = cmark_iter_new(root);
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cur = cmark_iter_get_node(iter);
+    S_render_node(state, cur, ev_type, options);
+    if (max_output && state->flushed + state->text->size > max_output)
+      break;
+    if (state->sink && state->text->size >= SINK_CHUNK_SIZE) {
+      state->sink((const char *)state->text->ptr, state->text->size,
+                  state->userdata);
+      state->flushed += state->text->size;
+      cmark_strbuf_clear(state->text);
+    }
+  }
+  if (stats)
+    cmark_stats_add_render(stats, start, state->flushed + state->text->size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+
+  cmark_iter_free(iter);
+  return cmark_limiter_check_output(root, state->flushed + state->text->size);
+}
+
+char *cmark_render_plaintext(cmark_node *root, int options,
+                             const char *separator) {
+  cmark_strbuf text = CMARK_BUF_INIT(cmark_node_mem(root));
+  struct render_state state = {&text, separator ? separator : "\n\n",
+                               false, 0, 0, NULL, NULL, NULL};
+
+  if (!S_render_plaintext(&state, root, options)) {
+    cmark_strbuf_free(&text);
+    return NULL;
+  }
+  return (char *)cmark_strbuf_detach(&text);
+}
+
+int cmark_render_plaintext_to_sink(cmark_node *root, int options,
+                                   const char *separator, cmark_sink sink,
+                                   cmark_anchor_fn anchor, void *userdata) {
+  cmark_strbuf text = CMARK_BUF_INIT(cmark_node_mem(root));
+  struct render_state state = {&text, separator ? separator : "\n\n",
+                               false, 0, 0, sink, anchor, userdata};
+  bool complete = S_render_plaintext(&state, root, options);
+
+  if (complete && text.size > 0)
+    sink((const char *)text.ptr, text.size, userdata);
+  cmark_strbuf_free(&text);
+  return complete;
+}
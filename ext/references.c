@@ -4,6 +4,7 @@
 #include "references.h"
 #include "inlines.h"
 #include "chunk.h"
+#include "accounting.h"
 
 static unsigned int refhash(const unsigned char *link_ref) {
   unsigned int hash = 0;
@@ -53,8 +54,29 @@ static unsigned char *normalize_reference(cmark_mem *mem, cmark_chunk *ref) {
   return result;
 }
 
+// Doubles the number of buckets, so that the chains stay short however
+// many references are defined.
+static void grow_table(cmark_reference_map *map) {
+  size_t buckets = map->buckets * 2;
+  cmark_reference **table = (cmark_reference **)cmark_mem_calloc(
+      map->mem, buckets, sizeof(cmark_reference *));
+  cmark_reference *ref, *next;
+  size_t i;
+
+  for (i = 0; i < map->buckets; ++i) {
+    for (ref = map->table[i]; ref; ref = next) {
+      next = ref->next;
+      ref->next = table[ref->hash % buckets];
+      table[ref->hash % buckets] = ref;
+    }
+  }
+  map->mem->free(map->table);
+  map->table = table;
+  map->buckets = buckets;
+}
+
 static void add_reference(cmark_reference_map *map, cmark_reference *ref) {
-  cmark_reference *t = ref->next = map->table[ref->hash % REFMAP_SIZE];
+  cmark_reference *t = ref->next = map->table[ref->hash % map->buckets];
 
   while (t) {
     if (t->hash == ref->hash && !strcmp((char *)t->label, (char *)ref->label)) {
@@ -65,7 +87,10 @@ static void add_reference(cmark_reference_map *map, cmark_reference *ref) {
     t = t->next;
   }
 
-  map->table[ref->hash % REFMAP_SIZE] = ref;
+  map->table[ref->hash % map->buckets] = ref;
+  map->size++;
+  if (map->size > map->buckets)
+    grow_table(map);
 }
 
 void cmark_reference_create(cmark_reference_map *map, cmark_chunk *label,
@@ -77,7 +102,7 @@ void cmark_reference_create(cmark_reference_map *map, cmark_chunk *label,
   if (reflabel == NULL)
     return;
 
-  ref = (cmark_reference *)map->mem->calloc(1, sizeof(*ref));
+  ref = (cmark_reference *)cmark_mem_calloc(map->mem, 1, sizeof(*ref));
   ref->label = reflabel;
   ref->hash = refhash(ref->label);
   ref->url = cmark_clean_url(map->mem, url);
@@ -106,7 +131,7 @@ cmark_reference *cmark_reference_lookup(cmark_reference_map *map,
     return NULL;
 
   hash = refhash(norm);
-  ref = map->table[hash % REFMAP_SIZE];
+  ref = map->table[hash % map->buckets];
 
   while (ref) {
     if (ref->hash == hash && !strcmp((char *)ref->label, (char *)norm))
@@ -114,17 +139,20 @@ cmark_reference *cmark_reference_lookup(cmark_reference_map *map,
     ref = ref->next;
   }
 
+  if (ref == NULL)
+    map->misses++;
+
   map->mem->free(norm);
   return ref;
 }
 
 void cmark_reference_map_free(cmark_reference_map *map) {
-  unsigned int i;
+  size_t i;
 
   if (map == NULL)
     return;
 
-  for (i = 0; i < REFMAP_SIZE; ++i) {
+  for (i = 0; i < map->buckets; ++i) {
     cmark_reference *ref = map->table[i];
     cmark_reference *next;
 
@@ -135,12 +163,17 @@ void cmark_reference_map_free(cmark_reference_map *map) {
     }
   }
 
+  map->mem->free(map->table);
   map->mem->free(map);
 }
 
 cmark_reference_map *cmark_reference_map_new(cmark_mem *mem) {
   cmark_reference_map *map =
-      (cmark_reference_map *)mem->calloc(1, sizeof(cmark_reference_map));
+      (cmark_reference_map *)cmark_mem_calloc(mem, 1,
+                                              sizeof(cmark_reference_map));
   map->mem = mem;
+  map->table = (cmark_reference **)cmark_mem_calloc(
+      mem, REFMAP_SIZE, sizeof(cmark_reference *));
+  map->buckets = REFMAP_SIZE;
   return map;
 }
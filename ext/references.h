@@ -22,7 +22,10 @@ typedef struct cmark_reference cmark_reference;
 
 struct cmark_reference_map {
   cmark_mem *mem;
-  cmark_reference *table[REFMAP_SIZE];
+  cmark_reference **table;
+  size_t buckets; // a power of two, at least REFMAP_SIZE
+  size_t size;    // number of references
+  size_t misses; // lookups of well-formed labels that found nothing
 };
 
 typedef struct cmark_reference_map cmark_reference_map;
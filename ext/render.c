@@ -1,10 +1,14 @@
 #include <stdlib.h>
+#include <string.h>
 #include "buffer.h"
 #include "chunk.h"
 #include "cmark.h"
 #include "utf8.h"
 #include "render.h"
 #include "node.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
 
 static CMARK_INLINE void S_cr(cmark_renderer *renderer) {
   if (renderer->need_cr < 1) {
@@ -18,15 +22,34 @@ static CMARK_INLINE void S_blankline(cmark_renderer *renderer) {
   }
 }
 
-static void S_out(cmark_renderer *renderer, const char *source, bool wrap,
-                  cmark_escaping escape) {
-  int length = strlen(source);
-  unsigned char nextc;
+// Returns the length of the run of characters at the start of 'source'
+// that S_out can copy as they are: ASCII other than newlines, spaces
+// at which lines may be wrapped, and characters outc would escape.
+static CMARK_INLINE int S_plain_run(cmark_renderer *renderer,
+                                    const unsigned char *source, int length,
+                                    bool wrap, cmark_escaping escape) {
+  const unsigned char *escapes = renderer->escapes;
+  unsigned char mask = escape == LITERAL ? 0 : ESCAPE_CLASS(escape);
+  unsigned char c;
+  int i = 0;
+
+  while (i < length) {
+    c = source[i];
+    if (c >= 0x80 || c == '\n' || (c == ' ' && wrap) || (escapes[c] & mask))
+      break;
+    i++;
+  }
+  return i;
+}
+
+// Renders 'length' bytes of 'source', which need not be NUL-terminated.
+static void S_out(cmark_renderer *renderer, const char *source,
+                  bufsize_t length, bool wrap, cmark_escaping escape) {
   int32_t c;
   int i = 0;
   int last_nonspace;
   int len;
-  cmark_chunk remainder = cmark_chunk_literal("");
+  int run;
   int k = renderer->buffer->size - 1;
 
   wrap = wrap && !renderer->no_linebreaks;
@@ -58,12 +81,23 @@ static void S_out(cmark_renderer *renderer, const char *source, bool wrap,
       renderer->column = renderer->prefix->size;
     }
 
-    len = cmark_utf8proc_iterate((const uint8_t *)source + i, length - i, &c);
-    if (len == -1) { // error condition
-      return;        // return without rendering rest of string
-    }
-    nextc = source[i + len];
-    if (c == 32 && wrap) {
+    run = S_plain_run(renderer, (const unsigned char *)source + i, length - i,
+                      wrap, escape);
+    if (run > 0) {
+      cmark_strbuf_put(renderer->buffer, (const unsigned char *)source + i,
+                       run);
+      renderer->column += run;
+      renderer->begin_line = false;
+      // As below, begin_content stays set while we are in leading digits.
+      for (len = 0; renderer->begin_content && len < run; len++) {
+        renderer->begin_content = cmark_isdigit(source[i + len]) == 1;
+      }
+      len = run;
+    } else if ((len = cmark_utf8proc_iterate((const uint8_t *)source + i,
+                                             length - i, &c)) == -1) {
+      // error condition
+      return; // return without rendering rest of string
+    } else if (c == 32 && wrap) {
       if (!renderer->begin_line) {
         last_nonspace = renderer->buffer->size;
         cmark_strbuf_putc(renderer->buffer, ' ');
@@ -71,12 +105,12 @@ static void S_out(cmark_renderer *renderer, const char *source, bool wrap,
         renderer->begin_line = false;
         renderer->begin_content = false;
         // skip following spaces
-        while (source[i + 1] == ' ') {
+        while (i + 1 < length && source[i + 1] == ' ') {
           i++;
         }
         // We don't allow breaks that make a digit the first character
         // because this causes problems with commonmark output.
-        if (!cmark_isdigit(source[i + 1])) {
+        if (i + 1 == length || !cmark_isdigit(source[i + 1])) {
           renderer->last_breakable = last_nonspace;
         }
       }
@@ -97,7 +131,8 @@ static void S_out(cmark_renderer *renderer, const char *source, bool wrap,
       renderer->begin_content =
           renderer->begin_content && cmark_isdigit(c) == 1;
     } else {
-      (renderer->outc)(renderer, escape, c, nextc);
+      (renderer->outc)(renderer, escape, c,
+                       i + len < length ? source[i + len] : 0);
       renderer->begin_line = false;
       renderer->begin_content =
           renderer->begin_content && cmark_isdigit(c) == 1;
@@ -108,19 +143,20 @@ static void S_out(cmark_renderer *renderer, const char *source, bool wrap,
     if (renderer->width > 0 && renderer->column > renderer->width &&
         !renderer->begin_line && renderer->last_breakable > 0) {
 
-      // copy from last_breakable to remainder
-      cmark_chunk_set_cstr(renderer->mem, &remainder,
-                           (char *)renderer->buffer->ptr +
-                               renderer->last_breakable + 1);
-      // truncate at last_breakable
-      cmark_strbuf_truncate(renderer->buffer, renderer->last_breakable);
-      // add newline, prefix, and remainder
-      cmark_strbuf_putc(renderer->buffer, '\n');
-      cmark_strbuf_put(renderer->buffer, renderer->prefix->ptr,
-                       renderer->prefix->size);
-      cmark_strbuf_put(renderer->buffer, remainder.data, remainder.len);
-      renderer->column = renderer->prefix->size + remainder.len;
-      cmark_chunk_free(renderer->mem, &remainder);
+      // Replace the space at last_breakable with a newline and the
+      // prefix, moving the rest of the line along in place.
+      cmark_strbuf *buf = renderer->buffer;
+      cmark_strbuf *prefix = renderer->prefix;
+      bufsize_t start = renderer->last_breakable + 1;
+      bufsize_t remainder = buf->size - start;
+
+      cmark_strbuf_grow(buf, buf->size + prefix->size);
+      memmove(buf->ptr + start + prefix->size, buf->ptr + start, remainder);
+      memcpy(buf->ptr + start, prefix->ptr, prefix->size);
+      buf->ptr[start - 1] = '\n';
+      buf->size += prefix->size;
+      buf->ptr[buf->size] = '\0';
+      renderer->column = prefix->size + remainder;
       renderer->last_breakable = 0;
       renderer->begin_line = false;
       renderer->begin_content = false;
@@ -145,6 +181,7 @@ void cmark_render_code_point(cmark_renderer *renderer, uint32_t c) {
 char *cmark_render(cmark_node *root, int options, int width,
                    void (*outc)(cmark_renderer *, cmark_escaping, int32_t,
                                 unsigned char),
+                   const unsigned char *escapes,
                    int (*render_node)(cmark_renderer *renderer,
                                       cmark_node *node,
                                       cmark_event_type ev_type, int options)) {
@@ -154,11 +191,17 @@ char *cmark_render(cmark_node *root, int options, int width,
   cmark_node *cur;
   cmark_event_type ev_type;
   char *result;
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+  size_t max_output = cmark_limiter_max_output(root);
   cmark_iter *iter = cmark_iter_new(root);
 
-  cmark_renderer renderer = {mem,   &buf, &pref, 0,           width,
-                             0,     0,    true,  true,        false,
-                             false, outc, S_cr,  S_blankline, S_out};
+  cmark_renderer renderer = {mem,   &buf,   &pref, 0,           width,
+                             0,     0,      true,  true,        false,
+                             false, outc,   S_cr,  S_blankline, S_out,
+                             escapes};
 
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
@@ -168,6 +211,8 @@ char *cmark_render(cmark_node *root, int options, int width,
       // autolinks.
       cmark_iter_reset(iter, cur, CMARK_EVENT_EXIT);
     }
+    if (max_output && (size_t)buf.size > max_output)
+      break;
   }
 
   // ensure final newline
@@ -175,7 +220,13 @@ char *cmark_render(cmark_node *root, int options, int width,
     cmark_strbuf_putc(renderer.buffer, '\n');
   }
 
-  result = (char *)cmark_strbuf_detach(renderer.buffer);
+  if (stats)
+    cmark_stats_add_render(stats, start, renderer.buffer->size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+  if (cmark_limiter_check_output(root, renderer.buffer->size))
+    result = (char *)cmark_strbuf_detach(renderer.buffer);
+  else
+    result = NULL;
 
   cmark_iter_free(iter);
   cmark_strbuf_free(renderer.prefix);
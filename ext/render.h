@@ -12,6 +12,13 @@ extern "C" {
 
 typedef enum { LITERAL, NORMAL, TITLE, URL } cmark_escaping;
 
+// Each renderer has a table of 128 escape classes, one per ASCII
+// character.  Bit (1 << escaping) of an entry is set if the renderer's
+// outc function may render the character as anything other than
+// itself under that escaping.  S_out copies runs of other ASCII
+// characters straight to the buffer, without calling outc.
+#define ESCAPE_CLASS(escaping) (1 << (escaping))
+
 struct cmark_renderer {
   cmark_mem *mem;
   cmark_strbuf *buffer;
@@ -27,7 +34,9 @@ struct cmark_renderer {
   void (*outc)(struct cmark_renderer *, cmark_escaping, int32_t, unsigned char);
   void (*cr)(struct cmark_renderer *);
   void (*blankline)(struct cmark_renderer *);
-  void (*out)(struct cmark_renderer *, const char *, bool, cmark_escaping);
+  void (*out)(struct cmark_renderer *, const char *, bufsize_t, bool,
+              cmark_escaping);
+  const unsigned char *escapes;
 };
 
 typedef struct cmark_renderer cmark_renderer;
@@ -39,6 +48,7 @@ void cmark_render_code_point(cmark_renderer *renderer, uint32_t c);
 char *cmark_render(cmark_node *root, int options, int width,
                    void (*outc)(cmark_renderer *, cmark_escaping, int32_t,
                                 unsigned char),
+                   const unsigned char *escapes,
                    int (*render_node)(cmark_renderer *renderer,
                                       cmark_node *node,
                                       cmark_event_type ev_type, int options));
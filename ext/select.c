@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "accounting.h"
+
+// Selecting nodes by type.
+//
+// Without an index, cmark_node_select walks the tree once.  With
+// CMARK_OPT_NODE_INDEX, the first call on a document lists its nodes in
+// document order and, for each type, the positions of the nodes of that
+// type in the list.  Later calls copy the positions of the requested
+// types, merging them when there is more than one.  Every node of an
+// indexed document is flagged CMARK_NODE__INDEXED, and adding or
+// removing a node drops the index (see cmark_node_clear_index).
+
+#define NODE_TYPES (CMARK_NODE_LAST_INLINE + 1)
+
+struct cmark_node_index {
+  cmark_node **nodes;  // all nodes, in document order
+  size_t *positions;   // positions in 'nodes', grouped by type
+  size_t start[NODE_TYPES + 1]; // where each type's positions start
+};
+
+// Appends 'node' to the array 'nodes' of 'size' elements, which has
+// room for '*alloc' of them.
+static cmark_node **S_push(cmark_mem *mem, cmark_node **nodes, size_t size,
+                           size_t *alloc, cmark_node *node) {
+  if (size == *alloc) {
+    *alloc = *alloc ? *alloc * 2 : 16;
+    nodes = (cmark_node **)cmark_mem_realloc(mem, nodes,
+                                             *alloc * sizeof(*nodes));
+  }
+  nodes[size] = node;
+  return nodes;
+}
+
+void cmark_node_index_free(cmark_node *document) {
+  struct cmark_node_index *index = document->as.document.index;
+  cmark_mem *mem = cmark_node_mem(document);
+
+  if (index == NULL)
+    return;
+  mem->free(index->nodes);
+  mem->free(index->positions);
+  mem->free(index);
+  document->as.document.index = NULL;
+}
+
+static struct cmark_node_index *S_build_index(cmark_node *document) {
+  cmark_mem *mem = cmark_node_mem(document);
+  struct cmark_node_index *index;
+  size_t next[NODE_TYPES];
+  size_t size = 0, alloc = 0, i;
+  cmark_event_type ev_type;
+  cmark_node *cur;
+  cmark_iter *iter;
+
+  index = (struct cmark_node_index *)cmark_mem_calloc(mem, 1, sizeof(*index));
+  // The iterator parses pending inlines, so the index is complete.
+  iter = cmark_iter_new(document);
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    if (ev_type != CMARK_EVENT_ENTER)
+      continue;
+    cur = cmark_iter_get_node(iter);
+    cur->flags |= CMARK_NODE__INDEXED;
+    index->nodes = S_push(mem, index->nodes, size, &alloc, cur);
+    index->start[cur->type + 1]++;
+    size++;
+  }
+  cmark_iter_free(iter);
+
+  for (i = 0; i < NODE_TYPES; i++) {
+    index->start[i + 1] += index->start[i];
+    next[i] = index->start[i];
+  }
+  index->positions = (size_t *)cmark_mem_calloc(mem, size, sizeof(size_t));
+  for (i = 0; i < size; i++)
+    index->positions[next[index->nodes[i]->type]++] = i;
+
+  document->as.document.index = index;
+  return index;
+}
+
+static cmark_node **S_select_indexed(cmark_node *document,
+                                     unsigned int type_mask, size_t max,
+                                     size_t *count) {
+  struct cmark_node_index *index = document->as.document.index;
+  cmark_mem *mem = cmark_node_mem(document);
+  size_t head[NODE_TYPES], end[NODE_TYPES];
+  int ntypes = 0, best, t, i;
+  size_t n = 0, total = 0;
+  cmark_node **nodes;
+
+  if (index == NULL)
+    index = S_build_index(document);
+
+  for (t = 0; t < NODE_TYPES; t++) {
+    if ((type_mask & CMARK_NODE_MASK(t)) &&
+        index->start[t] < index->start[t + 1]) {
+      head[ntypes] = index->start[t];
+      end[ntypes] = index->start[t + 1];
+      total += end[ntypes] - head[ntypes];
+      ntypes++;
+    }
+  }
+  if (max > 0 && total > max)
+    total = max;
+  *count = total;
+  if (total == 0)
+    return NULL;
+
+  nodes = (cmark_node **)cmark_mem_calloc(mem, total, sizeof(*nodes));
+  while (n < total) {
+    best = -1;
+    for (i = 0; i < ntypes; i++) {
+      if (head[i] < end[i] &&
+          (best < 0 ||
+           index->positions[head[i]] < index->positions[head[best]]))
+        best = i;
+    }
+    nodes[n++] = index->nodes[index->positions[head[best]++]];
+  }
+  return nodes;
+}
+
+cmark_node **cmark_node_select(cmark_node *root, unsigned int type_mask,
+                               size_t max, size_t *count) {
+  cmark_mem *mem;
+  cmark_node **nodes = NULL;
+  size_t n = 0, alloc = 0;
+  cmark_node *cur = root;
+
+  *count = 0;
+  if (root == NULL)
+    return NULL;
+  if (root->type == CMARK_NODE_DOCUMENT && root->parent == NULL &&
+      (root->as.document.options & CMARK_OPT_NODE_INDEX))
+    return S_select_indexed(root, type_mask, max, count);
+
+  mem = cmark_node_mem(root);
+  while (cur != NULL) {
+    cmark_node_ensure_inlines(cur);
+    if (type_mask & CMARK_NODE_MASK(cur->type)) {
+      nodes = S_push(mem, nodes, n, &alloc, cur);
+      if (++n == max)
+        break;
+    }
+    if (cur->first_child) {
+      cur = cur->first_child;
+      continue;
+    }
+    while (cur != root && cur->next == NULL)
+      cur = cur->parent;
+    cur = cur == root ? NULL : cur->next;
+  }
+  *count = n;
+  return nodes;
+}
@@ -0,0 +1,394 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "buffer.h"
+#include "accounting.h"
+
+// Compact binary serialization of node trees.
+//
+// A serialized tree is a fixed-size header followed by the node records
+// and then the string table:
+//
+//   offset  size  contents
+//   0       4     magic "CMKB"
+//   4       1     format version
+//   5       3     reserved, zero
+//   8       4     number of nodes
+//   12      4     size of the node records in bytes
+//   16      ...   node records
+//   ...     ...   string table
+//
+// Integers in the header are little-endian.  Node records appear in
+// document order (pre-order) and consist of unsigned LEB128 varints:
+// the node type, the number of children, the source positions, and
+// then type-specific fields.  Strings are stored as an offset and a
+// length into the string table, where each string is followed by a NUL
+// byte so that it can be used in place.
+
+#define SERIALIZE_MAGIC "CMKB"
+#define SERIALIZE_VERSION 1
+#define SERIALIZE_HEADER_SIZE 16
+
+typedef struct {
+  cmark_strbuf records;
+  cmark_strbuf strings;
+} serializer;
+
+static void S_put_u32(unsigned char *p, uint32_t n) {
+  p[0] = (unsigned char)(n & 0xff);
+  p[1] = (unsigned char)((n >> 8) & 0xff);
+  p[2] = (unsigned char)((n >> 16) & 0xff);
+  p[3] = (unsigned char)((n >> 24) & 0xff);
+}
+
+static uint32_t S_get_u32(const unsigned char *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static void S_put_varint(cmark_strbuf *buf, uint32_t n) {
+  unsigned char tmp[5];
+  bufsize_t i = 0;
+
+  while (n >= 0x80) {
+    tmp[i++] = (unsigned char)(n | 0x80);
+    n >>= 7;
+  }
+  tmp[i++] = (unsigned char)n;
+  cmark_strbuf_put(buf, tmp, i);
+}
+
+static void S_put_string(serializer *s, const cmark_chunk *c) {
+  S_put_varint(&s->records, (uint32_t)s->strings.size);
+  S_put_varint(&s->records, (uint32_t)c->len);
+  cmark_strbuf_put(&s->strings, c->data, c->len);
+  cmark_strbuf_putc(&s->strings, 0);
+}
+
+static void S_serialize_node(serializer *s, cmark_node *node) {
+  cmark_node *child;
+  uint32_t children = 0;
+
+  cmark_node_ensure_inlines(node);
+  for (child = node->first_child; child; child = child->next) {
+    children++;
+  }
+
+  S_put_varint(&s->records, node->type);
+  S_put_varint(&s->records, children);
+  S_put_varint(&s->records, (uint32_t)node->start_line);
+  S_put_varint(&s->records, (uint32_t)node->start_column);
+  S_put_varint(&s->records, (uint32_t)node->end_line);
+  S_put_varint(&s->records, (uint32_t)node->end_column);
+
+  switch (node->type) {
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_HTML_BLOCK:
+    S_put_string(s, &node->as.literal);
+    break;
+
+  case CMARK_NODE_CODE_BLOCK:
+    S_put_string(s, &node->as.code.info);
+    S_put_string(s, &node->as.code.literal);
+    S_put_varint(&s->records, (uint32_t)node->as.code.fenced);
+    S_put_varint(&s->records, node->as.code.fence_char);
+    S_put_varint(&s->records, node->as.code.fence_length);
+    S_put_varint(&s->records, node->as.code.fence_offset);
+    break;
+
+  case CMARK_NODE_LIST:
+  case CMARK_NODE_ITEM:
+    S_put_varint(&s->records, node->as.list.list_type);
+    S_put_varint(&s->records, node->as.list.delimiter);
+    S_put_varint(&s->records, (uint32_t)node->as.list.start);
+    S_put_varint(&s->records, node->as.list.tight);
+    S_put_varint(&s->records, node->as.list.bullet_char);
+    S_put_varint(&s->records, (uint32_t)node->as.list.marker_offset);
+    S_put_varint(&s->records, (uint32_t)node->as.list.padding);
+    break;
+
+  case CMARK_NODE_HEADING:
+    S_put_varint(&s->records, (uint32_t)node->as.heading.level);
+    S_put_varint(&s->records, node->as.heading.setext);
+    break;
+
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    S_put_string(s, &node->as.link.url);
+    S_put_string(s, &node->as.link.title);
+    break;
+
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    S_put_string(s, &node->as.custom.on_enter);
+    S_put_string(s, &node->as.custom.on_exit);
+    break;
+
+  default:
+    break;
+  }
+}
+
+char *cmark_node_serialize(cmark_node *root, size_t *len) {
+  cmark_mem *mem = cmark_node_mem(root);
+  serializer s = {CMARK_BUF_INIT(mem), CMARK_BUF_INIT(mem)};
+  unsigned char header[SERIALIZE_HEADER_SIZE];
+  uint32_t nodes = 0;
+  cmark_event_type ev_type;
+  cmark_iter *iter = cmark_iter_new(root);
+
+  // Reserve space for the header, which is filled in at the end.
+  memset(header, 0, sizeof(header));
+  cmark_strbuf_put(&s.records, header, SERIALIZE_HEADER_SIZE);
+
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    if (ev_type == CMARK_EVENT_ENTER) {
+      S_serialize_node(&s, cmark_iter_get_node(iter));
+      nodes++;
+    }
+  }
+  cmark_iter_free(iter);
+
+  memcpy(header, SERIALIZE_MAGIC, 4);
+  header[4] = SERIALIZE_VERSION;
+  S_put_u32(header + 8, nodes);
+  S_put_u32(header + 12,
+            (uint32_t)(s.records.size - SERIALIZE_HEADER_SIZE));
+  memcpy(s.records.ptr, header, SERIALIZE_HEADER_SIZE);
+
+  cmark_strbuf_put(&s.records, s.strings.ptr, s.strings.size);
+  cmark_strbuf_free(&s.strings);
+
+  if (len) {
+    *len = (size_t)s.records.size;
+  }
+  return (char *)cmark_strbuf_detach(&s.records);
+}
+
+typedef struct {
+  cmark_mem *mem;
+  const unsigned char *pos;
+  const unsigned char *end;
+  const unsigned char *strings;
+  uint32_t strings_size;
+  bool copy;
+  bool error;
+} deserializer;
+
+static uint32_t S_get_varint(deserializer *d) {
+  uint32_t n = 0;
+  int shift = 0;
+
+  while (d->pos < d->end && shift < 35) {
+    unsigned char c = *d->pos++;
+    n |= (uint32_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return n;
+    }
+    shift += 7;
+  }
+  d->error = true;
+  return 0;
+}
+
+static int S_get_int(deserializer *d) {
+  uint32_t n = S_get_varint(d);
+  if (n > INT32_MAX) {
+    d->error = true;
+  }
+  return (int)n;
+}
+
+static void S_get_string(deserializer *d, cmark_chunk *c) {
+  uint32_t offset = S_get_varint(d);
+  uint32_t len = S_get_varint(d);
+
+  if (d->error || offset >= d->strings_size ||
+      len >= d->strings_size - offset || len >= INT32_MAX ||
+      d->strings[offset + len] != 0) {
+    d->error = true;
+    return;
+  }
+
+  if (len == 0) {
+    c->data = NULL;
+    c->len = 0;
+    c->alloc = 0;
+  } else if (d->copy) {
+    c->data = (unsigned char *)cmark_mem_calloc(d->mem, len + 1, 1);
+    memcpy(c->data, d->strings + offset, len);
+    c->len = (bufsize_t)len;
+    c->alloc = (bufsize_t)len + 1;
+  } else {
+    c->data = (unsigned char *)d->strings + offset;
+    c->len = (bufsize_t)len;
+    c->alloc = 0;
+  }
+}
+
+static cmark_node *S_deserialize_node(deserializer *d, uint32_t *children) {
+  uint32_t type = S_get_varint(d);
+  cmark_node *node;
+
+  if (d->error || type < CMARK_NODE_FIRST_BLOCK ||
+      type > CMARK_NODE_LAST_INLINE) {
+    d->error = true;
+    return NULL;
+  }
+
+  node = cmark_node_new_with_mem((cmark_node_type)type, d->mem);
+  *children = S_get_varint(d);
+  node->start_line = S_get_int(d);
+  node->start_column = S_get_int(d);
+  node->end_line = S_get_int(d);
+  node->end_column = S_get_int(d);
+
+  switch (node->type) {
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_HTML_BLOCK:
+    S_get_string(d, &node->as.literal);
+    break;
+
+  case CMARK_NODE_CODE_BLOCK:
+    S_get_string(d, &node->as.code.info);
+    S_get_string(d, &node->as.code.literal);
+    node->as.code.fenced = (int8_t)S_get_varint(d);
+    node->as.code.fence_char = (unsigned char)S_get_varint(d);
+    node->as.code.fence_length = (uint8_t)S_get_varint(d);
+    node->as.code.fence_offset = (uint8_t)S_get_varint(d);
+    break;
+
+  case CMARK_NODE_LIST:
+  case CMARK_NODE_ITEM:
+    node->as.list.list_type = (cmark_list_type)S_get_varint(d);
+    node->as.list.delimiter = (cmark_delim_type)S_get_varint(d);
+    node->as.list.start = S_get_int(d);
+    node->as.list.tight = S_get_varint(d) != 0;
+    node->as.list.bullet_char = (unsigned char)S_get_varint(d);
+    node->as.list.marker_offset = S_get_int(d);
+    node->as.list.padding = S_get_int(d);
+    break;
+
+  case CMARK_NODE_HEADING:
+    node->as.heading.level = S_get_int(d);
+    node->as.heading.setext = S_get_varint(d) != 0;
+    if (node->as.heading.level < 1 || node->as.heading.level > 6) {
+      d->error = true;
+    }
+    break;
+
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    S_get_string(d, &node->as.link.url);
+    S_get_string(d, &node->as.link.title);
+    break;
+
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    S_get_string(d, &node->as.custom.on_enter);
+    S_get_string(d, &node->as.custom.on_exit);
+    break;
+
+  default:
+    break;
+  }
+
+  return node;
+}
+
+static cmark_node *S_deserialize(const char *buffer, size_t len, bool copy) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  const unsigned char *buf = (const unsigned char *)buffer;
+  deserializer d;
+  uint32_t nodes, records_size, children, i;
+  cmark_node *root = NULL, *node;
+  // Open nodes and the number of children each one is still missing.
+  cmark_node **open = NULL;
+  uint32_t *missing = NULL;
+  size_t depth = 0, open_size = 0;
+
+  if (buf == NULL || len < SERIALIZE_HEADER_SIZE ||
+      memcmp(buf, SERIALIZE_MAGIC, 4) != 0 || buf[4] != SERIALIZE_VERSION) {
+    return NULL;
+  }
+
+  nodes = S_get_u32(buf + 8);
+  records_size = S_get_u32(buf + 12);
+  if (nodes == 0 || records_size > len - SERIALIZE_HEADER_SIZE ||
+      len - SERIALIZE_HEADER_SIZE - records_size > UINT32_MAX) {
+    return NULL;
+  }
+
+  d.mem = &DEFAULT_MEM_ALLOCATOR;
+  d.pos = buf + SERIALIZE_HEADER_SIZE;
+  d.end = d.pos + records_size;
+  d.strings = d.end;
+  d.strings_size = (uint32_t)(len - SERIALIZE_HEADER_SIZE - records_size);
+  d.copy = copy;
+  d.error = false;
+
+  for (i = 0; i < nodes && !d.error; i++) {
+    node = S_deserialize_node(&d, &children);
+    if (node == NULL) {
+      break;
+    } else if (d.error) {
+      cmark_node_free(node);
+      break;
+    }
+
+    if (root == NULL) {
+      root = node;
+    } else if (depth == 0 || !cmark_node_append_child(open[depth - 1], node)) {
+      cmark_node_free(node);
+      d.error = true;
+      break;
+    } else {
+      missing[depth - 1]--;
+    }
+
+    if (children > 0) {
+      if (depth == open_size) {
+        open_size = open_size ? 2 * open_size : 16;
+        open = (cmark_node **)cmark_mem_realloc(d.mem, open,
+                                                open_size * sizeof(*open));
+        missing = (uint32_t *)cmark_mem_realloc(d.mem, missing,
+                                             open_size * sizeof(*missing));
+      }
+      open[depth] = node;
+      missing[depth] = children;
+      depth++;
+    }
+
+    while (depth > 0 && missing[depth - 1] == 0) {
+      depth--;
+    }
+  }
+
+  d.mem->free(open);
+  d.mem->free(missing);
+
+  if (d.error || i < nodes || depth > 0 || d.pos != d.end) {
+    if (root) {
+      cmark_node_free(root);
+    }
+    return NULL;
+  }
+
+  return root;
+}
+
+cmark_node *cmark_node_deserialize(const char *buffer, size_t len) {
+  return S_deserialize(buffer, len, true);
+}
+
+cmark_node *cmark_node_deserialize_borrowed(const char *buffer, size_t len) {
+  return S_deserialize(buffer, len, false);
+}
@@ -0,0 +1,82 @@
+// clock_gettime and CLOCK_MONOTONIC are POSIX, and hidden by <time.h>
+// in strict C modes unless asked for.
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "config.h"
+#include "cmark.h"
+#include "node.h"
+#include "parser.h"
+#include "stats.h"
+
+// Statistics are kept by the document node (see cmark_document), so
+// that work done after the parser is gone, such as parsing lazy inlines
+// or rendering, is recorded with the rest.  Each place that records
+// something checks for a NULL pointer first, so they cost next to
+// nothing unless CMARK_OPT_STATS is given.
+
+uint64_t cmark_stats_now(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t)(count.QuadPart * 1000000000.0 / frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+  // Processor time, which is all plain C offers.
+  return (uint64_t)((double)clock() * (1000000000.0 / CLOCKS_PER_SEC));
+#endif
+}
+
+cmark_stats *cmark_stats_of(cmark_node *node) {
+  if (node == NULL)
+    return NULL;
+  while (node->parent)
+    node = node->parent;
+  return node->type == CMARK_NODE_DOCUMENT ? node->as.document.stats : NULL;
+}
+
+void cmark_stats_count_nodes(cmark_stats *stats, cmark_node *root) {
+  cmark_node *cur = root;
+
+  while (cur != NULL) {
+    stats->nodes[cur->type]++;
+    if (cur->first_child) {
+      cur = cur->first_child;
+      continue;
+    }
+    while (cur != root && cur->next == NULL)
+      cur = cur->parent;
+    cur = cur == root ? NULL : cur->next;
+  }
+}
+
+// Renderings parse lazy inlines as they go, which is recorded in
+// 'inline_ns'; measuring from the clock minus 'inline_ns' leaves it out.
+uint64_t cmark_stats_start_render(cmark_stats *stats) {
+  return cmark_stats_now() - stats->inline_ns;
+}
+
+void cmark_stats_add_render(cmark_stats *stats, uint64_t start,
+                            size_t bytes) {
+  stats->render_ns += cmark_stats_now() - stats->inline_ns - start;
+  stats->renders++;
+  stats->output_bytes += bytes;
+}
+
+const cmark_stats *cmark_parser_get_stats(cmark_parser *parser) {
+  return parser->stats;
+}
+
+const cmark_stats *cmark_node_get_stats(cmark_node *node) {
+  return cmark_stats_of(node);
+}
@@ -0,0 +1,34 @@
+#ifndef CMARK_STATS_H
+#define CMARK_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "cmark.h"
+
+// Returns the time of a monotonic clock in nanoseconds.
+uint64_t cmark_stats_now(void);
+
+// Returns the statistics of the document that 'node' belongs to, or
+// NULL if it has none.
+cmark_stats *cmark_stats_of(cmark_node *node);
+
+// Counts the nodes in the tree rooted at 'root' by type.
+void cmark_stats_count_nodes(cmark_stats *stats, cmark_node *root);
+
+// Returns the start of a rendering, to be passed to
+// cmark_stats_add_render.
+uint64_t cmark_stats_start_render(cmark_stats *stats);
+
+// Records a rendering that started at 'start' and produced 'bytes'.
+// Inlines parsed during the rendering are left out of its time.
+void cmark_stats_add_render(cmark_stats *stats, uint64_t start, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,9 @@
 #include "node.h"
 #include "buffer.h"
 #include "houdini.h"
+#include "accounting.h"
+#include "stats.h"
+#include "limiter.h"
 
 #define BUFFER_SIZE 100
 
@@ -153,6 +156,11 @@ char *cmark_render_xml(cmark_node *root, int options) {
   cmark_event_type ev_type;
   cmark_node *cur;
   struct render_state state = {&xml, 0};
+  cmark_stats *stats = cmark_stats_of(root);
+  uint64_t start = stats ? cmark_stats_start_render(stats) : 0;
+  cmark_mem_phase phase =
+      cmark_mem_set_phase(cmark_node_mem(root), CMARK_MEM_RENDER);
+  size_t max_output = cmark_limiter_max_output(root);
 
   cmark_iter *iter = cmark_iter_new(root);
 
@@ -162,8 +170,18 @@ char *cmark_render_xml(cmark_node *root, int options) {
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
     S_render_node(cur, ev_type, &state, options);
+    if (max_output && (size_t)xml.size > max_output)
+      break;
+  }
+  if (stats)
+    cmark_stats_add_render(stats, start, xml.size);
+  cmark_mem_set_phase(cmark_node_mem(root), phase);
+  if (cmark_limiter_check_output(root, xml.size)) {
+    result = (char *)cmark_strbuf_detach(&xml);
+  } else {
+    cmark_strbuf_free(&xml);
+    result = NULL;
   }
-  result = (char *)cmark_strbuf_detach(&xml);
 
   cmark_iter_free(iter);
   return result;
@@ -18,6 +18,839 @@ subtest("spec tests (cmark)", function()
   end
 end)
 
+subtest("html render cache", function()
+  local cache = cmark.html_cache_new(3)
+  local md = "# Title\n\npara *one*\n\n- a\n- b\n\n[x]: /url\n\n[x]\n"
+  local doc = cmark.parse_string(md, cmark.OPT_DEFAULT)
+  local expected = cmark.render_html(doc, cmark.OPT_DEFAULT)
+  is(cmark.render_html_cached(doc, cmark.OPT_DEFAULT, cache), expected,
+     "first render matches render_html")
+  is(cmark.html_cache_get_misses(cache), 4, "all blocks missed")
+  is(cmark.html_cache_get_size(cache), 3, "size limited by capacity")
+  is(cmark.html_cache_get_evictions(cache), 1, "one eviction")
+  cmark.node_free(doc)
+
+  cmark.html_cache_set_capacity(cache, 10)
+  is(cmark.html_cache_get_capacity(cache), 10, "capacity updated")
+  doc = cmark.parse_string(md:gsub("one", "two"), cmark.OPT_DEFAULT)
+  expected = cmark.render_html(doc, cmark.OPT_DEFAULT)
+  is(cmark.render_html_cached(doc, cmark.OPT_DEFAULT, cache), expected,
+     "edited document matches render_html")
+  is(cmark.html_cache_get_hits(cache), 2, "unchanged blocks hit")
+  is(cmark.render_html_cached(doc, cmark.OPT_SOURCEPOS, cache),
+     cmark.render_html(doc, cmark.OPT_SOURCEPOS),
+     "rendering options are part of the key")
+  is(cmark.html_cache_get_hits(cache), 2, "no hits with other options")
+  cmark.node_free(doc)
+
+  is(cmark.html_cache_get_policy(cache), cmark.HTML_CACHE_LRU,
+     "LRU by default")
+  is(cmark.html_cache_set_policy(cache, cmark.HTML_CACHE_FIFO), 1,
+     "set FIFO policy")
+  cmark.html_cache_clear(cache)
+  is(cmark.html_cache_get_size(cache), 0, "clear empties the cache")
+  is(cmark.html_cache_get_hits(cache), 0, "clear resets counters")
+  cmark.html_cache_free(cache)
+end)
+
+subtest("node hash", function()
+  local doc1 = cmark.parse_string("> hi *there*\n\n> hi *there*\n", cmark.OPT_DEFAULT)
+  local doc2 = cmark.parse_string("> hi *there*\n\n> hi *there*\n", cmark.OPT_DEFAULT)
+  local h = cmark.node_hash(doc1)
+  like(h, "^%x+$", "hash is a hex string")
+  is(#h, 16, "hash has 64 bits")
+  is(cmark.node_hash(doc2), h, "equal documents have equal hashes")
+  local q1 = cmark.node_first_child(doc1)
+  local q2 = cmark.node_next(q1)
+  is(cmark.node_hash(q1), cmark.node_hash(q2), "duplicate blocks")
+  local text = cmark.node_first_child(cmark.node_first_child(q2))
+  cmark.node_set_literal(text, "bye ")
+  ok(cmark.node_hash(q1) ~= cmark.node_hash(q2), "setter invalidates block")
+  ok(cmark.node_hash(doc1) ~= h, "setter invalidates document")
+  cmark.node_set_literal(text, "hi ")
+  is(cmark.node_hash(doc1), h, "hash restored with content")
+  cmark.node_unlink(q2)
+  ok(cmark.node_hash(doc1) ~= h, "unlinking invalidates parent")
+  cmark.node_append_child(doc1, q2)
+  is(cmark.node_hash(doc1), h, "appending invalidates parent")
+  cmark.node_free(doc1)
+  cmark.node_free(doc2)
+end)
+
+subtest("serialization", function()
+  for _,test in ipairs(tests) do
+    local doc = cmark.parse_string(test.markdown, cmark.OPT_DEFAULT)
+    local data = cmark.node_serialize(doc)
+    local copy = cmark.node_deserialize(data, #data)
+    is(cmark.render_html(copy, cmark.OPT_SOURCEPOS),
+       cmark.render_html(doc, cmark.OPT_SOURCEPOS),
+       "round trip of example " .. tostring(test.example))
+    cmark.node_free(doc)
+    cmark.node_free(copy)
+  end
+  local doc = cmark.parse_string("# Hi\n\n- *a*\n", cmark.OPT_DEFAULT)
+  local data = cmark.node_serialize(doc)
+  is(data:sub(1, 4), "CMKB", "magic number")
+  is(cmark.node_deserialize("not a tree", 10), nil, "invalid input")
+  is(cmark.node_deserialize(data:sub(1, -2), #data - 1), nil,
+     "truncated input")
+  cmark.node_free(doc)
+end)
+
+subtest("parse_file", function()
+  local path = os.tmpname()
+  local function parses_like_string(input, description)
+    local f = assert(io.open(path, "wb"))
+    f:write(input)
+    f:close()
+    local doc = cmark.parse_file(path, cmark.OPT_DEFAULT)
+    local expected = cmark.parse_string(input, cmark.OPT_DEFAULT)
+    is(cmark.render_html(doc, cmark.OPT_SOURCEPOS),
+       cmark.render_html(expected, cmark.OPT_SOURCEPOS), description)
+    cmark.node_free(doc)
+    cmark.node_free(expected)
+  end
+  for _,test in ipairs(tests) do
+    parses_like_string(test.markdown, "example " .. tostring(test.example))
+  end
+  parses_like_string("", "empty file")
+  parses_like_string("# a\r\n\n```\r\ncode\r\n```\r\nend", "CRLF and no final newline")
+  os.remove(path)
+  local doc, msg = cmark.parse_file(path, cmark.OPT_DEFAULT)
+  is(doc, nil, "missing file")
+  like(msg, "could not read", "missing file message")
+end)
+
+subtest("parse_string_borrowed", function()
+  local function parses_like_string(input, opts, description)
+    -- Parsing the string again afterwards also checks that it has
+    -- been left as it was.
+    local doc = cmark.parse_string_borrowed(input, opts)
+    local expected = cmark.parse_string(input, opts)
+    is(cmark.render_html(doc, cmark.OPT_SOURCEPOS),
+       cmark.render_html(expected, cmark.OPT_SOURCEPOS), description)
+    cmark.node_free(doc)
+    cmark.node_free(expected)
+  end
+  for _,test in ipairs(tests) do
+    parses_like_string(test.markdown, cmark.OPT_DEFAULT,
+                       "example " .. tostring(test.example))
+    parses_like_string(test.markdown, cmark.OPT_LAZY_INLINES,
+                       "example " .. tostring(test.example) .. " (lazy)")
+  end
+  parses_like_string("", cmark.OPT_DEFAULT, "empty string")
+  parses_like_string("# a\r\n\n```\r\ncode\r\n```\r\nend", cmark.OPT_DEFAULT,
+                     "CRLF and no final newline")
+  local doc = cmark.parse_string_borrowed(
+    string.rep("para *graph*\n\n```\ncode\n```\n\n", 3), cmark.OPT_DEFAULT)
+  collectgarbage()
+  collectgarbage()
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT),
+     string.rep("<p>para <em>graph</em></p>\n<pre><code>code\n</code></pre>\n", 3),
+     "the document keeps its string")
+  cmark.node_free(doc)
+end)
+
+if pcall(require, 'ffi') then
+  subtest("ffi binding", function()
+    local cffi = require 'cmark.ffi'
+    local function types(walk, node)
+      local t = {}
+      for _, entering, node_type in walk(node) do
+        t[#t + 1] = (entering and "+" or "-") .. node_type
+      end
+      return table.concat(t, " ")
+    end
+    for _,test in ipairs(tests) do
+      local doc = cffi.parse_string(test.markdown, cffi.OPT_DEFAULT)
+      local expected = cmark.parse_string(test.markdown, cmark.OPT_DEFAULT)
+      is(cffi.render_html(doc, cffi.OPT_DEFAULT), test.html,
+         "example " .. tostring(test.example))
+      is(types(cffi.walk, doc), types(cmark.walk, expected),
+         "walk of example " .. tostring(test.example))
+      is(cffi.node_hash(doc), cmark.node_hash(expected),
+         "hash of example " .. tostring(test.example))
+      cffi.node_free(doc)
+      cmark.node_free(expected)
+    end
+    local doc = cffi.parse_string("# Hi\n\n[a](/u 't')\n", cffi.OPT_DEFAULT)
+    local heading = cffi.node_first_child(doc)
+    is(cffi.node_get_heading_level(heading), 1, "heading level")
+    is(cffi.node_get_type_string(heading), "heading", "type string")
+    local link = cffi.node_first_child(cffi.node_next(heading))
+    is(cffi.node_get_url(link), "/u", "url")
+    is(cffi.node_get_title(link), "t", "title")
+    is(cffi.node_next(link), nil, "NULL nodes are nil")
+    is(cffi.node_get_literal(link), nil, "NULL strings are nil")
+    cffi.node_free(doc)
+    doc = cffi.parse_string("*a* [b]\n\n[b]: /b\n", cffi.OPT_STATS)
+    local expected = cmark.parse_string("*a* [b]\n\n[b]: /b\n", cmark.OPT_STATS)
+    local stats, expected_stats = cffi.get_stats(doc), cmark.get_stats(expected)
+    is_deeply(stats.nodes, expected_stats.nodes, "stats nodes")
+    is(stats.references_looked_up, expected_stats.references_looked_up,
+       "stats counts")
+    cffi.node_free(doc)
+    cmark.node_free(expected)
+    local msg
+    doc, msg = cffi.parse_string_with_limits(string.rep("a\n\n", 20),
+                                             cffi.OPT_DEFAULT, {max_nodes = 10})
+    is(msg, "node limit exceeded", "node limit")
+    doc = cffi.parse_string_with_limits("> > > a\n", cffi.OPT_DEFAULT,
+                                        {max_depth = 1, max_output = 60})
+    is(cffi.render_html(doc, cffi.OPT_DEFAULT),
+       "<blockquote>\n<p>&gt; &gt; a</p>\n</blockquote>\n", "depth limit")
+    is(cffi.render_xml(doc, cffi.OPT_DEFAULT), nil, "output limit")
+    is(cffi.node_get_exceeded_limit(doc), cffi.LIMIT_OUTPUT, "exceeded limit")
+    cffi.node_free(doc)
+    local ffi = require 'ffi'
+    ffi.cdef[[
+    typedef struct cmark_mem_account cmark_mem_account;
+    cmark_mem_account *cmark_mem_account_new(size_t limit);
+    void cmark_mem_account_free(cmark_mem_account *account);
+    cmark_mem *cmark_mem_account_get_mem(cmark_mem_account *account);
+    ]]
+    local lib = ffi.load(package.searchpath('cmark', package.cpath))
+    local account = lib.cmark_mem_account_new(0)
+    local parser = cffi.parser_new_with_mem(cffi.OPT_DEFAULT,
+                                            lib.cmark_mem_account_get_mem(account))
+    cffi.parser_feed(parser, "*a* b\n", 6)
+    doc = cffi.parser_finish(parser)
+    cffi.parser_free(parser)
+    is(cffi.render_html(doc, cffi.OPT_DEFAULT), "<p><em>a</em> b</p>\n",
+       "rendering in a memory account")
+    is(cffi.render_plaintext(doc, cffi.OPT_DEFAULT), "a b",
+       "plain text in a memory account")
+    local data = cffi.node_serialize(doc)
+    local copy = cmark.node_deserialize(data, #data)
+    is(cmark.render_html(copy, cmark.OPT_DEFAULT), "<p><em>a</em> b</p>\n",
+       "serializing in a memory account")
+    cmark.node_free(copy)
+    is(#cffi.select(doc, cffi.NODE_TEXT), 2, "selecting in a memory account")
+    cffi.node_free(doc)
+    lib.cmark_mem_account_free(account)
+  end)
+end
+
+subtest("html streaming", function()
+  local function stream(input, opts)
+    local chunks = {}
+    cmark.markdown_to_html_stream(input, opts, function(html)
+      chunks[#chunks + 1] = html
+    end)
+    return chunks
+  end
+  for _,test in ipairs(tests) do
+    local doc = cmark.parse_string(test.markdown, cmark.OPT_NORMALIZE)
+    is(table.concat(stream(test.markdown, cmark.OPT_NORMALIZE)),
+       cmark.render_html(doc, cmark.OPT_DEFAULT),
+       "example " .. tostring(test.example))
+    cmark.node_free(doc)
+  end
+  local chunks = stream("# a\n\npara\n\n- x\n- y\n")
+  is(#chunks, 3, "one chunk per top-level block")
+  is(chunks[1], "<h1>a</h1>\n", "first chunk")
+  is(table.concat(stream("[foo]\n\nbar\n\n[foo]: /u\n")),
+     '<p><a href="/u">foo</a></p>\n<p>bar</p>\n',
+     "blocks wait for later references")
+  is(table.concat(stream("[foo]\n\n[foo]: /u\n", cmark.OPT_REFERENCES_FIRST)),
+     "<p>[foo]</p>\n", "references must precede use")
+  local ok, msg = pcall(cmark.markdown_to_html_stream, "a\n\nb\n", 0,
+                        function() error("boom") end)
+  is(ok, false, "callback errors are raised")
+  like(msg, "boom", "callback error message")
+end)
+
+subtest("lazy inlines", function()
+  local lazy = cmark.OPT_LAZY_INLINES + cmark.OPT_NORMALIZE
+  for _,test in ipairs(tests) do
+    local doc = cmark.parse_string(test.markdown, lazy)
+    local expected = cmark.parse_string(test.markdown, cmark.OPT_NORMALIZE)
+    is(cmark.render_html(doc, cmark.OPT_DEFAULT),
+       cmark.render_html(expected, cmark.OPT_DEFAULT),
+       "example " .. tostring(test.example))
+    cmark.node_free(doc)
+    cmark.node_free(expected)
+  end
+  local doc = cmark.parse_string("# *a*\n\n[b]\n\n[b]: /u\n", lazy)
+  local heading = cmark.node_first_child(doc)
+  is(cmark.node_get_type(cmark.node_first_child(heading)), cmark.NODE_EMPH,
+     "first_child parses inlines")
+  local para = cmark.node_next(heading)
+  local other = cmark.node_new(cmark.NODE_DOCUMENT)
+  cmark.node_append_child(other, para)
+  is(cmark.render_html(other, cmark.OPT_DEFAULT),
+     '<p><a href="/u">b</a></p>\n',
+     "moved blocks keep the references of their document")
+  cmark.node_free(other)
+  cmark.node_free(doc)
+end)
+
+subtest("outline", function()
+  local outline = cmark.extract_outline(
+    "# Hello *World*\n\n> ## Quote [link][r]\n\nSetext\n---\n\n" ..
+    "# Hello World!\n\n[r]: /u\n")
+  is(#outline, 4, "number of headings")
+  is(outline[1].level, 1, "level")
+  is(outline[1].text, "Hello World", "plain text")
+  is(outline[1].slug, "hello-world", "slug")
+  is(outline[1].start_line, 1, "start line")
+  is(outline[2].text, "Quote link", "nested heading, forward reference")
+  is(outline[3].slug, "setext", "setext heading")
+  is(outline[3].start_line, 5, "setext start line")
+  is(outline[4].slug, "hello-world-1", "duplicate slug")
+  is(cmark.extract_outline("# [x]\n\n[x]: /u\n",
+                           cmark.OPT_LAZY_INLINES)[1].text, "x",
+     "references with lazy inlines")
+  local slugs = {}
+  for i, heading in ipairs(cmark.extract_outline("# a\n# a\n# a-1\n# A\n")) do
+    slugs[i] = heading.slug
+  end
+  is(table.concat(slugs, " "), "a a-1 a-1-1 a-2", "suffixes are unique")
+  for _,test in ipairs(tests) do
+    local expected = {}
+    local doc = cmark.parse_string(test.markdown, cmark.OPT_DEFAULT)
+    for cur, entering, node_type in cmark.walk(doc) do
+      if entering and node_type == cmark.NODE_HEADING then
+        expected[#expected + 1] = cmark.node_get_start_line(cur)
+      end
+    end
+    cmark.node_free(doc)
+    local lines = {}
+    for i, heading in ipairs(cmark.extract_outline(test.markdown)) do
+      lines[i] = heading.start_line
+    end
+    is(table.concat(lines, ","), table.concat(expected, ","),
+       "example " .. tostring(test.example))
+  end
+end)
+
+subtest("renderers leave the tree alone", function()
+  local doc = cmark.parse_string("[http://a_b](http://a_b)\n",
+                                 cmark.OPT_DEFAULT)
+  local link = cmark.node_first_child(cmark.node_first_child(doc))
+  local hash = cmark.node_hash(doc)
+  is(cmark.render_commonmark(doc, cmark.OPT_DEFAULT, 0), "<http://a_b>\n",
+     "autolink split over several text nodes")
+  cmark.render_latex(doc, cmark.OPT_DEFAULT, 0)
+  cmark.render_man(doc, cmark.OPT_DEFAULT, 0)
+  is(cmark.node_hash(doc), hash, "hash unchanged")
+  is(cmark.node_get_literal(cmark.node_first_child(link)), "http://a",
+     "text nodes not consolidated")
+  cmark.node_free(doc)
+end)
+
+subtest("many reference definitions", function()
+  local defs = {}
+  for i = 1, 1000 do
+    defs[i] = string.format("[ref%d]: /url%d\n", i, i)
+  end
+  local doc = cmark.parse_string(table.concat(defs) ..
+                                 "[REF1]: /dup\ntext [ref1] [ref1000] [ref1001]\n",
+                                 cmark.OPT_DEFAULT)
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT),
+     '<p>text <a href="/url1">ref1</a> <a href="/url1000">ref1000</a>' ..
+     ' [ref1001]</p>\n', "definitions dropped, first one wins")
+  cmark.node_free(doc)
+end)
+
+subtest("json", function()
+  local doc = cmark.parse_string(
+    "# Hi\n\n2) [a \"q\"](/u 't')\n\n```lua\nx\ty\1\\\n```\n",
+    cmark.OPT_DEFAULT)
+  is(cmark.render_json(doc, cmark.OPT_DEFAULT),
+     '{"type":"document","children":[' ..
+     '{"type":"heading","level":1,"children":[' ..
+     '{"type":"text","literal":"Hi"}]},' ..
+     '{"type":"list","list_type":"ordered","start":2,"delim":"paren",' ..
+     '"tight":true,"children":[{"type":"item","children":[' ..
+     '{"type":"paragraph","children":[' ..
+     '{"type":"link","destination":"/u","title":"t","children":[' ..
+     '{"type":"text","literal":"a \\"q\\""}]}]}]}]},' ..
+     '{"type":"code_block","info":"lua","literal":"x\\ty\\u0001\\\\\\n"}]}\n',
+     "render_json")
+  like(cmark.render_json(cmark.node_first_child(doc), cmark.OPT_SOURCEPOS),
+       '^{"type":"heading","sourcepos":%[1,1,1,4%],', "sourcepos")
+  cmark.node_free(doc)
+  doc = cmark.parse_string(string.rep("*a* `b`\n\n", 5000), cmark.OPT_DEFAULT)
+  local pieces = {}
+  cmark.render_json_stream(doc, cmark.OPT_DEFAULT, function(s)
+    pieces[#pieces + 1] = s
+  end)
+  ok(#pieces > 1, "output comes in pieces")
+  is(table.concat(pieces), cmark.render_json(doc, cmark.OPT_DEFAULT),
+     "render_json_stream")
+  cmark.node_free(doc)
+end)
+
+subtest("plaintext", function()
+  local doc = cmark.parse_string(
+    "# A *b*\n\n> para [link](/url \"t\") <span>x</span>\n> ![img](/i)\n" ..
+    "\n<div>\nhtml\n</div>\n\n```\ncode\n```\n",
+    cmark.OPT_DEFAULT)
+  is(cmark.render_plaintext(doc), "A b\n\npara link x img\n\ncode",
+     "text only, blank lines between blocks")
+  local text, anchors = cmark.render_plaintext(doc, cmark.OPT_HARDBREAKS,
+                                               " | ", true)
+  is(text, "A b | para link x\nimg | code", "separator and options")
+  is(#anchors, 3, "one anchor per block with text")
+  is(anchors[2].offset, 6, "anchor offset")
+  is(anchors[2].line, 3, "anchor line")
+  is(text:sub(anchors[3].offset + 1), "code", "offset of code block")
+  is(anchors[3].line, 10, "line of code block")
+  cmark.node_free(doc)
+  doc = cmark.parse_string(string.rep("word ", 10000), cmark.OPT_DEFAULT)
+  is(cmark.render_plaintext(doc), string.rep("word ", 9999) .. "word",
+     "long text")
+  cmark.node_free(doc)
+end)
+
+subtest("html hooks", function()
+  local doc = cmark.parse_string("# Title\n\nSee [x](/u) and ![*a*](/i).\n",
+                                 cmark.OPT_DEFAULT)
+  local calls = 0
+  local html = cmark.render_html_with_hooks(doc, cmark.OPT_DEFAULT, {
+    [cmark.NODE_LINK] = function(node, entering)
+      if entering then
+        return '<a class="ext" href="' .. cmark.node_get_url(node) .. '">'
+      end
+      return "</a>"
+    end,
+    [cmark.NODE_HEADING] = function(_, entering)
+      return entering and "<h1>Heading</h1>\n" or nil, true
+    end,
+    [cmark.NODE_EMPH] = function()
+      calls = calls + 1
+    end,
+  })
+  is(html, '<h1>Heading</h1>\n<p>See <a class="ext" href="/u">x</a> and ' ..
+     '<img src="/i" alt="a" />.</p>\n', "hooks replace and skip")
+  is(calls, 0, "no hooks for image descriptions")
+  is(cmark.render_html_with_hooks(doc, cmark.OPT_DEFAULT, {}),
+     cmark.render_html(doc, cmark.OPT_DEFAULT), "no hooks")
+  local ok, msg = pcall(cmark.render_html_with_hooks, doc, cmark.OPT_DEFAULT,
+                        { [cmark.NODE_TEXT] = function() error("boom") end })
+  is(ok, false, "hook errors are raised")
+  like(msg, "boom", "hook error message")
+  ok = pcall(cmark.render_html_with_hooks, doc, cmark.OPT_DEFAULT,
+             { link = function() end })
+  is(ok, false, "keys must be node types")
+  cmark.node_free(doc)
+end)
+
+subtest("walk", function()
+  local doc = cmark.parse_string("> a *b*\n\n---\n", cmark.OPT_DEFAULT)
+  local events = {}
+  local entered = {}
+  local same = true
+  for node, entering, node_type in cmark.walk(doc) do
+    events[#events + 1] = (entering and "+" or "-") ..
+      cmark.node_get_type_string(node)
+    is(node_type, cmark.node_get_type(node), "type of " .. events[#events])
+    if entering then
+      entered[node] = true
+    else
+      same = same and entered[node] == true
+    end
+  end
+  is(table.concat(events, " "),
+     "+document +block_quote +paragraph +text +emph +text -emph -paragraph " ..
+     "-block_quote +thematic_break -document", "events")
+  ok(same, "exit returns the userdata of the entry")
+  local n = 0
+  for _ = 1, 1000 do
+    for _ in cmark.walk(doc) do
+      n = n + 1
+      break
+    end
+  end
+  is(n, 1000, "breaking out of a walk")
+  collectgarbage()
+  cmark.node_free(doc)
+end)
+
+subtest("select", function()
+  local function walk_select(doc, types)
+    local nodes = {}
+    for node, entering, node_type in cmark.walk(doc) do
+      if entering and types[node_type] then
+        nodes[#nodes + 1] = node
+      end
+    end
+    return nodes
+  end
+  local types = { [cmark.NODE_LINK] = true, [cmark.NODE_IMAGE] = true,
+                  [cmark.NODE_CODE_BLOCK] = true }
+  for _,test in ipairs(tests) do
+    for _, opts in ipairs({ cmark.OPT_DEFAULT, cmark.OPT_NODE_INDEX,
+                            cmark.OPT_NODE_INDEX + cmark.OPT_LAZY_INLINES }) do
+      local doc = cmark.parse_string(test.markdown, opts)
+      local selected = cmark.select(doc, { cmark.NODE_LINK, cmark.NODE_IMAGE,
+                                           cmark.NODE_CODE_BLOCK })
+      is_deeply(selected, walk_select(doc, types),
+                "example " .. tostring(test.example) .. " with options " .. opts)
+      cmark.node_free(doc)
+    end
+  end
+
+  for _, opts in ipairs({ cmark.OPT_DEFAULT, cmark.OPT_NODE_INDEX }) do
+    local doc = cmark.parse_string("[a](/a) ![b](/b)\n\n> [c](/c)\n", opts)
+    local name = " with options " .. opts
+    is(#cmark.select(doc, cmark.NODE_LINK), 2, "single type" .. name)
+    is(#cmark.select(doc, { cmark.NODE_LINK, cmark.NODE_IMAGE }, 2), 2,
+       "at most max nodes" .. name)
+    is(#cmark.select(doc, cmark.NODE_HEADING), 0, "no match" .. name)
+    local quote = cmark.select(doc, cmark.NODE_BLOCK_QUOTE)[1]
+    is(#cmark.select(quote, cmark.NODE_LINK), 1, "subtree" .. name)
+    local link = cmark.node_new(cmark.NODE_LINK)
+    cmark.node_append_child(cmark.node_first_child(quote), link)
+    is(cmark.select(doc, cmark.NODE_LINK)[3], link, "added node" .. name)
+    cmark.node_free(quote)
+    is(#cmark.select(doc, cmark.NODE_LINK), 1, "removed nodes" .. name)
+    cmark.node_free(doc)
+  end
+
+  local doc = cmark.parse_string("a\n", cmark.OPT_DEFAULT)
+  local ok, msg = pcall(cmark.select, doc, { 99 })
+  is(ok, false, "invalid type")
+  like(msg, "invalid node type", "invalid type message")
+  cmark.node_free(doc)
+end)
+
+subtest("stats", function()
+  local function count_nodes(doc)
+    local counts = {}
+    for t = cmark.NODE_FIRST_BLOCK, cmark.NODE_LAST_INLINE do
+      counts[t] = 0
+    end
+    for _, entering, node_type in cmark.walk(doc) do
+      if entering then
+        counts[node_type] = counts[node_type] + 1
+      end
+    end
+    return counts
+  end
+  for _,test in ipairs(tests) do
+    for _, opts in ipairs({ cmark.OPT_STATS,
+                            cmark.OPT_STATS + cmark.OPT_LAZY_INLINES }) do
+      local doc = cmark.parse_string(test.markdown, opts)
+      local counts = count_nodes(doc)
+      is_deeply(cmark.get_stats(doc).nodes, counts,
+                "example " .. tostring(test.example) .. " with options " .. opts)
+      cmark.node_free(doc)
+    end
+  end
+
+  local doc = cmark.parse_string("[a]: /a\n\n*[a]* **b**\n", cmark.OPT_DEFAULT)
+  is(cmark.get_stats(doc), nil, "no stats without OPT_STATS")
+  cmark.node_free(doc)
+
+  doc = cmark.parse_string("[a]: /a\n\n*[a]* **b**\n", cmark.OPT_STATS)
+  local html = cmark.render_html(doc, cmark.OPT_DEFAULT)
+  local para = cmark.node_first_child(doc)
+  local stats = cmark.get_stats(para)
+  is(stats.lines, 3, "lines")
+  is(stats.references_defined, 1, "references defined")
+  is(stats.references_looked_up, 1, "references looked up")
+  is(stats.delimiters_pushed, 4, "delimiters pushed")
+  is(stats.renders, 1, "renders")
+  is(stats.output_bytes, #html, "output bytes")
+  ok(stats.block_time >= 0 and stats.inline_time >= stats.emphasis_time,
+     "times")
+  cmark.render_xml(para, cmark.OPT_DEFAULT)
+  is(cmark.get_stats(doc).renders, 2, "renders of a subtree")
+  cmark.node_free(doc)
+end)
+
+subtest("memory accounts", function()
+  local input = string.rep("Some *text* with [a link][l] and `code`.\n\n" ..
+                           "> - a\n>   b\n\n[l]: /url\n\n", 20)
+  local expected = cmark.render_html(cmark.parse_string(input,
+                                                        cmark.OPT_DEFAULT),
+                                     cmark.OPT_DEFAULT)
+  local account = cmark.mem_account_new(0)
+  local mem = cmark.mem_account_get_mem(account)
+  local doc = cmark.parse_string_with_mem(input, cmark.OPT_DEFAULT, mem)
+  is(cmark.node_get_mem(doc), mem, "nodes use the account")
+  local usage = cmark.mem_account_get_usage(account)
+  ok(usage.live > 0 and usage.peak >= usage.live, "live and peak")
+  ok(usage.parse.allocations > 0 and usage.inlines.allocations > 0,
+     "parse and inline allocations")
+  is(usage.render.allocations, 0, "nothing rendered yet")
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT), expected, "render")
+  is(cmark.node_deserialize(cmark.node_serialize(doc), 0), nil, "serialize")
+  is(#cmark.select(doc, cmark.NODE_LINK), 20, "select")
+  usage = cmark.mem_account_get_usage(account)
+  ok(usage.render.allocations + usage.render.reallocations > 0,
+     "render allocations")
+  cmark.node_free(doc)
+  usage = cmark.mem_account_get_usage(account)
+  is(usage.live, 0, "everything freed")
+  is(usage.exceeded, false, "no limit")
+  cmark.mem_account_free(account)
+
+  local limit = 1024
+  repeat
+    account = cmark.mem_account_new(limit)
+    local msg
+    doc, msg = cmark.parse_string_with_mem(input, cmark.OPT_STATS,
+                                           cmark.mem_account_get_mem(account))
+    usage = cmark.mem_account_get_usage(account)
+    if doc then
+      is(cmark.render_html(doc, cmark.OPT_DEFAULT), expected,
+         "parsed within " .. limit .. " bytes")
+      cmark.node_free(doc)
+    else
+      is(msg, "memory limit exceeded", "refused at " .. limit .. " bytes")
+      ok(usage.exceeded and usage.peak <= limit,
+         "limit of " .. limit .. " bytes kept")
+    end
+    is(cmark.mem_account_get_usage(account).live, 0,
+       "nothing left at " .. limit .. " bytes")
+    cmark.mem_account_free(account)
+    limit = math.floor(limit * 1.5)
+  until doc
+
+  account = cmark.mem_account_new(200000)
+  mem = cmark.mem_account_get_mem(account)
+  local other = cmark.parse_string_with_mem("# Kept\n", cmark.OPT_DEFAULT, mem)
+  local a = cmark.parser_new_with_mem(cmark.OPT_DEFAULT, mem)
+  local b = cmark.parser_new_with_mem(cmark.OPT_DEFAULT, mem)
+  cmark.parser_feed(a, "*a*\n", 4)
+  local big = string.rep("word ", 80000)
+  cmark.parser_feed(b, big, #big)
+  is(cmark.parser_finish(b), nil, "second parser refused")
+  doc = cmark.parser_finish(a)
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT), "<p><em>a</em></p>\n",
+     "first parser unaffected")
+  is(cmark.render_html(other, cmark.OPT_DEFAULT), "<h1>Kept</h1>\n",
+     "other document unaffected")
+  cmark.parser_free(b)
+  cmark.parser_free(a)
+  cmark.node_free(doc)
+  cmark.node_free(other)
+  is(cmark.mem_account_get_usage(account).live, 0, "shared account freed")
+  cmark.mem_account_free(account)
+
+  account = cmark.mem_account_new(0)
+  doc = cmark.parse_string_with_mem("a *b*\n", cmark.OPT_DEFAULT,
+                                    cmark.mem_account_get_mem(account))
+  for _ in cmark.walk(doc) do
+    break
+  end
+  cmark.node_free(doc)
+  cmark.mem_account_free(account)
+  collectgarbage()
+  ok(true, "walk left early, collected after the account is freed")
+
+  account = cmark.mem_account_new(0)
+  doc = cmark.parse_string_with_mem("a *b*\n", cmark.OPT_DEFAULT,
+                                    cmark.mem_account_get_mem(account))
+  cmark.mem_account_free(account)
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT), "<p>a <em>b</em></p>\n",
+     "account freed while a document is live")
+  cmark.node_free(doc)
+end)
+
+subtest("limits", function()
+  local function html(input, limits, opts)
+    local doc, msg = cmark.parse_string_with_limits(input,
+                                                    opts or cmark.OPT_DEFAULT,
+                                                    limits)
+    if not doc then
+      return nil, msg
+    end
+    local result = cmark.render_html(doc, cmark.OPT_DEFAULT)
+    cmark.node_free(doc)
+    return result
+  end
+
+  is(html(string.rep("> ", 10) .. "a\n", {max_depth = 2}),
+     "<blockquote>\n<blockquote>\n" ..
+     "<p>&gt; &gt; &gt; &gt; &gt; &gt; &gt; &gt; a</p>\n" ..
+     "</blockquote>\n</blockquote>\n", "block quotes past the depth limit")
+  is(html("- a\n  - b\n    - c\n", {max_depth = 4}),
+     "<ul>\n<li>a\n<ul>\n<li>b\n- c</li>\n</ul>\n</li>\n</ul>\n",
+     "list items past the depth limit")
+  is(html("> a\n\n- b\n", {max_depth = 2}),
+     "<blockquote>\n<p>a</p>\n</blockquote>\n<ul>\n<li>b</li>\n</ul>\n",
+     "within the depth limit")
+  is(html("*a* _b_ [c](/d) *e* [f]\n", {max_delimiters = 5}),
+     "<p><em>a</em> <em>b</em> <a href=\"/d\">c</a> *e* [f]</p>\n",
+     "delimiters past the limit are text")
+  is(html("*a* [b]\n\n*c*\n", {max_delimiters = 1}),
+     "<p>*a* [b]</p>\n<p>*c*</p>\n", "the limit is per subject")
+
+  local input = string.rep("Some *text* with [a link](/u).\n\n", 50)
+  local expected = cmark.render_html(cmark.parse_string(input,
+                                                        cmark.OPT_DEFAULT),
+                                     cmark.OPT_DEFAULT)
+  is(html(input, {max_depth = 10, max_nodes = 1000, max_delimiters = 10,
+                  max_output = 10000, max_time = 60}),
+     expected, "within all limits")
+  is(select(2, html(input, {max_nodes = 100})), "node limit exceeded",
+     "node limit")
+  is(select(2, html(string.rep("*a* ", 1000), {max_nodes = 100})),
+     "node limit exceeded", "node limit in inlines")
+  is(select(2, html(string.rep("a\n", 1000), {max_time = 1e-9})),
+     "time limit exceeded", "time limit")
+  local parser = cmark.parser_new(cmark.OPT_DEFAULT)
+  cmark.parser_set_limits(parser, {max_nodes = 100})
+  is(cmark.parser_get_exceeded_limit(parser), cmark.LIMIT_NONE, "no limit yet")
+  for _ = 1, 100 do
+    cmark.parser_feed(parser, "a\n\n", 3)
+  end
+  is(cmark.parser_finish(parser), nil, "feeding past the node limit")
+  is(cmark.parser_get_exceeded_limit(parser), cmark.LIMIT_NODES,
+     "exceeded limit")
+  cmark.parser_free(parser)
+
+  parser = cmark.parser_new(cmark.OPT_DEFAULT)
+  cmark.parser_set_limits(parser, {max_nodes = 100})
+  cmark.parser_feed(parser, "a\n", 2)
+  cmark.node_free(cmark.parser_finish(parser))
+  is(cmark.parser_get_exceeded_limit(parser), cmark.LIMIT_NONE,
+     "exceeded limit after the document is freed")
+  cmark.parser_set_limits(parser, {max_nodes = 10})
+  cmark.parser_free(parser)
+
+  local doc = cmark.parse_string_with_limits(
+    string.rep("*a* ", 20) .. "\n\n*b*\n", cmark.OPT_LAZY_INLINES,
+    {max_nodes = 10})
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT),
+     "<p><em>a</em> <em>a</em> " .. string.rep("*a* ", 17) .. "*a*</p>\n" ..
+     "<p>*b*</p>\n", "lazy inlines stop at the node limit")
+  is(cmark.node_get_exceeded_limit(doc), cmark.LIMIT_NODES,
+     "lazy inlines exceeded limit")
+  cmark.node_free(doc)
+
+  doc = cmark.parse_string_with_limits(input, cmark.OPT_DEFAULT,
+                                       {max_output = 1000})
+  is(cmark.node_get_exceeded_limit(doc), cmark.LIMIT_NONE, "parsed")
+  is(cmark.render_html(doc, cmark.OPT_DEFAULT), nil, "html output limit")
+  is(cmark.node_get_exceeded_limit(doc), cmark.LIMIT_OUTPUT,
+     "output limit exceeded")
+  is(cmark.render_xml(doc, cmark.OPT_DEFAULT), nil, "xml output limit")
+  is(cmark.render_json(doc, cmark.OPT_DEFAULT), nil, "json output limit")
+  is(cmark.render_latex(doc, cmark.OPT_DEFAULT, 0), nil, "latex output limit")
+  is(select(2, cmark.render_plaintext(doc, cmark.OPT_DEFAULT)),
+     "output limit exceeded", "plaintext output limit")
+  local pieces = 0
+  is(select(2, cmark.render_json_stream(doc, cmark.OPT_DEFAULT, function()
+    pieces = pieces + 1
+  end)), "output limit exceeded", "json stream output limit")
+  local cache = cmark.html_cache_new(16)
+  is(cmark.render_html_cached(doc, cmark.OPT_DEFAULT, cache), nil,
+     "cached output limit")
+  is(cmark.render_html(cmark.node_first_child(doc), cmark.OPT_DEFAULT),
+     "<p>Some <em>text</em> with <a href=\"/u\">a link</a>.</p>\n",
+     "rendering a block within the limit")
+  cmark.html_cache_free(cache)
+  cmark.node_free(doc)
+end)
+
+subtest("node identity", function()
+  local doc = cmark.parse_string("# a\n\nb *c*\n", cmark.OPT_DEFAULT)
+  local heading = cmark.node_first_child(doc)
+  is(cmark.node_first_child(doc), heading, "same userdata on each access")
+  is(cmark.node_parent(heading), doc, "parent is the document")
+  is(cmark.node_previous(cmark.node_next(heading)), heading, "siblings")
+  local seen = {}
+  for node in cmark.walk(doc) do
+    seen[node] = true
+  end
+  ok(seen[heading], "nodes can be table keys")
+  local iter = cmark.iter_new(doc)
+  cmark.iter_next(iter)
+  is(cmark.iter_get_node(iter), doc, "iterator returns the same userdata")
+  cmark.iter_free(iter)
+  is(cmark.node_next(cmark.node_last_child(doc)), nil, "nil for no node")
+  cmark.node_free(doc)
+  local freed = {}
+  local fresh = true
+  for _ = 1, 100 do
+    doc = cmark.parse_string("x\n", cmark.OPT_DEFAULT)
+    local nodes = {}
+    for node in cmark.walk(doc) do
+      fresh = fresh and not freed[node]
+      nodes[#nodes + 1] = node
+    end
+    for _, node in ipairs(nodes) do
+      freed[node] = true
+    end
+    cmark.node_free(doc)
+  end
+  ok(fresh, "no userdata of freed nodes for new ones")
+end)
+
+subtest("to_table", function()
+  local leaves = {}
+  for _, t in ipairs({"CODE_BLOCK", "HTML_BLOCK", "THEMATIC_BREAK", "TEXT",
+                      "SOFTBREAK", "LINEBREAK", "CODE", "HTML_INLINE"}) do
+    leaves[cmark["NODE_" .. t]] = true
+  end
+  local function expected(node, opts)
+    local t = { type = cmark.node_get_type_string(node) }
+    local node_type = cmark.node_get_type(node)
+    if opts == cmark.OPT_SOURCEPOS and cmark.node_get_start_line(node) ~= 0 then
+      t.sourcepos = { cmark.node_get_start_line(node),
+                      cmark.node_get_start_column(node),
+                      cmark.node_get_end_line(node),
+                      cmark.node_get_end_column(node) }
+    end
+    if node_type == cmark.NODE_LIST then
+      if cmark.node_get_list_type(node) == cmark.ORDERED_LIST then
+        t.list_type = "ordered"
+        t.start = cmark.node_get_list_start(node)
+        t.delim = cmark.node_get_list_delim(node) == cmark.PAREN_DELIM and
+                  "paren" or "period"
+      else
+        t.list_type = "bullet"
+      end
+      t.tight = cmark.node_get_list_tight(node) == 1
+    elseif node_type == cmark.NODE_HEADING then
+      t.level = cmark.node_get_heading_level(node)
+    elseif node_type == cmark.NODE_CODE_BLOCK then
+      t.info = cmark.node_get_fence_info(node)
+    elseif node_type == cmark.NODE_LINK or node_type == cmark.NODE_IMAGE then
+      t.destination = cmark.node_get_url(node)
+      t.title = cmark.node_get_title(node)
+    end
+    local literal = cmark.node_get_literal(node)
+    if literal then
+      t.literal = literal
+    end
+    if not leaves[node_type] then
+      local child = cmark.node_first_child(node)
+      t.children = {}
+      while child do
+        t.children[#t.children + 1] = expected(child, opts)
+        child = cmark.node_next(child)
+      end
+    end
+    return t
+  end
+  for _,test in ipairs(tests) do
+    local doc = cmark.parse_string(test.markdown, cmark.OPT_DEFAULT)
+    is_deeply(cmark.to_table(doc, cmark.OPT_SOURCEPOS),
+              expected(doc, cmark.OPT_SOURCEPOS),
+              "example " .. tostring(test.example))
+    cmark.node_free(doc)
+  end
+  local doc = cmark.parse_string("1) *a*\n", cmark.OPT_DEFAULT)
+  is_deeply(cmark.to_table(doc), {
+    type = "document", children = {
+      { type = "list", list_type = "ordered", start = 1, delim = "paren",
+        tight = true, children = {
+          { type = "item", children = {
+            { type = "paragraph", children = {
+              { type = "emph", children = {
+                { type = "text", literal = "a" } } } } } } } } } } },
+    "without source positions")
+  local item = cmark.node_first_child(cmark.node_first_child(doc))
+  is(cmark.to_table(item).type, "item", "subtrees")
+  cmark.node_free(doc)
+end)
+
 local b = builder
 
 local builds = function(node, expected, description)
@@ -124,4 +957,45 @@ builds(b.custom_inline{ on_enter = "{", on_exit = ".", "&" },
   '{&amp;.', "custom inline")
 
 
+builds(b.document{ "a", { b.thematic_break, { "b" } }, nil },
+  '<p>a</p>\n<hr />\n<p>b</p>\n', "nested tables and functions")
+
+builds(b.bullet_list{ b.code_block "x", b.emph "y" },
+  '<ul>\n<li>\n<pre><code>x</code></pre>\n</li>\n<li>\n<p><em>y</em></p>\n' ..
+  '</li>\n</ul>\n',
+  "blocks and inlines wrapped in items")
+
+returns_error(b.ordered_list, { delim = "-", "a" }, "Unknown delimiter -",
+  "bad delimiter")
+
+returns_error(b.code_block, { b.text "x" },
+   "Tried to add a node with class inline to a node with class block",
+   "node inside code block")
+
+returns_error(b.document, { b.item "x" },
+   "Tried to add a node with class item to a node with class block",
+   "item inside document")
+
+local ok, msg = pcall(b.document, { "a", b.bullet_list{ "b" },
+                                    function() error("no contents") end })
+is(ok, false, "error raised by contents")
+like(msg, "no contents", "error raised by contents message")
+local held = b.text "held"
+local wrapped = b.text "wrapped"
+is(b.paragraph{ held, b.item "x" }, nil, "failed build with a held child")
+is(b.document{ wrapped, b.item "x" }, nil,
+   "failed build with a held wrapped child")
+collectgarbage()
+is(cmark.node_get_literal(held), "held", "held child is left to the caller")
+is(cmark.node_parent(held), nil, "held child is detached")
+is(cmark.node_get_literal(wrapped), "wrapped",
+   "held wrapped child is left to the caller")
+is(cmark.node_parent(wrapped), nil, "held wrapped child is detached")
+builds(b.paragraph{ held, wrapped }, '<p>heldwrapped</p>\n',
+  "held children can be used again")
+
+builds(b.document{ "a", b.bullet_list{ "b" } },
+  '<p>a</p>\n<ul>\n<li>\n<p>b</p>\n</li>\n</ul>\n',
+  "builder after a raised error")
+
 done_testing()